@@ -0,0 +1,390 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "timeutils.h"
+#include "basebandprobe.h"
+
+const uint32_t Mark5BSyncWord = 0xABADDEED;
+const unsigned int Mark5BFrameBytes = 10016;	// 16 byte header + 10000 bytes of data
+
+// Cached or newly determined time range of one file
+class BasebandProbe
+{
+public:
+	BasebandProbe() : size(0), mtime(0), mjdStart(-1.0), mjdStop(-1.0) {}
+	bool isValid() const { return mjdStart >= 0.0; }
+
+	long long size;
+	long long mtime;	// nanoseconds since 1970
+	double mjdStart;	// negative if the time range could not be determined
+	double mjdStop;
+};
+
+static bool readWords(int fd, off_t offset, uint32_t *words, int nWord)
+{
+	return pread(fd, words, nWord*sizeof(uint32_t), offset) == static_cast<ssize_t>(nWord*sizeof(uint32_t));
+}
+
+static int bcd(uint32_t value, int nDigit)
+{
+	int v = 0;
+
+	for(int d = nDigit-1; d >= 0; --d)
+	{
+		v = 10*v + ((value >> (4*d)) & 0x0F);
+	}
+
+	return v;
+}
+
+// MJD of 1 January of the given year (Gregorian)
+static int yearToMJD(int year)
+{
+	int y = year - 1;
+
+	return 365*y + y/4 - y/100 + y/400 - 678575;
+}
+
+static bool isLeapYear(int year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+// Mark5B headers carry only the last 3 digits of MJD; take the most recent matching day
+static double mark5BTime(const uint32_t *header, int refMJD)
+{
+	int mjd1000 = bcd(header[2] >> 20, 3);
+	int sec = bcd(header[2] & 0x000FFFFF, 5);
+	int frac = bcd(header[3] >> 16, 4);	// units of 0.1 ms
+	int mjd = refMJD - ((refMJD - mjd1000) % 1000 + 1000) % 1000;
+
+	return mjd + (sec + frac*1.0e-4)/SEC_DAY;
+}
+
+// Whole seconds only: the frame number cannot be converted without the frame rate
+static double vdifTime(const uint32_t *header)
+{
+	int refEpoch = (header[1] >> 24) & 0x3F;	// half years since 2000
+	int year = 2000 + refEpoch/2;
+	int mjd = yearToMJD(year);
+
+	if(refEpoch % 2 == 1)
+	{
+		mjd += isLeapYear(year) ? 182 : 181;	// 1 July
+	}
+
+	return mjd + (header[0] & 0x3FFFFFFF)/SEC_DAY;
+}
+
+static bool isVDIFHeader(const uint32_t *header, const uint32_t *first)
+{
+	int version = (header[2] >> 29) & 0x07;
+
+	return version <= 1 && (header[2] & 0x00FFFFFF) == (first[2] & 0x00FFFFFF) && (header[1] >> 24) == (first[1] >> 24);
+}
+
+bool probeBasebandFile(const std::string &fileName, double *mjdStart, double *mjdStop)
+{
+	uint32_t first[4], last[4];
+	struct stat st;
+	off_t frameBytes, lastFrame;
+	bool ok = false;
+	int fd;
+
+	fd = open(fileName.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+	if(fstat(fd, &st) != 0 || !readWords(fd, 0, first, 4))
+	{
+		close(fd);
+
+		return false;
+	}
+
+	if(first[0] == Mark5BSyncWord)
+	{
+		frameBytes = Mark5BFrameBytes;
+		lastFrame = (st.st_size/frameBytes - 1)*frameBytes;
+		if(readWords(fd, lastFrame, last, 4) && last[0] == Mark5BSyncWord)
+		{
+			int refMJD = static_cast<int>(current_mjd());
+
+			*mjdStart = mark5BTime(first, refMJD);
+			*mjdStop = mark5BTime(last, refMJD);
+			ok = (*mjdStop >= *mjdStart);
+		}
+	}
+	else
+	{
+		frameBytes = 8*static_cast<off_t>(first[2] & 0x00FFFFFF);
+		if(frameBytes >= 32 && isVDIFHeader(first, first))
+		{
+			lastFrame = (st.st_size/frameBytes - 1)*frameBytes;
+			if(readWords(fd, lastFrame, last, 4) && isVDIFHeader(last, first))
+			{
+				*mjdStart = vdifTime(first);
+				*mjdStop = vdifTime(last) + 1.0/SEC_DAY;	// the last frame is somewhere within that second
+				ok = (*mjdStop > *mjdStart && *mjdStop - *mjdStart < 1.0);
+			}
+		}
+	}
+
+	close(fd);
+
+	return ok;
+}
+
+static void loadProbeCache(std::map<std::string,BasebandProbe> &cache, const std::string &cacheFile)
+{
+	std::ifstream is(cacheFile.c_str());
+	std::string line;
+
+	while(std::getline(is, line))
+	{
+		std::stringstream ss(line);
+		std::string fileName;
+		BasebandProbe p;
+
+		ss >> fileName >> p.size >> p.mtime >> p.mjdStart >> p.mjdStop;
+		if(!ss.fail())
+		{
+			cache[fileName] = p;
+		}
+	}
+}
+
+// Written under a per-process temporary name and renamed so that a concurrent reader never sees a partial file
+// and concurrent runs never write into the same file
+static bool saveProbeCache(const std::map<std::string,BasebandProbe> &cache, const std::string &cacheFile)
+{
+	std::stringstream tmpFile;
+	std::ofstream os;
+
+	tmpFile << cacheFile << ".tmp." << getpid();
+	os.open(tmpFile.str().c_str());
+
+	if(!os.is_open())
+	{
+		return false;
+	}
+	os.precision(14);
+	for(std::map<std::string,BasebandProbe>::const_iterator it = cache.begin(); it != cache.end(); ++it)
+	{
+		os << it->first << " " << it->second.size << " " << it->second.mtime << " " << it->second.mjdStart << " " << it->second.mjdStop << std::endl;
+	}
+	os.close();
+	if(os.fail() || rename(tmpFile.str().c_str(), cacheFile.c_str()) != 0)
+	{
+		unlink(tmpFile.str().c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+class BasebandProbeTask
+{
+public:
+	std::string fileName;
+	BasebandProbe probe;
+};
+
+class BasebandProbeWork
+{
+public:
+	std::vector<BasebandProbeTask> *tasks;
+	unsigned int nextTask;
+	pthread_mutex_t lock;
+};
+
+static void *basebandProbeWorker(void *arg)
+{
+	BasebandProbeWork *work = static_cast<BasebandProbeWork *>(arg);
+
+	for(;;)
+	{
+		unsigned int t;
+
+		pthread_mutex_lock(&work->lock);
+		t = work->nextTask++;
+		pthread_mutex_unlock(&work->lock);
+
+		if(t >= work->tasks->size())
+		{
+			break;
+		}
+
+		BasebandProbeTask &task = (*work->tasks)[t];
+		if(!probeBasebandFile(task.fileName, &task.probe.mjdStart, &task.probe.mjdStop))
+		{
+			task.probe.mjdStart = task.probe.mjdStop = -1.0;
+		}
+	}
+
+	return 0;
+}
+
+// Reads are mostly waiting on the file system, so use more threads than CPUs.
+// Several filelists may be probed at once (one per preload worker), so the helper
+// threads of all concurrent calls share one process-wide budget.
+static const unsigned int MaxProbeHelpers = 64;
+static unsigned int nProbeHelpers = 0;	// helper threads currently running, over all calls
+
+static void runBasebandProbeTasks(std::vector<BasebandProbeTask> &tasks)
+{
+	const unsigned int MaxThreadsPerCPU = 4;
+	BasebandProbeWork work;
+	std::vector<pthread_t> threads;
+	unsigned int nThread;
+	long nCPU;
+
+	work.tasks = &tasks;
+	work.nextTask = 0;
+	pthread_mutex_init(&work.lock, 0);
+
+	nCPU = sysconf(_SC_NPROCESSORS_ONLN);
+	nThread = MaxThreadsPerCPU*((nCPU > 1) ? nCPU : 1);
+	if(nThread > tasks.size())
+	{
+		nThread = tasks.size();
+	}
+
+	// The calling thread is one of the workers; helpers are started only while the budget allows
+	for(unsigned int i = 1; i < nThread; ++i)
+	{
+		pthread_t thread;
+
+		if(__sync_add_and_fetch(&nProbeHelpers, 1) > MaxProbeHelpers)
+		{
+			__sync_fetch_and_sub(&nProbeHelpers, 1);
+
+			break;
+		}
+		if(pthread_create(&thread, 0, basebandProbeWorker, &work) != 0)
+		{
+			__sync_fetch_and_sub(&nProbeHelpers, 1);
+
+			break;
+		}
+		threads.push_back(thread);
+	}
+	basebandProbeWorker(&work);
+	for(std::vector<pthread_t>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		pthread_join(*it, 0);
+	}
+	__sync_fetch_and_sub(&nProbeHelpers, threads.size());
+
+	pthread_mutex_destroy(&work.lock);
+}
+
+int probeBasebandFiles(std::vector<VexBasebandData> &files, const std::vector<unsigned int> &ids, const std::string &cacheFile, bool updateCache)
+{
+	std::map<std::string,BasebandProbe> cache;
+	std::map<std::string,BasebandProbe> updated;	// only files still listed are kept in the cache
+	std::vector<BasebandProbeTask> tasks;
+	int nUnknown = 0;
+
+	loadProbeCache(cache, cacheFile);
+
+	for(std::vector<unsigned int>::const_iterator id = ids.begin(); id != ids.end(); ++id)
+	{
+		const std::string &fileName = files[*id].filename;
+		std::map<std::string,BasebandProbe>::const_iterator c;
+		BasebandProbeTask task;
+		struct stat st;
+
+		if(updated.find(fileName) != updated.end())
+		{
+			continue;
+		}
+		if(stat(fileName.c_str(), &st) != 0)
+		{
+			continue;
+		}
+		task.fileName = fileName;
+		task.probe.size = st.st_size;
+		task.probe.mtime = st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec;
+		c = cache.find(fileName);
+		if(c != cache.end() && c->second.size == task.probe.size && c->second.mtime == task.probe.mtime)
+		{
+			updated[fileName] = c->second;
+		}
+		else
+		{
+			updated[fileName] = task.probe;
+			tasks.push_back(task);
+		}
+	}
+
+	if(!tasks.empty())
+	{
+		runBasebandProbeTasks(tasks);
+		for(std::vector<BasebandProbeTask>::const_iterator t = tasks.begin(); t != tasks.end(); ++t)
+		{
+			updated[t->fileName] = t->probe;
+		}
+		if(updateCache && !saveProbeCache(updated, cacheFile))
+		{
+			std::cerr << "Warning: cannot write baseband file time cache " << cacheFile << std::endl;
+		}
+	}
+
+	for(std::vector<unsigned int>::const_iterator id = ids.begin(); id != ids.end(); ++id)
+	{
+		std::map<std::string,BasebandProbe>::const_iterator u = updated.find(files[*id].filename);
+
+		if(u != updated.end() && u->second.isValid())
+		{
+			files[*id].setTimeRange(u->second.mjdStart, u->second.mjdStop);
+		}
+		else
+		{
+			++nUnknown;
+		}
+	}
+
+	return nUnknown;
+}
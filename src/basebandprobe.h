@@ -0,0 +1,48 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#ifndef __BASEBANDPROBE_H__
+#define __BASEBANDPROBE_H__
+
+#include <string>
+#include <vector>
+#include "vex_basebanddata.h"
+
+// Determines the time range of a VDIF or Mark5B file from its first and last frame headers.
+// VDIF times are only good to the second, so the range is widened to whole seconds.
+// Returns true on success.
+bool probeBasebandFile(const std::string &fileName, double *mjdStart, double *mjdStop);
+
+// Fills in the time ranges of files[ids[i]] by probing them concurrently.  Results are kept
+// in cacheFile, keyed on file name, size and modification time, so unchanged files are only
+// read once; cacheFile is only rewritten if updateCache is set.  Returns the number of files
+// whose time range could not be determined.
+int probeBasebandFiles(std::vector<VexBasebandData> &files, const std::vector<unsigned int> &ids, const std::string &cacheFile, bool updateCache);
+
+#endif
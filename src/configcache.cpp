@@ -0,0 +1,157 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <sstream>
+#include "configcache.h"
+
+ConfigCache::ConfigCache() : hits(0), misses(0)
+{
+	pthread_mutex_init(&lock, 0);
+}
+
+ConfigCache::~ConfigCache()
+{
+	pthread_mutex_destroy(&lock);
+}
+
+// Names cannot contain the separator, so keys are unambiguous
+std::string ConfigCache::timingKey(const std::string &modeName, const std::string &corrSetupName, int nDataSegments)
+{
+	std::stringstream key;
+
+	key << modeName << '\n' << corrSetupName << '\n' << nDataSegments;
+
+	return key.str();
+}
+
+std::string ConfigCache::layoutKey(const std::string &modeName, const std::string &antName, unsigned int streamId)
+{
+	std::stringstream key;
+
+	key << modeName << '\n' << antName << '\n' << streamId;
+
+	return key.str();
+}
+
+const ConfigTiming *ConfigCache::findTiming(const std::string &modeName, const std::string &corrSetupName, int nDataSegments)
+{
+	std::string key = timingKey(modeName, corrSetupName, nDataSegments);
+	const ConfigTiming *timing = 0;
+
+	pthread_mutex_lock(&lock);
+	std::map<std::string,ConfigTiming>::const_iterator it = timings.find(key);
+	if(it != timings.end())
+	{
+		timing = &it->second;
+		++hits;
+	}
+	else
+	{
+		++misses;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return timing;
+}
+
+const DatastreamLayout *ConfigCache::findLayout(const std::string &modeName, const std::string &antName, unsigned int streamId)
+{
+	std::string key = layoutKey(modeName, antName, streamId);
+	const DatastreamLayout *layout = 0;
+
+	pthread_mutex_lock(&lock);
+	std::map<std::string,DatastreamLayout>::const_iterator it = layouts.find(key);
+	if(it != layouts.end())
+	{
+		layout = &it->second;
+		++hits;
+	}
+	else
+	{
+		++misses;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return layout;
+}
+
+const ConfigBaselines *ConfigCache::findBaselines(const std::string &key)
+{
+	const ConfigBaselines *baselines = 0;
+
+	pthread_mutex_lock(&lock);
+	std::map<std::string,ConfigBaselines>::const_iterator it = baselineSets.find(key);
+	if(it != baselineSets.end())
+	{
+		baselines = &it->second;
+		++hits;
+	}
+	else
+	{
+		++misses;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return baselines;
+}
+
+const ConfigTiming *ConfigCache::addTiming(const std::string &modeName, const std::string &corrSetupName, int nDataSegments, const ConfigTiming &timing)
+{
+	std::string key = timingKey(modeName, corrSetupName, nDataSegments);
+	const ConfigTiming *cached;
+
+	pthread_mutex_lock(&lock);
+	cached = &timings.insert(std::pair<std::string,ConfigTiming>(key, timing)).first->second;
+	pthread_mutex_unlock(&lock);
+
+	return cached;
+}
+
+const DatastreamLayout *ConfigCache::addLayout(const std::string &modeName, const std::string &antName, unsigned int streamId, const DatastreamLayout &layout)
+{
+	std::string key = layoutKey(modeName, antName, streamId);
+	const DatastreamLayout *cached;
+
+	pthread_mutex_lock(&lock);
+	cached = &layouts.insert(std::pair<std::string,DatastreamLayout>(key, layout)).first->second;
+	pthread_mutex_unlock(&lock);
+
+	return cached;
+}
+
+const ConfigBaselines *ConfigCache::addBaselines(const std::string &key, const ConfigBaselines &baselines)
+{
+	const ConfigBaselines *cached;
+
+	pthread_mutex_lock(&lock);
+	cached = &baselineSets.insert(std::pair<std::string,ConfigBaselines>(key, baselines)).first->second;
+	pthread_mutex_unlock(&lock);
+
+	return cached;
+}
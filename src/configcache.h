@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+/*
+This is a helper class used within vex2difx.cpp
+*/
+
+#ifndef __CONFIGCACHE_H__
+#define __CONFIGCACHE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+// Subint / integration time / guard selection for one (mode, correlator setup)
+class ConfigTiming
+{
+public:
+	int subintNS;
+	double tInt;
+	int guardNS;		// with a negative request already resolved
+	int nDataSegments;	// possibly reduced to keep data send sizes below 2^31 ns
+};
+
+// One present band of a datastream, described by value rather than by the job-specific frequency id
+class DatastreamBand
+{
+public:
+	double freq;		// Hz
+	double bandwidth;	// Hz
+	char sideBand;
+	bool extractTones;	// if false the trivial (no tone) tone set is used
+	std::vector<unsigned int> tones;
+	char pol;		// lower case if the band is to be ignored
+};
+
+// What setFormat() derives from the vex for one datastream of one antenna in one mode;
+// this does not depend on the correlator setup
+class DatastreamLayout
+{
+public:
+	std::string dataFormat;
+	int dataFrameSize;
+	int quantBits;
+	std::vector<DatastreamBand> bands;
+};
+
+// One baseline of a config, with its datastreams given by position in the config's datastream list.
+// The band numbers are local to the datastreams, so they hold for any job.
+class BaselinePattern
+{
+public:
+	int configDsA;
+	int configDsB;
+	std::vector<std::vector<int> > bandA;	// [freq][polarization product]
+	std::vector<std::vector<int> > bandB;
+};
+
+// The baselines populateBaselineTable() pairs up for one config
+class ConfigBaselines
+{
+public:
+	std::vector<BaselinePattern> baselines;
+	double globalBandwidth;	// common bandwidth of the correlated frequencies; 0 if none, -1 if they differ
+};
+
+// Memoizes the above across all jobs written by one run of vex2difx.
+// Entries are never removed or modified so returned pointers stay valid;
+// all members may be called concurrently.
+class ConfigCache
+{
+public:
+	ConfigCache();
+	~ConfigCache();
+
+	// These return 0 if there is no entry yet
+	const ConfigTiming *findTiming(const std::string &modeName, const std::string &corrSetupName, int nDataSegments);
+	const DatastreamLayout *findLayout(const std::string &modeName, const std::string &antName, unsigned int streamId);
+	const ConfigBaselines *findBaselines(const std::string &key);	// key is made by the caller
+
+	// These return the cached entry, which is the one already present if another thread got there first
+	const ConfigTiming *addTiming(const std::string &modeName, const std::string &corrSetupName, int nDataSegments, const ConfigTiming &timing);
+	const DatastreamLayout *addLayout(const std::string &modeName, const std::string &antName, unsigned int streamId, const DatastreamLayout &layout);
+	const ConfigBaselines *addBaselines(const std::string &key, const ConfigBaselines &baselines);
+
+	unsigned long nHit() const { return hits; }
+	unsigned long nMiss() const { return misses; }
+
+private:
+	ConfigCache(const ConfigCache &);
+	ConfigCache &operator = (const ConfigCache &);
+
+	static std::string timingKey(const std::string &modeName, const std::string &corrSetupName, int nDataSegments);
+	static std::string layoutKey(const std::string &modeName, const std::string &antName, unsigned int streamId);
+
+	std::map<std::string,ConfigTiming> timings;
+	std::map<std::string,DatastreamLayout> layouts;
+	std::map<std::string,ConfigBaselines> baselineSets;
+	unsigned long hits;
+	unsigned long misses;
+	pthread_mutex_t lock;
+};
+
+#endif
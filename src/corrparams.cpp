@@ -39,6 +39,7 @@
 #include <ctime>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <difxio.h>
 #include <vexdatamodel.h>
 #include <dirlist/dirlist.h>
@@ -48,13 +49,38 @@
 #include "timeutils.h"
 #include "corrparams.h"
 #include "parserhelp.h"
+#include "basebandprobe.h"
+#include "filelistcache.h"
 
 const double PhaseCentre::DEFAULT_RA  = -999.9;
 const double PhaseCentre::DEFAULT_DEC = -999.9;
 
-int loadBasebandFilelistOld(const std::string &fileName, std::vector<VexBasebandData> &basebandFiles)
+// The outcome of reading one filelist= file.  Messages are kept so that they can be
+// reported when the filelist is used, in .v2d file order, even if it was read ahead
+// of time by another thread.
+class FilelistLoad
+{
+public:
+	FilelistLoad() : ok(false), fatal(false), missingTimes(false) {}
+
+	std::vector<VexBasebandData> files;
+	std::stringstream out;	// messages for stdout
+	std::stringstream err;	// messages for stderr
+	bool ok;		// false if the filelist could not be read
+	bool fatal;		// if true, vex2difx must stop after reporting the messages
+	bool missingTimes;	// some files have no start/stop times
+};
+
+static bool hasNoTimes(const VexBasebandData &file)
+{
+	const VexBasebandData untimed("", 0, -1);
+
+	return file.mjdStart == untimed.mjdStart && file.mjdStop == untimed.mjdStop;
+}
+
+// Returns the number of files, or -1 on error
+static int loadBasebandFilelistOld(const std::string &fileName, std::vector<VexBasebandData> &basebandFiles, std::ostream &err)
 {
-	static bool first = true;
 	const int MaxLineLength=1024;
 	std::ifstream is;
 	int n=0;
@@ -65,9 +91,9 @@ int loadBasebandFilelistOld(const std::string &fileName, std::vector<VexBaseband
 
 	if(is.fail())
 	{
-		std::cerr << "Error: cannot open " << fileName << std::endl;
+		err << "Error: cannot open " << fileName << std::endl;
 
-		exit(EXIT_FAILURE);
+		return -1;
 	}
 
 	for(unsigned int line = 1; ; ++line)
@@ -110,28 +136,17 @@ int loadBasebandFilelistOld(const std::string &fileName, std::vector<VexBaseband
 		}
 		else
 		{
-			std::cerr << "Error: line " << line << " of file " << fileName << " is badly formatted" << std::endl;
+			err << "Error: line " << line << " of file " << fileName << " is badly formatted" << std::endl;
 
-			exit(EXIT_FAILURE);
-		}
-	}
-
-	if(n > 0)
-	{
-		std::cout << "Warning: Filelist file " << fileName << " was a listing with no start/stop times." << std::endl;
-		if(first)
-		{
-			first = false;
-
-			std::cout << "Note: Future versions of vex2difx may stop allowing file lists without start/stop times.  Filelists for VDIF and Mark5B files with start/stop times can be generated with \"vsum -s\" and \"m5bsum -s\" respectively.  These times allow vex2difx to properly assign data to jobs and is especially important in cases where multiple jobs are generated per project." << std::endl;
+			return -1;
 		}
 	}
 
 	return n;
 }
 
-// Returns true on success
-bool loadBasebandFilelist(const std::string &fileName, std::vector<VexBasebandData> &basebandFiles)
+// Parses the filelist in whichever format it is in; returns true on success
+static bool parseBasebandFilelist(const std::string &fileName, FilelistLoad &L)
 {
 	DirList D;
 	std::stringstream error;
@@ -147,7 +162,7 @@ bool loadBasebandFilelist(const std::string &fileName, std::vector<VexBasebandDa
 	{
 		if(e.getType() == DirListException::TypeCantOpen)
 		{
-			std::cerr << "Note: cannot open filelist file: " << fileName << std::endl;
+			L.err << "Note: cannot open filelist file: " << fileName << std::endl;
 
 			return false;
 		}
@@ -165,14 +180,14 @@ bool loadBasebandFilelist(const std::string &fileName, std::vector<VexBasebandDa
 
 			if(v != 0)
 			{
-				std::cerr << "Error: cannot get filelist data from " << fileName << ".  The file is not in a recognized format or it contains invalid MJD times."  << std::endl;
+				L.err << "Error: cannot get filelist data from " << fileName << ".  The file is not in a recognized format or it contains invalid MJD times."  << std::endl;
 
 				return false;
 			}
 		}
 		else
 		{
-			std::cerr << "Error: cannot get filelist data from " << fileName << ".  Error might be related to: " << error.str() << std::endl;
+			L.err << "Error: cannot get filelist data from " << fileName << ".  Error might be related to: " << error.str() << std::endl;
 
 			return false;
 		}
@@ -198,7 +213,7 @@ bool loadBasebandFilelist(const std::string &fileName, std::vector<VexBasebandDa
 		{
 			fullName << prefix << datum->getName();
 
-			basebandFiles.push_back(VexBasebandData(fullName.str(), 0, -1, datum->getFullMjdStart(), datum->getFullMjdEnd()));
+			L.files.push_back(VexBasebandData(fullName.str(), 0, -1, datum->getFullMjdStart(), datum->getFullMjdEnd()));
 
 			++n;
 		}
@@ -206,12 +221,192 @@ bool loadBasebandFilelist(const std::string &fileName, std::vector<VexBasebandDa
 
 	if(n == 0)
 	{
-		n = loadBasebandFilelistOld(fileName, basebandFiles);
+		if(loadBasebandFilelistOld(fileName, L.files, L.err) < 0)
+		{
+			L.fatal = true;
+
+			return false;
+		}
 	}
 
 	return true;
 }
 
+// Whether readBasebandFilelist() may write .cache and .times files beside the filelists;
+// set by CorrParams::load() before any filelist is read
+static bool writeFilelistCaches = false;
+
+// Safe to call from several threads at once for different files
+static void readBasebandFilelist(const std::string &fileName, FilelistLoad &L)
+{
+	std::vector<unsigned int> untimed;	// indices into L.files of entries with no times
+
+	if(!readFilelistCache(fileName, L.files))
+	{
+		L.files.clear();
+		if(!parseBasebandFilelist(fileName, L))
+		{
+			return;
+		}
+		if(writeFilelistCaches)
+		{
+			writeFilelistCache(fileName, L.files);
+		}
+	}
+	L.ok = true;
+
+	for(unsigned int i = 0; i < L.files.size(); ++i)
+	{
+		if(hasNoTimes(L.files[i]))
+		{
+			untimed.push_back(i);
+		}
+	}
+
+	// Try to get the missing times from the files themselves
+	if(!untimed.empty() && probeBasebandFiles(L.files, untimed, fileName + ".times", writeFilelistCaches) == 0)
+	{
+		L.out << "Note: start/stop times for the " << untimed.size() << " files of filelist " << fileName << " were read from their headers." << std::endl;
+	}
+	else if(!untimed.empty())
+	{
+		L.out << "Warning: Filelist file " << fileName << " was a listing with no start/stop times." << std::endl;
+		L.missingTimes = true;
+	}
+}
+
+class FilelistReadWork
+{
+public:
+	std::vector<std::string> fileNames;
+	std::vector<FilelistLoad *> loads;	// parallel to fileNames
+	unsigned int nextTask;
+	pthread_mutex_t lock;
+};
+
+static void *filelistReadWorker(void *arg)
+{
+	FilelistReadWork *work = static_cast<FilelistReadWork *>(arg);
+
+	for(;;)
+	{
+		unsigned int t;
+
+		pthread_mutex_lock(&work->lock);
+		t = work->nextTask++;
+		pthread_mutex_unlock(&work->lock);
+
+		if(t >= work->fileNames.size())
+		{
+			break;
+		}
+		readBasebandFilelist(work->fileNames[t], *work->loads[t]);
+	}
+
+	return 0;
+}
+
+// Filelists read ahead of time by preloadBasebandFilelists(), indexed by file name
+static std::map<std::string,FilelistLoad *> preloadedFilelists;
+
+// Reads all named filelists concurrently so that loadBasebandFilelist() finds them ready
+static void preloadBasebandFilelists(const std::set<std::string> &fileNames)
+{
+	FilelistReadWork work;
+	std::vector<pthread_t> threads;
+	unsigned int nThread;
+	long nCPU;
+
+	for(std::set<std::string>::const_iterator it = fileNames.begin(); it != fileNames.end(); ++it)
+	{
+		if(preloadedFilelists.find(*it) == preloadedFilelists.end())
+		{
+			FilelistLoad *L = new FilelistLoad;
+
+			preloadedFilelists[*it] = L;
+			work.fileNames.push_back(*it);
+			work.loads.push_back(L);
+		}
+	}
+	work.nextTask = 0;
+	pthread_mutex_init(&work.lock, 0);
+
+	nCPU = sysconf(_SC_NPROCESSORS_ONLN);
+	nThread = (nCPU > 1) ? nCPU : 1;
+	if(nThread > work.fileNames.size())
+	{
+		nThread = work.fileNames.size();
+	}
+
+	// The calling thread is one of the workers
+	for(unsigned int i = 1; i < nThread; ++i)
+	{
+		pthread_t thread;
+
+		if(pthread_create(&thread, 0, filelistReadWorker, &work) != 0)
+		{
+			break;
+		}
+		threads.push_back(thread);
+	}
+	filelistReadWorker(&work);
+	for(std::vector<pthread_t>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		pthread_join(*it, 0);
+	}
+
+	pthread_mutex_destroy(&work.lock);
+}
+
+// Drops filelists that were read ahead but never used
+static void discardPreloadedFilelists()
+{
+	for(std::map<std::string,FilelistLoad *>::iterator it = preloadedFilelists.begin(); it != preloadedFilelists.end(); ++it)
+	{
+		delete it->second;
+	}
+	preloadedFilelists.clear();
+}
+
+// Returns true on success
+bool loadBasebandFilelist(const std::string &fileName, std::vector<VexBasebandData> &basebandFiles)
+{
+	static bool first = true;
+	std::map<std::string,FilelistLoad *>::iterator it;
+	FilelistLoad *L;
+
+	it = preloadedFilelists.find(fileName);
+	if(it != preloadedFilelists.end())
+	{
+		L = it->second;
+		preloadedFilelists.erase(it);
+	}
+	else
+	{
+		L = new FilelistLoad;
+		readBasebandFilelist(fileName, *L);
+	}
+
+	std::cout << L->out.str();
+	std::cerr << L->err.str();
+	if(L->fatal)
+	{
+		exit(EXIT_FAILURE);
+	}
+	if(L->missingTimes && first)
+	{
+		first = false;
+
+		std::cout << "Note: Future versions of vex2difx may stop allowing file lists without start/stop times.  Filelists for VDIF and Mark5B files with start/stop times can be generated with \"vsum -s\" and \"m5bsum -s\" respectively.  These times allow vex2difx to properly assign data to jobs and is especially important in cases where multiple jobs are generated per project." << std::endl;
+	}
+	basebandFiles.insert(basebandFiles.end(), L->files.begin(), L->files.end());
+
+	bool ok = L->ok;
+	delete L;
+
+	return ok;
+}
+
 CorrSetup::CorrSetup(const std::string &name) : corrSetupName(name)
 {
 	tInt = 2.0;
@@ -523,6 +718,28 @@ CorrRule::CorrRule(const std::string &name) : ruleName(name)
 {
 }
 
+CompiledCorrRule::CompiledCorrRule(const CorrRule &rule) : scanName(rule.scanName.begin(), rule.scanName.end()), sourceName(rule.sourceName.begin(), rule.sourceName.end()), modeName(rule.modeName.begin(), rule.modeName.end()), corrSetupName(rule.corrSetupName)
+{
+}
+
+bool CompiledCorrRule::match(const std::string &scan, const std::string &source, const std::string &mode) const
+{
+	if(!scanName.empty() && scanName.find(scan) == scanName.end())
+	{
+		return false;
+	}
+	if(!sourceName.empty() && sourceName.find(source) == sourceName.end())
+	{
+		return false;
+	}
+	if(!modeName.empty() && modeName.find(mode) == modeName.end())
+	{
+		return false;
+	}
+
+	return true;
+}
+
 bool CorrRule::match(const std::string &scan, const std::string &source, const std::string &mode) const
 {
 	if(!scanName.empty() && find(scanName.begin(), scanName.end(), scan) == scanName.end())
@@ -1743,7 +1960,7 @@ CorrParams::CorrParams()
 	parseWarnings = 0;
 }
 
-CorrParams::CorrParams(const std::string &fileName)
+CorrParams::CorrParams(const std::string &fileName, bool writeCache)
 {
 	size_t pos;
 
@@ -1752,7 +1969,7 @@ CorrParams::CorrParams(const std::string &fileName)
 	pos = fileName.find(".");
 	jobSeries = fileName.substr(0, pos);
 
-	parseWarnings = load(fileName);
+	parseWarnings = load(fileName, writeCache);
 
 #ifdef DONT_USE_EXPER_AS_PASS
 	pos = vexFile.find(".");
@@ -1779,6 +1996,9 @@ void CorrParams::defaults()
 	maxLength = 7200/86400.0;	// 2 hours
 	minLength = 2/86400.0;		// 2 seconds
 	maxSize = 2e9;			// 2 GB
+	sliceLength = 0.0;		// no slicing
+	maxOps = 0.0;			// no limit
+	targetOps = 0.0;		// no balancing
 	mjdStart = 0.0;
 	mjdStop = 1.0e7;
 	startSeries = 1;
@@ -1918,6 +2138,21 @@ int CorrParams::setkv(const std::string &key, const std::string &value)
 		ss >> maxSize;
 		maxSize *= 1000000.0;	// convert to bytes from MB
 	}
+	else if(key == "sliceLength")
+	{
+		ss >> sliceLength;
+		sliceLength /= 86400.0;	// convert to seconds from days
+	}
+	else if(key == "maxOps")
+	{
+		ss >> maxOps;
+		maxOps *= 1.0e12;	// convert to operations from Tops
+	}
+	else if(key == "targetOps")
+	{
+		ss >> targetOps;
+		targetOps *= 1.0e12;	// convert to operations from Tops
+	}
 	else if(key == "jobSeries" || key == "pass")
 	{
 		unsigned int l = value.size();
@@ -2079,7 +2314,7 @@ void CorrParams::addBaseline(const std::string &baselineName)
 		baselineName.substr(pos+1) ));
 }
 
-int CorrParams::load(const std::string &fileName)
+int CorrParams::load(const std::string &fileName, bool writeCache)
 {
 	enum Parse_Mode
 	{
@@ -2158,6 +2393,28 @@ int CorrParams::load(const std::string &fileName)
 		}
 	}
 
+	// Read all filelists up front, concurrently; setkv() below then takes them in turn.
+	// Those named inside COMMENT blocks are never used, so are not read.
+	std::set<std::string> filelists;
+	bool inComment = false;
+	for(unsigned int t = 0; t < tokens.size(); ++t)
+	{
+		if(inComment)
+		{
+			inComment = (tokens[t] != "}");
+		}
+		else if(tokens[t] == "COMMENT")
+		{
+			inComment = true;
+		}
+		else if(t >= 2 && tokens[t-1] == "=" && (tokens[t-2] == "filelist" || tokens[t-2] == "mark6filelist"))
+		{
+			filelists.insert(tokens[t]);
+		}
+	}
+	writeFilelistCaches = writeCache;
+	preloadBasebandFilelists(filelists);
+
 	bool keyWaiting=false, keyWaitingTemp;
 	std::string key(""), value, last("");
 	for(std::vector<std::string>::const_iterator i = tokens.begin(); i != tokens.end(); ++i)
@@ -2464,6 +2721,7 @@ int CorrParams::load(const std::string &fileName)
 	}
 
 	is.close();
+	discardPreloadedFilelists();
 
 	// if no setups or rules declared, make the default setup
 	if(corrSetups.empty())
@@ -2537,6 +2795,8 @@ int CorrParams::load(const std::string &fileName)
 		}
 	}
 
+	// rules are final now; findSetup() matches against the compiled form
+	compileRules();
 
 	return nWarn;
 }
@@ -2710,6 +2970,7 @@ void CorrParams::example()
 	rules.push_back(CorrRule("X"));
 	rules.back().scanName.push_back(std::string("No0006"));
 	rules.back().corrSetupName = std::string("bogus");
+	compileRules();
 }
 
 int CorrParams::sanityCheck()
@@ -3045,13 +3306,47 @@ const PhaseCentre *CorrParams::getPhaseCentre(const std::string &difxName) const
 	return 0;
 }
 
-const std::string &CorrParams::findSetup(const std::string &scan, const std::string &source, const std::string &mode) const
+// Must be called whenever rules changes; findSetup() uses the result
+void CorrParams::compileRules()
 {
-	std::vector<CorrRule>::const_iterator it;
+	compiledRules.clear();
+	scanSetups.clear();
+	compiledRules.reserve(rules.size());
+	for(std::vector<CorrRule>::const_iterator it = rules.begin(); it != rules.end(); ++it)
+	{
+		compiledRules.push_back(CompiledCorrRule(*it));
+	}
+}
+
+// Records the setup of each scan of V so later findSetup() calls for it are a single lookup
+void CorrParams::assignScanSetups(const VexData *V)
+{
+	scanSetups.clear();
+	for(unsigned int s = 0; s < V->nScan(); ++s)
+	{
+		const VexScan *scan = V->getScan(s);
+		ScanSetupAssignment &A = scanSetups[scan->defName];
+
+		A.sourceDefName = scan->sourceDefName;
+		A.modeDefName = scan->modeDefName;
+		A.corrSetupName = matchSetup(scan->defName, scan->sourceDefName, scan->modeDefName);
+	}
+}
+
+const std::string &CorrParams::matchSetup(const std::string &scan, const std::string &source, const std::string &mode) const
+{
+	std::vector<CompiledCorrRule>::const_iterator it;
 	static const std::string def("default");
 	static const std::string none("");
 
-	for(it = rules.begin(); it != rules.end(); ++it)
+	if(compiledRules.size() != rules.size())
+	{
+		std::cerr << "Developer error: CorrParams::matchSetup: " << rules.size() << " rules but " << compiledRules.size() << " compiled rules; compileRules() was not called after the rules changed." << std::endl;
+
+		exit(EXIT_FAILURE);
+	}
+
+	for(it = compiledRules.begin(); it != compiledRules.end(); ++it)
 	{
 		if(it->match(scan, source, mode))
 		{
@@ -3068,6 +3363,19 @@ const std::string &CorrParams::findSetup(const std::string &scan, const std::str
 	return none;
 }
 
+const std::string &CorrParams::findSetup(const std::string &scan, const std::string &source, const std::string &mode) const
+{
+	std::map<std::string,ScanSetupAssignment>::const_iterator it;
+
+	it = scanSetups.find(scan);
+	if(it != scanSetups.end() && it->second.sourceDefName == source && it->second.modeDefName == mode)
+	{
+		return it->second.corrSetupName;
+	}
+
+	return matchSetup(scan, source, mode);
+}
+
 std::ostream& operator << (std::ostream &os, const CorrSetup &x)
 {
 	int p;
@@ -3293,6 +3601,9 @@ std::ostream& operator << (std::ostream &os, const CorrParams &x)
 	os << "maxLength=" << x.maxLength*86400.0 << " # seconds" << std::endl;
 	os << "minLength=" << x.minLength*86400.0 << " # seconds" << std::endl;
 	os << "maxSize=" << x.maxSize/1000000.0 << " # MB" << std::endl;
+	os << "sliceLength=" << x.sliceLength*86400.0 << " # seconds" << std::endl;
+	os << "maxOps=" << x.maxOps*1.0e-12 << " # Tops" << std::endl;
+	os << "targetOps=" << x.targetOps*1.0e-12 << " # Tops" << std::endl;
 	os.precision(13);
 
 	if(x.threadsFile != "")
@@ -311,15 +311,37 @@ public:
 	std::string corrSetupName;	/* pointer to CorrSetup */
 };
 
+// A CorrRule with its name lists turned into sets; built by CorrParams::compileRules()
+class CompiledCorrRule
+{
+public:
+	CompiledCorrRule(const CorrRule &rule);
+	bool match(const std::string &scan, const std::string &source, const std::string &mode) const;
+
+	std::set<std::string> scanName;
+	std::set<std::string> sourceName;
+	std::set<std::string> modeName;
+	std::string corrSetupName;
+};
+
+// The outcome of CorrParams::findSetup() for one scan; built by CorrParams::assignScanSetups()
+class ScanSetupAssignment
+{
+public:
+	std::string sourceDefName;	// the source and mode the assignment was made for
+	std::string modeDefName;
+	std::string corrSetupName;
+};
+
 class CorrParams : public Interval
 {
 public:
 	CorrParams();
-	CorrParams(const std::string &fileName);
+	CorrParams(const std::string &fileName, bool writeCache = false);	// writeCache: see load()
 	int checkSetupValidity();
 
 	int setkv(const std::string &key, const std::string &value);
-	int load(const std::string &fileName);
+	int load(const std::string &fileName, bool writeCache = false);	// writeCache allows filelist caches to be written
 	void defaults();
 	void defaultSetup();
 	void defaultRule();
@@ -342,6 +364,8 @@ public:
 	const GlobalZoom *getGlobalZoom(const std::string &name) const;
 	const VexClock *getAntennaClock(const std::string &antName) const;
 
+	void compileRules();
+	void assignScanSetups(const VexData *V);
 	const std::string &findSetup(const std::string &scan, const std::string &source, const std::string &mode) const;
 	const std::string &getNewSourceName(const std::string &origName) const;
 	
@@ -368,6 +392,9 @@ public:
 	double maxLength;	// [days]
 	double minLength;	// [days]
 	double maxSize;		// [bytes] -- break jobs for output filesize
+	double sliceLength;	// [days] -- cut longer scans into integration-aligned jobs of about this length; 0 means no slicing
+	double maxOps;		// [operations] -- break jobs for estimated correlation cost; 0 means no limit
+	double targetOps;	// [operations] -- balance jobs to about this estimated cost; 0 means no balancing
 	std::string jobSeries;	// prefix name to job files
 	int startSeries;	// start job series at this number
 	int dataBufferFactor;
@@ -414,6 +441,10 @@ public:
 private:
 	void addAntenna(const std::string &antName);
 	void addBaseline(const std::string &baselineName);
+	const std::string &matchSetup(const std::string &scan, const std::string &source, const std::string &mode) const;
+
+	std::vector<CompiledCorrRule> compiledRules;	// parallel to rules; see compileRules()
+	std::map<std::string,ScanSetupAssignment> scanSetups;	// indexed by scan defName; see assignScanSetups()
 };
 
 std::ostream& operator << (std::ostream &os, const DatastreamSetup &x);
@@ -0,0 +1,234 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include "ephemcache.h"
+
+EphemerisGrid::EphemerisGrid(const VexSource *vexSource, double mjdStart, double mjdStop)
+{
+	deltaT = vexSource->ephemDeltaT;	// seconds -- interval between ephemeris calculations.  24 sec is normal
+	intMJD = static_cast<int>(mjdStart);
+	// start time in seconds rounded down to nearest 2 minute boundary, and then one more
+	secStart = (static_cast<int>((mjdStart - intMJD)*720.0) - 1)*120;
+	// end time in seconds rounded up to nearest 2 minute boundary, and then one more
+	const int secEnd = static_cast<int>((mjdStop - intMJD)*720.0 + 1.999)*120;
+	nPoint = (secEnd - secStart)/deltaT + 1;
+}
+
+// A grid spanning the given seconds since MJD 0, anchored at the start of its first day
+EphemerisGrid::EphemerisGrid(long int dt, long long startSecond, long long stopSecond) : deltaT(dt)
+{
+	intMJD = startSecond/86400;
+	secStart = startSecond - intMJD*86400LL;
+	nPoint = (stopSecond - startSecond)/deltaT + 1;
+}
+
+void computeSpacecraftEphemeris(DifxSpacecraft *ds, const VexSource *vexSource, const EphemerisGrid &grid, const DifxEOP *eop, int nEOP, int verbose)
+{
+	const double mjd0 = grid.intMJD + grid.secStart/86400.0;
+	int v;
+
+	/* initialize state vector structure with evaluation times */
+	ds->nPoint = grid.nPoint;
+	ds->pos = (sixVector *)calloc(ds->nPoint, sizeof(sixVector));
+	for(int p = 0; p < grid.nPoint; ++p)
+	{
+		sixVectorSetTime(ds->pos + p, grid.intMJD, grid.secStart + p*grid.deltaT);
+	}
+
+	if(vexSource->type == VexSource::BSP)		// process a .bsp file through spice
+	{
+		if(verbose > 0)
+		{
+			std::cout << "Computing ephemeris for source: " << *vexSource << std::endl;
+			std::cout << "  start mjd = " << grid.intMJD << "  sec = " << grid.secStart << std::endl;
+			std::cout << "  nPoint = " << grid.nPoint << std::endl;
+		}
+
+		v = populateSpiceLeapSecondsFromEOP(eop, nEOP);
+		if(v != 0)
+		{
+			std::cerr << "Error: populateSpiceLeapSecondsFromEOP returned " << v << std::endl;
+
+			exit(EXIT_FAILURE);
+		}
+
+		v = computeDifxSpacecraftEphemeris(ds, mjd0, grid.deltaT/86400.0, grid.nPoint, 
+			vexSource->bspObject.c_str(),
+			0,
+			vexSource->bspFile.c_str(), 
+			vexSource->ephemStellarAber,
+			vexSource->ephemClockError);
+		if(v != 0)
+		{
+			std::cerr << "Error: ephemeris calculation failed.  Must stop." << std::endl;
+			
+			exit(EXIT_FAILURE);
+		}
+	}
+	else if(vexSource->type == VexSource::TLE)
+	{
+		if(verbose > 0)
+		{
+			std::cout << "Computing ephemeris for source: " << *vexSource << std::endl;
+			std::cout << "  start mjd = " << grid.intMJD << "  sec = " << grid.secStart << std::endl;
+			std::cout << "  nPoint = " << grid.nPoint << std::endl;
+		}
+
+		v = populateSpiceLeapSecondsFromEOP(eop, nEOP);
+		if(v != 0)
+		{
+			std::cerr << "Error: populateSpiceLeapSecondsFromEOP returned " << v << std::endl;
+
+			exit(EXIT_FAILURE);
+		}
+
+		v = computeDifxSpacecraftTwoLineElement(ds, mjd0, grid.deltaT/86400.0, grid.nPoint, 
+			vexSource->defName.c_str(),
+			0,
+			vexSource->tle[1].c_str(), 
+			vexSource->tle[2].c_str(), 
+			vexSource->ephemStellarAber,
+			vexSource->ephemClockError);
+		if(v != 0)
+		{
+			std::cerr << "Error: TLE ephemeris calculation failed.  Must stop." << std::endl;
+			
+			exit(EXIT_FAILURE);
+		}
+	}
+	else if(vexSource->type == VexSource::Fixed)
+	{
+		v = computeDifxSpacecraftEphemerisFromXYZ(ds, mjd0, grid.deltaT/86400.0, grid.nPoint, 
+			vexSource->X, vexSource->Y, vexSource->Z,
+			0,
+			vexSource->ephemClockError);
+		if(v != 0)
+		{
+			std::cerr << "Error: XYZ ephemeris calculation failed.  Must stop." << std::endl;
+			
+			exit(EXIT_FAILURE);
+		}
+	}
+	else
+	{
+		std::cerr << "Developer error: unknown source type; don't know how to compute state vectors." << std::endl;
+
+		exit(EXIT_FAILURE);
+	}
+}
+
+std::string SpacecraftEphemerisCache::key(const VexSource *vexSource, const EphemerisGrid &grid)
+{
+	std::stringstream k;
+	long long phase = grid.startSecond() % grid.deltaT;
+
+	k << vexSource->defName << '\n' << grid.deltaT << '\n' << phase;
+
+	return k.str();
+}
+
+void SpacecraftEphemerisCache::addJob(const VexSource *vexSource, double mjdStart, double mjdStop)
+{
+	EphemerisGrid grid(vexSource, mjdStart, mjdStop);
+	Entry E;
+
+	E.vexSource = vexSource;
+	E.startSecond = grid.startSecond();
+	E.stopSecond = grid.stopSecond();
+	entries[key(vexSource, grid)].push_back(E);
+}
+
+void SpacecraftEphemerisCache::compute(const DifxEOP *eop, int nEOP, int verbose)
+{
+	for(std::map<std::string,std::vector<Entry> >::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		std::vector<Entry> &spans = it->second;
+		std::vector<Entry>::size_type n = 0;
+
+		// merge the job grids into runs; all grids in the group share a phase,
+		// so a grid starting one step after the previous run ends extends it
+		std::sort(spans.begin(), spans.end(), startsBefore);
+		for(std::vector<Entry>::size_type i = 0; i < spans.size(); ++i)
+		{
+			if(n > 0 && spans[i].startSecond <= spans[n-1].stopSecond + static_cast<long long>(spans[i].vexSource->ephemDeltaT))
+			{
+				if(spans[i].stopSecond > spans[n-1].stopSecond)
+				{
+					spans[n-1].stopSecond = spans[i].stopSecond;
+				}
+			}
+			else
+			{
+				spans[n++] = spans[i];
+			}
+		}
+		spans.resize(n);
+
+		for(std::vector<Entry>::iterator e = spans.begin(); e != spans.end(); ++e)
+		{
+			EphemerisGrid grid(static_cast<long int>(e->vexSource->ephemDeltaT), e->startSecond, e->stopSecond);
+			DifxSpacecraft *ds;
+
+			ds = newDifxSpacecraftArray(1);
+			computeSpacecraftEphemeris(ds, e->vexSource, grid, eop, nEOP, verbose);
+			e->pos.assign(ds->pos, ds->pos + ds->nPoint);
+			deleteDifxSpacecraftArray(ds, 1);
+		}
+	}
+}
+
+const sixVector *SpacecraftEphemerisCache::find(const VexSource *vexSource, const EphemerisGrid &grid) const
+{
+	std::map<std::string,std::vector<Entry> >::const_iterator it = entries.find(key(vexSource, grid));
+
+	if(it == entries.end())
+	{
+		return 0;
+	}
+
+	// the last run starting at or before the grid is the only one that can hold it
+	const std::vector<Entry> &spans = it->second;
+	std::vector<Entry>::const_iterator e = std::upper_bound(spans.begin(), spans.end(), grid.startSecond(), startsAfter);
+	if(e == spans.begin())
+	{
+		return 0;
+	}
+	--e;
+	if(e->pos.empty() || grid.stopSecond() > e->stopSecond)
+	{
+		return 0;
+	}
+
+	return &e->pos[(grid.startSecond() - e->startSecond)/grid.deltaT];
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+/*
+This is a helper class used within vex2difx.cpp
+*/
+
+#ifndef __EPHEMCACHE_H__
+#define __EPHEMCACHE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <difxio/difx_input.h>
+#include <vexdatamodel.h>
+
+// The evaluation times of a spacecraft ephemeris for one job: nPoint points every
+// ephemDeltaT seconds, starting secStart seconds after the start of day intMJD
+class EphemerisGrid
+{
+public:
+	EphemerisGrid(const VexSource *vexSource, double mjdStart, double mjdStop);
+	EphemerisGrid(long int dt, long long startSecond, long long stopSecond);
+	long long startSecond() const { return intMJD*86400LL + secStart; }	// seconds since MJD 0
+	long long stopSecond() const { return startSecond() + (nPoint - 1)*static_cast<long long>(deltaT); }
+
+	long int deltaT;	// seconds
+	int intMJD;
+	int secStart;
+	int nPoint;
+};
+
+// Evaluates the state vectors of vexSource over the grid into ds, exiting on failure.
+// SPICE is not thread safe, so only one call may be in progress at a time.
+void computeSpacecraftEphemeris(DifxSpacecraft *ds, const VexSource *vexSource, const EphemerisGrid &grid, const DifxEOP *eop, int nEOP, int verbose);
+
+// State vectors of each spacecraft covering all jobs, computed once and sliced into
+// the spacecraft table of each job.  Grids of different jobs only share points if
+// their start times differ by a multiple of ephemDeltaT, so the grids are grouped
+// by spacecraft and grid phase, and within a group one ephemeris is kept per run of
+// overlapping or adjacent grids; the gaps between jobs are not evaluated.
+class SpacecraftEphemerisCache
+{
+public:
+	// Call for each job and spacecraft before compute()
+	void addJob(const VexSource *vexSource, double mjdStart, double mjdStop);
+
+	// Fills in all the state vectors; not thread safe
+	void compute(const DifxEOP *eop, int nEOP, int verbose);
+
+	// Returns the state vectors for the grid, or 0 if not cached.  May be called concurrently after compute().
+	const sixVector *find(const VexSource *vexSource, const EphemerisGrid &grid) const;
+
+private:
+	class Entry
+	{
+	public:
+		const VexSource *vexSource;
+		long long startSecond;
+		long long stopSecond;
+		std::vector<sixVector> pos;
+	};
+
+	static std::string key(const VexSource *vexSource, const EphemerisGrid &grid);
+	static bool startsBefore(const Entry &a, const Entry &b) { return a.startSecond < b.startSecond; }
+	static bool startsAfter(long long second, const Entry &E) { return second < E.startSecond; }
+
+	std::map<std::string,std::vector<Entry> > entries;	// sorted and disjoint after compute()
+};
+
+#endif
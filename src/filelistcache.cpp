@@ -0,0 +1,211 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "filelistcache.h"
+
+// Layout, all in native byte order:
+//   header: magic[8], version, byteOrder, nFile, nameBytes (uint32_t each after magic),
+//           filelist size and modification time in nanoseconds since 1970 (int64_t each)
+//   double mjdStart[nFile], double mjdStop[nFile]
+//   uint32_t nameOffset[nFile+1], into
+//   char names[nameBytes]
+// Files are kept in filelist order, which is the order they are given to the correlator.
+
+static const char filelistCacheMagic[8] = { 'V', '2', 'D', 'F', 'L', 'S', 'T', '\n' };
+static const uint32_t filelistCacheVersion = 2;
+static const uint32_t filelistCacheByteOrder = 0x01020304;
+
+class FilelistCacheHeader
+{
+public:
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t nFile;
+	uint32_t nameBytes;
+	int64_t filelistSize;
+	int64_t filelistMtime;
+};
+
+std::string filelistCacheFileName(const std::string &filelistFile)
+{
+	return filelistFile + ".cache";
+}
+
+bool readFilelistCache(const std::string &filelistFile, std::vector<VexBasebandData> &files)
+{
+	std::string cacheFile = filelistCacheFileName(filelistFile);
+	FilelistCacheHeader H;
+	struct stat listSt, st;
+	const char *data;
+	void *map;
+	size_t expected;
+	bool ok;
+	int fd;
+
+	if(stat(filelistFile.c_str(), &listSt) != 0)
+	{
+		return false;
+	}
+	fd = open(cacheFile.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+	if(fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(H)))
+	{
+		close(fd);
+
+		return false;
+	}
+	map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		return false;
+	}
+	data = static_cast<const char *>(map);
+
+	memcpy(&H, data, sizeof(H));
+	expected = sizeof(H) + 2*sizeof(double)*static_cast<size_t>(H.nFile) + sizeof(uint32_t)*(static_cast<size_t>(H.nFile) + 1) + H.nameBytes;
+	ok = memcmp(H.magic, filelistCacheMagic, sizeof(H.magic)) == 0 &&
+		H.version == filelistCacheVersion &&
+		H.byteOrder == filelistCacheByteOrder &&
+		H.filelistSize == static_cast<int64_t>(listSt.st_size) &&
+		H.filelistMtime == listSt.st_mtim.tv_sec*1000000000LL + listSt.st_mtim.tv_nsec &&
+		H.nFile <= static_cast<size_t>(st.st_size) &&
+		expected == static_cast<size_t>(st.st_size);
+
+	if(ok)
+	{
+		const char *mjdStart = data + sizeof(H);
+		const char *mjdStop = mjdStart + sizeof(double)*H.nFile;
+		const char *nameOffset = mjdStop + sizeof(double)*H.nFile;
+		const char *names = nameOffset + sizeof(uint32_t)*(H.nFile + 1);
+		std::vector<VexBasebandData> cached;
+
+		cached.reserve(H.nFile);
+		for(uint32_t i = 0; i < H.nFile; ++i)
+		{
+			double start, stop;
+			uint32_t a, b;
+
+			memcpy(&start, mjdStart + sizeof(double)*i, sizeof(double));
+			memcpy(&stop, mjdStop + sizeof(double)*i, sizeof(double));
+			memcpy(&a, nameOffset + sizeof(uint32_t)*i, sizeof(uint32_t));
+			memcpy(&b, nameOffset + sizeof(uint32_t)*(i+1), sizeof(uint32_t));
+			if(a > b || b > H.nameBytes)
+			{
+				ok = false;
+				break;
+			}
+			cached.push_back(VexBasebandData(std::string(names + a, b - a), 0, -1, start, stop));
+		}
+		if(ok)
+		{
+			files.swap(cached);
+		}
+	}
+
+	munmap(map, st.st_size);
+
+	return ok;
+}
+
+bool writeFilelistCache(const std::string &filelistFile, const std::vector<VexBasebandData> &files)
+{
+	std::string cacheFile = filelistCacheFileName(filelistFile);
+	std::stringstream tmpFile;	// per process, so that concurrent runs never write into the same file
+	std::vector<double> mjdStart, mjdStop;
+	std::vector<uint32_t> nameOffset;
+	std::string names;
+	FilelistCacheHeader H;
+	struct stat listSt;
+	FILE *out;
+	bool ok;
+
+	if(stat(filelistFile.c_str(), &listSt) != 0)
+	{
+		return false;
+	}
+
+	for(std::vector<VexBasebandData>::const_iterator it = files.begin(); it != files.end(); ++it)
+	{
+		mjdStart.push_back(it->mjdStart);
+		mjdStop.push_back(it->mjdStop);
+		nameOffset.push_back(names.size());
+		names += it->filename;
+	}
+	nameOffset.push_back(names.size());
+
+	memset(&H, 0, sizeof(H));
+	memcpy(H.magic, filelistCacheMagic, sizeof(H.magic));
+	H.version = filelistCacheVersion;
+	H.byteOrder = filelistCacheByteOrder;
+	H.nFile = files.size();
+	H.nameBytes = names.size();
+	H.filelistSize = listSt.st_size;
+	H.filelistMtime = listSt.st_mtim.tv_sec*1000000000LL + listSt.st_mtim.tv_nsec;
+
+	tmpFile << cacheFile << ".tmp." << getpid();
+	out = fopen(tmpFile.str().c_str(), "w");
+	if(!out)
+	{
+		return false;
+	}
+	ok = fwrite(&H, sizeof(H), 1, out) == 1;
+	if(ok && !files.empty())
+	{
+		ok = fwrite(&mjdStart[0], sizeof(double), mjdStart.size(), out) == mjdStart.size() &&
+			fwrite(&mjdStop[0], sizeof(double), mjdStop.size(), out) == mjdStop.size();
+	}
+	ok = ok && fwrite(&nameOffset[0], sizeof(uint32_t), nameOffset.size(), out) == nameOffset.size();
+	ok = ok && (names.empty() || fwrite(names.data(), 1, names.size(), out) == names.size());
+	if(fclose(out) != 0)
+	{
+		ok = false;
+	}
+	if(!ok || rename(tmpFile.str().c_str(), cacheFile.c_str()) != 0)
+	{
+		unlink(tmpFile.str().c_str());
+
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#ifndef __FILELISTCACHE_H__
+#define __FILELISTCACHE_H__
+
+#include <string>
+#include <vector>
+#include "vex_basebanddata.h"
+
+// A binary copy of the parsed contents of a filelist= file, stored next to it.  It is
+// only used while the size and nanosecond modification time of the filelist match those
+// recorded.
+
+// Returns the name of the cache file belonging to filelistFile
+std::string filelistCacheFileName(const std::string &filelistFile);
+
+// Returns true and sets files if a valid cache exists
+bool readFilelistCache(const std::string &filelistFile, std::vector<VexBasebandData> &files);
+
+// Returns true on success.  The file is written under a temporary name and renamed into place.
+bool writeFilelistCache(const std::string &filelistFile, const std::vector<VexBasebandData> &files);
+
+#endif
@@ -29,28 +29,79 @@
 
 #include "freq.h"
 
-// Returns index of requested (fq, bw, sb, ...) from freqs.
-// If not in freqs, it is added first
-int getFreqId(std::vector<freq>& freqs, double fq, double bw, char sb, double isr, double osr, int d, int iz, unsigned int t)
+bool operator<(const freq &a, const freq &b)
+{
+	if(a.fq != b.fq)
+	{
+		return a.fq < b.fq;
+	}
+	if(a.bw != b.bw)
+	{
+		return a.bw < b.bw;
+	}
+	if(a.sideBand != b.sideBand)
+	{
+		return a.sideBand < b.sideBand;
+	}
+	if(a.inputSpecRes != b.inputSpecRes)
+	{
+		return a.inputSpecRes < b.inputSpecRes;
+	}
+	if(a.outputSpecRes != b.outputSpecRes)
+	{
+		return a.outputSpecRes < b.outputSpecRes;
+	}
+	if(a.decimation != b.decimation)
+	{
+		return a.decimation < b.decimation;
+	}
+	if(a.isZoomFreq != b.isZoomFreq)
+	{
+		return a.isZoomFreq < b.isZoomFreq;
+	}
+
+	return a.toneSetId < b.toneSetId;
+}
+
+// Returns index of f within the table.
+// If not in the table, it is added first
+int FreqTable::getId(const freq &f)
 {
-	for(std::vector<freq>::const_iterator it = freqs.begin(); it != freqs.end(); ++it)
-	{
-		if(fq  == it->fq &&
-		   bw  == it->bw &&
-		   sb  == it->sideBand &&
-		   isr == it->inputSpecRes &&
-		   osr == it->outputSpecRes &&
-		   d   == it->decimation &&
-		   iz  == it->isZoomFreq &&
-		   t   == it->toneSetId)
-		{
-			// use iterator math to get index
-			return it - freqs.begin();
-		}
+	std::map<freq, int>::const_iterator it = ids.find(f);
+
+	if(it != ids.end())
+	{
+		return it->second;
 	}
 
 	// not in list yet, so add
-	freqs.push_back(freq(fq, bw, sb, isr, osr, d, iz, t));
+	freqs.push_back(f);
+	ids[f] = freqs.size() - 1;
 
 	return freqs.size() - 1;
 }
+
+// Returns index of tones within the table.
+// If not in the table, it is added first
+unsigned int ToneSetTable::getId(const std::vector<unsigned int> &tones)
+{
+	std::map<std::vector<unsigned int>, unsigned int>::const_iterator it = ids.find(tones);
+
+	if(it != ids.end())
+	{
+		return it->second;
+	}
+
+	// not in list yet, so add
+	toneSets.push_back(tones);
+	ids[tones] = toneSets.size() - 1;
+
+	return toneSets.size() - 1;
+}
+
+// Returns index of requested (fq, bw, sb, ...) from freqs.
+// If not in freqs, it is added first
+int getFreqId(FreqTable &freqs, double fq, double bw, char sb, double isr, double osr, int d, int iz, unsigned int t)
+{
+	return freqs.getId(freq(fq, bw, sb, isr, osr, d, iz, t));
+}
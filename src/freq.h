@@ -35,6 +35,7 @@ This is a helper class used within vex2difx.cpp
 #define __FREQ_H__
 
 #include <vector>
+#include <map>
 
 class freq
 {
@@ -53,6 +54,34 @@ public:
 	int specAvg() const { return static_cast<int>(outputSpecRes/inputSpecRes + 0.5); }
 };
 
-int getFreqId(std::vector<freq>& freqs, double fq, double bw, char sb, double isr, double osr, int d, int iz, unsigned int t);
+bool operator<(const freq &a, const freq &b);
+
+// Table of distinct freqs; ids are assigned in order of first appearance
+class FreqTable
+{
+public:
+	int getId(const freq &f);
+	const freq &operator[](unsigned int i) const { return freqs[i]; }
+	unsigned int size() const { return freqs.size(); }
+
+private:
+	std::vector<freq> freqs;	// index is the freqId
+	std::map<freq, int> ids;
+};
+
+// Table of distinct pulse cal tone sets; ids are assigned in order of first appearance
+class ToneSetTable
+{
+public:
+	unsigned int getId(const std::vector<unsigned int> &tones);
+	const std::vector<unsigned int> &operator[](unsigned int i) const { return toneSets[i]; }
+	unsigned int size() const { return toneSets.size(); }
+
+private:
+	std::vector<std::vector<unsigned int> > toneSets;	// index is the toneSetId
+	std::map<std::vector<unsigned int>, unsigned int> ids;
+};
+
+int getFreqId(FreqTable &freqs, double fq, double bw, char sb, double isr, double osr, int d, int iz, unsigned int t);
 
 #endif
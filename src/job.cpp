@@ -37,32 +37,38 @@
 
 void Job::assignAntennas(const VexData &V, std::list<std::pair<int,std::string> > &removedAntennas, bool sortAntennas)
 {
-	std::list<std::pair<int,std::string> > allAntennas;
+	const VexBitMatrix &hasData = V.getScanHasDataMatrix();
+	std::vector<bool> seen(V.getStationNames().size(), false);
+	std::vector<bool> kept(V.getStationNames().size(), false);
+	std::vector<std::pair<unsigned int,std::string> > appearance;	// each antenna of the job, in order of first appearance
 
 	jobAntennas.clear();
 
+	// an antenna is kept, in order of its first scan with data, if it has data in any of the job's scans
 	for(std::vector<std::string>::const_iterator s = scans.begin(); s != scans.end(); ++s)
 	{
-		const VexScan* S = V.getScanByDefName(*s);
-		for(std::map<std::string,Interval>::const_iterator a = S->stations.begin(); a != S->stations.end(); ++a)
+		int scanId = V.getScanIdByDefName(*s);
+		const VexScan* S = V.getScan(scanId);
+		for(std::vector<VexScanStation>::const_iterator a = S->stations.begin(); a != S->stations.end(); ++a)
 		{
-			if(find(jobAntennas.begin(), jobAntennas.end(), a->first) == jobAntennas.end())
+			if(!seen[a->antId])
 			{
-				allAntennas.push_back(std::pair<int,std::string>(jobId,a->first));
-				if(V.hasData(a->first, *S))	// a->first is antenna name
-				{
-					jobAntennas.push_back(a->first);
-				}
+				seen[a->antId] = true;
+				appearance.push_back(std::pair<unsigned int,std::string>(a->antId, S->getStationName(*a)));
+			}
+			if(!kept[a->antId] && hasData.test(scanId, a->antId))
+			{
+				kept[a->antId] = true;
+				jobAntennas.push_back(S->getStationName(*a));
 			}
 		}
 	}
 
-	// find antennas in allAntennas that never got into jobAntennas
-	for(std::list<std::pair<int,std::string> >::const_iterator a = allAntennas.begin(); a != allAntennas.end(); ++a)
+	for(std::vector<std::pair<unsigned int,std::string> >::const_iterator a = appearance.begin(); a != appearance.end(); ++a)
 	{
-		if(std::find(jobAntennas.begin(), jobAntennas.end(), a->second) == jobAntennas.end()) 
+		if(!kept[a->first])
 		{
-			removedAntennas.push_back(*a);
+			removedAntennas.push_back(std::pair<int,std::string>(jobId, a->second));
 		}
 	}
 
@@ -72,44 +78,57 @@ void Job::assignAntennas(const VexData &V, std::list<std::pair<int,std::string>
 	}
 }
 
-double Job::calcOps(const VexData *V, int fftSize, bool doPolar) const
+double calcScanOps(const VexData *V, const VexScan *S, double seconds, int fftSize, bool doPolar)
 {
-	double ops = 0.0;
 	int nAnt, nPol, nSubband;
 	double sampRate;	/* [samples per second] */
-	double seconds;
 	const VexMode *M;
 	char pols[8];
 	double opsPerSample;
 
+	M = V->getModeByDefName(S->modeDefName);
+	if(!M)
+	{
+		return 0.0;
+	}
+	
+	sampRate = M->getAverageSampleRate();
+	nPol = M->getPols(pols);
+	if(nPol > 1 && doPolar)
+	{
+		nPol = 2;
+	}
+	else
+	{
+		nPol = 1;
+	}
+
+	nAnt = S->stations.size();
+	nSubband = M->subbands.size();
+
+	// Estimate number of operations based on VLBA Sensitivity Upgrade Memo 16
+	// Note: this assumes all polarizations are matched
+	opsPerSample = 16.0 + 5.0*intlog2(fftSize) + 2.5*nAnt*nPol;
+
+	return opsPerSample*seconds*sampRate*nSubband*nAnt;
+}
+
+double Job::calcOps(const VexData *V, int fftSize, bool doPolar) const
+{
+	double ops = 0.0;
+
 	for(std::vector<std::string>::const_iterator si = scans.begin(); si != scans.end(); ++si)
 	{
 		const VexScan *S = V->getScanByDefName(*si);
-		M = V->getModeByDefName(S->modeDefName);
-		if(!M)
+		if(!V->getModeByDefName(S->modeDefName))
 		{
 			return 0.0;
 		}
-		
-		sampRate = M->getAverageSampleRate();
-		nPol = M->getPols(pols);
-		if(nPol > 1 && doPolar)
-		{
-			nPol = 2;
-		}
-		else
-		{
-			nPol = 1;
-		}
-
-		seconds = S->duration_seconds();
-		nAnt = S->stations.size();
-		nSubband = M->subbands.size();
 
-		// Estimate number of operations based on VLBA Sensitivity Upgrade Memo 16
-		// Note: this assumes all polarizations are matched
-		opsPerSample = 16.0 + 5.0*intlog2(fftSize) + 2.5*nAnt*nPol;
-		ops += opsPerSample*seconds*sampRate*nSubband*nAnt;
+		// only the part of the scan within this job, which may be one slice of a long scan
+		Interval scanInterval(*S);
+		scanInterval.logicalAnd(*this);
+		ops += calcScanOps(V, S, scanInterval.duration_seconds(), fftSize, doPolar);
 	}
 
 	return ops;
@@ -153,18 +172,46 @@ struct iless
 	}
 };
 
-int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const char *fileName, unsigned int invalidMask) const
+// Flags shorter than this are dropped; also the tolerance for matching the job start
+static const int64_t FlagResolutionNS = VexTime::NanosecondsPerSecond/2;
+
+static int64_t absNanoseconds(const VexTime &a, const VexTime &b)
+{
+	int64_t d = a.nanosecondsSince(b);
+
+	return (d < 0) ? -d : d;
+}
+
+// Only events between the start of the earliest and the end of the latest scan of this job (and the job
+// boundaries themselves) can change the flag state of the job's antennas, apart from media changes, which are
+// taken from the complete list of record events.  All other events are skipped.  This holds only while the
+// scan, pointing or time flags invalidate data outside that span; for other invalidMasks every event is replayed.
+int Job::generateFlagFile(const VexData &V, const EventTimeline &eventTimeline, const char *fileName, unsigned int invalidMask) const
 {
 	std::vector<JobFlag> flags;
 	std::map<std::string,unsigned int,iless> antIds;
+	std::vector<int> antIdOfName(eventTimeline.nName(), -1);	// event name id -> index into jobAntennas
+	std::vector<bool> isJobScan(eventTimeline.nName(), false);	// event name id -> is a scan of this job
 	unsigned int nAnt = 0;
 	std::ofstream of;
+	Interval window(*this);
+	EventTimeline::const_iterator first, last;
+	bool fullReplay = (invalidMask & (JobFlag::JOB_FLAG_SCAN | JobFlag::JOB_FLAG_POINT | JobFlag::JOB_FLAG_TIME)) == 0;
 
 	for(std::vector<std::string>::const_iterator a = jobAntennas.begin(); a != jobAntennas.end(); ++a)
 	{
 		antIds[*a] = nAnt;
 		++nAnt;
 	}
+	for(unsigned int id = 0; id < eventTimeline.nName(); ++id)
+	{
+		std::map<std::string,unsigned int,iless>::const_iterator it = antIds.find(eventTimeline.getName(id));
+
+		if(it != antIds.end())
+		{
+			antIdOfName[id] = it->second;
+		}
+	}
 
 	// Assume all flags from the start.  
 	std::vector<unsigned int> flagMask(nAnt, 
@@ -172,7 +219,7 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 		JobFlag::JOB_FLAG_POINT | 
 		JobFlag::JOB_FLAG_TIME | 
 		JobFlag::JOB_FLAG_SCAN);
-	std::vector<double> flagStart(nAnt, mjdStart);
+	std::vector<VexTime> flagStart(nAnt, mjdStart);
 
 	// Except if not a Mark5 Module case, don't assume RECORD flag is on
 	for(std::vector<std::string>::const_iterator a = jobAntennas.begin(); a != jobAntennas.end(); ++a)
@@ -184,28 +231,77 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 		}
 	}
 
+	for(std::vector<std::string>::const_iterator s = scans.begin(); s != scans.end(); ++s)
+	{
+		const VexScan *scan = V.getScanByDefName(*s);
+		int id = eventTimeline.getId(*s);
+
+		if(scan)
+		{
+			window.logicalOr(*scan);
+		}
+		if(id >= 0)
+		{
+			isJobScan[id] = true;
+		}
+	}
+	// JOB_START and JOB_STOP are considered up to 0.5 sec from job start
+	window.mjdStart -= 1.0/86400.0;
+	window.mjdStop += 1.0/86400.0;
+
+	// Bring the RECORD flag up to date with the media changes that precede the window
+	for(std::vector<Event>::const_iterator e = eventTimeline.getRecordEvents().begin(); !fullReplay && e != eventTimeline.getRecordEvents().end() && e->mjd < window.mjdStart; ++e)
+	{
+		if(antIdOfName[e->nameId] >= 0)
+		{
+			if(e->eventType == Event::RECORD_START)
+			{
+				flagMask[antIdOfName[e->nameId]] &= ~JobFlag::JOB_FLAG_RECORD;
+			}
+			else
+			{
+				flagMask[antIdOfName[e->nameId]] |= JobFlag::JOB_FLAG_RECORD;
+			}
+		}
+	}
+
 	// Then go through each event, adjusting current flag state.  
-	for(std::list<Event>::const_iterator e = events.begin(); e != events.end(); ++e)
+	if(fullReplay)
+	{
+		// Flag start times before the window matter, e.g. an antenna not recording since before this job
+		first = eventTimeline.begin();
+		last = eventTimeline.end();
+	}
+	else
+	{
+		eventTimeline.getRange(first, last, window.mjdStart, window.mjdStop);
+	}
+	for(EventTimeline::const_iterator e = first; e != last; ++e)
 	{
+		if(!fullReplay && e->mjd < window.mjdStart)
+		{
+			continue;	// already accounted for above
+		}
+
 		if(e->eventType == Event::RECORD_START)
 		{
-			if(antIds.count(e->name) > 0)
+			if(antIdOfName[e->nameId] >= 0)
 			{
-				flagMask[antIds[e->name]] &= ~JobFlag::JOB_FLAG_RECORD;
+				flagMask[antIdOfName[e->nameId]] &= ~JobFlag::JOB_FLAG_RECORD;
 			}
 		}
 		else if(e->eventType == Event::RECORD_STOP)
 		{
-			if(antIds.count(e->name) > 0)
+			if(antIdOfName[e->nameId] >= 0)
 			{
-				flagMask[antIds[e->name]] |= JobFlag::JOB_FLAG_RECORD;
+				flagMask[antIdOfName[e->nameId]] |= JobFlag::JOB_FLAG_RECORD;
 			}
 		}
 		else if(e->eventType == Event::SCAN_START)
 		{
-			if(hasScan(e->scan))
+			if(isJobScan[e->scanId])
 			{
-				const VexScan *scan = V.getScanByDefName(e->scan);
+				const VexScan *scan = V.getScanByDefName(eventTimeline.getScan(*e));
 
 				if(!scan)
 				{
@@ -213,21 +309,23 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 
 					exit(EXIT_FAILURE);
 				}
-				for(std::map<std::string,Interval>::const_iterator sa = scan->stations.begin(); sa != scan->stations.end(); ++sa)
+				for(std::vector<VexScanStation>::const_iterator sa = scan->stations.begin(); sa != scan->stations.end(); ++sa)
 				{
-					if(antIds.count(sa->first) == 0)
+					std::map<std::string,unsigned int,iless>::const_iterator it = antIds.find(scan->getStationName(*sa));
+
+					if(it == antIds.end())
 					{
 						continue;
 					}
-					flagMask[antIds[sa->first]] &= ~JobFlag::JOB_FLAG_SCAN;
+					flagMask[it->second] &= ~JobFlag::JOB_FLAG_SCAN;
 				}
 			}
 		}
 		else if(e->eventType == Event::SCAN_STOP)
 		{
-			if(hasScan(e->scan))
+			if(isJobScan[e->scanId])
 			{
-				const VexScan *scan = V.getScanByDefName(e->scan);
+				const VexScan *scan = V.getScanByDefName(eventTimeline.getScan(*e));
 
 				if(!scan)
 				{
@@ -235,33 +333,35 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 
 					exit(EXIT_FAILURE);
 				}
-				for(std::map<std::string,Interval>::const_iterator sa = scan->stations.begin(); sa != scan->stations.end(); ++sa)
+				for(std::vector<VexScanStation>::const_iterator sa = scan->stations.begin(); sa != scan->stations.end(); ++sa)
 				{
-					if(antIds.count(sa->first) == 0)
+					std::map<std::string,unsigned int,iless>::const_iterator it = antIds.find(scan->getStationName(*sa));
+
+					if(it == antIds.end())
 					{
 						continue;
 					}
-					flagMask[antIds[sa->first]] |= JobFlag::JOB_FLAG_SCAN;
+					flagMask[it->second] |= JobFlag::JOB_FLAG_SCAN;
 				}
 			}
 		}
 		else if(e->eventType == Event::ANT_SCAN_START)
 		{
-			if(hasScan(e->scan) && antIds.count(e->name) > 0)
+			if(isJobScan[e->scanId] && antIdOfName[e->nameId] >= 0)
 			{
-				flagMask[antIds[e->name]] &= ~JobFlag::JOB_FLAG_POINT;
+				flagMask[antIdOfName[e->nameId]] &= ~JobFlag::JOB_FLAG_POINT;
 			}
 		}
 		else if(e->eventType == Event::ANT_SCAN_STOP)
 		{
-			if(hasScan(e->scan) && antIds.count(e->name) > 0)
+			if(isJobScan[e->scanId] && antIdOfName[e->nameId] >= 0)
 			{
-				flagMask[antIds[e->name]] |= JobFlag::JOB_FLAG_POINT;
+				flagMask[antIdOfName[e->nameId]] |= JobFlag::JOB_FLAG_POINT;
 			}
 		}
 		else if(e->eventType == Event::JOB_START)
 		{
-			if(fabs(e->mjd - mjdStart) < 0.5/86400.0)
+			if(absNanoseconds(e->mjd, mjdStart) < FlagResolutionNS)
 			{
 				for(unsigned int antId = 0; antId < nAnt; ++antId)
 				{
@@ -271,7 +371,7 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 		}
 		else if(e->eventType == Event::JOB_STOP)
 		{
-			if(fabs(e->mjd - mjdStart) < 0.5/86400.0)
+			if(absNanoseconds(e->mjd, mjdStart) < FlagResolutionNS)
 			{
 				for(unsigned int antId = 0; antId < nAnt; ++antId)
 				{
@@ -284,9 +384,9 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 		{
 			if( (flagMask[antId] & invalidMask) == 0)
 			{
-				if(flagStart[antId] > 0)
+				if(flagStart[antId] > 0.0)
 				{
-					if(e->mjd - flagStart[antId] > 0.5/86400.0)
+					if(e->mjd.nanosecondsSince(flagStart[antId]) > FlagResolutionNS)
 					{
 						JobFlag f(flagStart[antId], e->mjd, antId);
 						// only add flag if it overlaps in time with this job
@@ -300,7 +400,7 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 			}
 			else
 			{
-				if(flagStart[antId] <= 0)
+				if(flagStart[antId] <= 0.0)
 				{
 					flagStart[antId] = e->mjd;
 				}
@@ -313,7 +413,7 @@ int Job::generateFlagFile(const VexData &V, const std::list<Event> events, const
 	{
 		if( (flagMask[antId] & invalidMask) != 0)
 		{
-			if(mjdStop - flagStart[antId] > 0.5/86400.0)
+			if(mjdStop.nanosecondsSince(flagStart[antId]) > FlagResolutionNS)
 			{
 				JobFlag f(flagStart[antId], mjdStop, antId);
 				// only add flag if it overlaps in time with this job
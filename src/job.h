@@ -41,11 +41,11 @@
 class Job : public Interval
 {
 public:
-	Job() : Interval(0.0, 1000000.0), jobSeries("Bogus"), jobId(-1), dutyCycle(1.0), dataSize(0.0) {}
+	Job() : Interval(0.0, 1000000.0), jobSeries("Bogus"), jobId(-1), dutyCycle(1.0), dataSize(0.0), ops(0.0) {}
 
 	void assignAntennas(const VexData &V, std::list<std::pair<int,std::string> > &removedAntennas, bool sortAntennas=true);
 	bool hasScan(const std::string &scanName) const;
-	int generateFlagFile(const VexData &V, const std::list<Event> events, const char *fileName, unsigned int invalidMask=0xFFFFFFFF) const;
+	int generateFlagFile(const VexData &V, const EventTimeline &eventTimeline, const char *fileName, unsigned int invalidMask=0xFFFFFFFF) const;
 
 	// return the approximate number of Operations required to compute this scan
 	double calcOps(const VexData *V, int fftSize, bool doPolar) const;
@@ -62,8 +62,12 @@ public:
 	std::vector<std::string> jobAntennas;	// vector of antennas used in this job
 	double dutyCycle;		// fraction of job spent in scans
 	double dataSize;		// [bytes] estimate of data output size
+	double ops;			// [operations] estimate of correlation cost; see calcScanOps()
 };
 
+// return the approximate number of operations required to correlate the given seconds of a scan
+double calcScanOps(const VexData *V, const VexScan *S, double seconds, int fftSize, bool doPolar);
+
 std::ostream& operator << (std::ostream &os, const Job &x);
 
 #endif
@@ -41,7 +41,7 @@ public:
 	static const unsigned int JOB_FLAG_TIME   = 1 << 2;
 	static const unsigned int JOB_FLAG_SCAN   = 1 << 3;
 	JobFlag() : antId(-1) {}
-	JobFlag(double start, double stop, int ant) : Interval(start, stop), antId(ant) {}
+	JobFlag(const VexTime &start, const VexTime &stop, int ant) : Interval(start, stop), antId(ant) {}
 
 	int antId;
 };
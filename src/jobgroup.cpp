@@ -28,7 +28,9 @@
  *==========================================================================*/
 
 #include <cstdlib>
+#include <cmath>
 #include <algorithm>
+#include <set>
 #include "jobgroup.h"
 
 bool JobGroup::hasScan(const std::string &scanName) const
@@ -36,16 +38,31 @@ bool JobGroup::hasScan(const std::string &scanName) const
 	return find(scans.begin(), scans.end(), scanName) != scans.end();
 }
 
-void JobGroup::genEvents(const std::list<Event> &eventList)
+// Copies the events falling within this job group's time range.  Scan events are kept only for scans in this group.
+void JobGroup::genEvents(const EventTimeline &eventTimeline)
 {
-	for(std::list<Event>::const_iterator it = eventList.begin(); it != eventList.end(); ++it)
+	EventTimeline::const_iterator first, last;
+	std::set<unsigned int> scanIds;
+
+	for(std::vector<std::string>::const_iterator s = scans.begin(); s != scans.end(); ++s)
+	{
+		int id = eventTimeline.getId(*s);
+
+		if(id >= 0)
+		{
+			scanIds.insert(id);
+		}
+	}
+
+	eventTimeline.getRange(first, last, mjdStart, mjdStop);
+	for(EventTimeline::const_iterator it = first; it != last; ++it)
 	{
 		if(it->eventType == Event::SCAN_START ||
 		   it->eventType == Event::SCAN_STOP ||
 		   it->eventType == Event::ANT_SCAN_START ||
 		   it->eventType == Event::ANT_SCAN_STOP)
 		{
-			if(hasScan(it->scan))
+			if(scanIds.count(it->scanId) > 0)
 			{
 				events.push_back(*it);
 			}	
@@ -57,30 +74,67 @@ void JobGroup::genEvents(const std::list<Event> &eventList)
 	}
 }
 
-void JobGroup::createJobs(std::vector<Job> &jobs, Interval &jobTimeRange, const VexData *V, double minLength, double maxLength, double maxSize) const
+// The part of one scan that falls within a job time range
+class JobScan : public Interval
+{
+public:
+	JobScan(const Interval &timeRange, const VexScan *S, unsigned int id, double opCount) : Interval(timeRange), scan(S), nameId(id), ops(opCount) {}
+
+	const VexScan *scan;
+	unsigned int nameId;
+	double ops;		// [operations] estimated correlation cost of this part of the scan
+};
+
+static void finishJob(Job *J, double scanTime, double size)
+{
+	J->dutyCycle = scanTime / J->duration();
+	J->dataSize = size;
+}
+
+// Appends an empty job and resets the running totals for it
+static Job *startNextJob(std::vector<Job> &jobs, const Interval &jobTimeRange, double &scanTime, double &size)
 {
-	std::list<Event>::const_iterator s, e;
+	Job *J;
+
 	jobs.push_back(Job());
-	Job *J = &jobs.back();
-	double totalTime, scanTime = 0.0;
-	double size = 0.0;
-	std::string id("");
+	J = &jobs.back();
+	scanTime = 0.0;
+	size = 0.0;
 
 	// note these are backwards now; will set these to minimum range covering scans
 	J->setTimeRange(jobTimeRange.mjdStop, jobTimeRange.mjdStart);
 
+	return J;
+}
+
+// Jobs are broken at scan boundaries when they get longer than maxLength, larger than maxSize or more
+// expensive than maxOps.  If targetOps is set the job time range is additionally cut into pieces of
+// about equal estimated cost, each break going at the scan boundary closest to an equal share.
+void JobGroup::createJobs(std::vector<Job> &jobs, Interval &jobTimeRange, const VexData *V, const CorrParams *P, const EventTimeline &eventTimeline) const
+{
+	std::vector<Event>::const_iterator s, e;
+	std::vector<JobScan> jobScans;
+	Job *J;
+	double totalTime, scanTime;
+	double size;
+	double totalOps = 0.0;
+	double shareOps = 0.0;		// [operations] cost of each job when balancing; 0 if not
+	double cumulativeOps = 0.0;	// [operations] cost of the scans already assigned to jobs
+	double nextBreakOps = 0.0;	// [operations] cumulative cost at which the next balancing break is due
+	unsigned int id = EventTimeline::NoName;
+
 	for(e = events.begin(); e != events.end(); ++e)
 	{
 		if(e->eventType == Event::SCAN_START)
 		{
 			s = e;
-			id = e->name;
+			id = e->nameId;
 		}
 		if(e->eventType == Event::SCAN_STOP)
 		{
-			if(id != e->name)
+			if(id != e->nameId)
 			{
-				std::cerr << "Developer error: createJobs: id != e->name  (" << id << " != " << e->name << ")" << std::endl;
+				std::cerr << "Developer error: createJobs: id != e->name  (" << eventTimeline.getName(id) << " != " << eventTimeline.getName(*e) << ")" << std::endl;
 
 				exit(EXIT_FAILURE);
 			}
@@ -88,47 +142,98 @@ void JobGroup::createJobs(std::vector<Job> &jobs, Interval &jobTimeRange, const
 			scanTimeRange.logicalAnd(jobTimeRange);
 			if(scanTimeRange.duration() > 0.0)
 			{
-				const VexScan *scan = V->getScanByDefName(id);
+				const VexScan *scan = V->getScanByDefName(eventTimeline.getName(id));
 				if(!scan)
 				{
-					std::cerr << "Developer error: createJobs: getScanByDefName() returned numm for id = " << id << std::endl;
+					std::cerr << "Developer error: createJobs: getScanByDefName() returned numm for id = " << eventTimeline.getName(id) << std::endl;
 					
 					exit(EXIT_FAILURE);
 				}
-				J->modeName = scan->modeDefName;
-				J->scans.push_back(e->name);
-				J->logicalOr(scanTimeRange);
-				scanTime += scanTimeRange.duration();
-
-				// Work in progress: calculate correlated size of scan
-				size += scan->size;
-
-				/* start a new job at scan boundary if maxLength exceeded */
-				if(J->duration() > maxLength || size > maxSize)
+				const CorrSetup *corrSetup = P->getCorrSetup(P->findSetup(scan->defName, scan->sourceDefName, scan->modeDefName));
+				double ops = 0.0;
+				if(corrSetup)
 				{
-					totalTime = J->duration();
-					J->dutyCycle = scanTime / totalTime;
-					J->dataSize = size;
-					jobs.push_back(Job());
-					J = &jobs.back();
-					scanTime = 0.0;
-					size = 0.0;
-					J->setTimeRange(jobTimeRange.mjdStop, jobTimeRange.mjdStart);
+					ops = calcScanOps(V, scan, scanTimeRange.duration_seconds(), 2*corrSetup->maxInputChans(), corrSetup->doPolar);
 				}
+				jobScans.push_back(JobScan(scanTimeRange, scan, e->nameId, ops));
+				totalOps += ops;
 			}
 		}
 	}
 
+	if(P->targetOps > 0.0 && totalOps > P->targetOps)
+	{
+		shareOps = totalOps/ceil(totalOps/P->targetOps);
+		nextBreakOps = shareOps;
+	}
+
+	J = startNextJob(jobs, jobTimeRange, scanTime, size);
+
+	for(std::vector<JobScan>::const_iterator js = jobScans.begin(); js != jobScans.end(); ++js)
+	{
+		bool breakBefore = false;
+
+		if(P->maxOps > 0.0 && js->ops > P->maxOps)
+		{
+			std::cerr << "Warning: scan " << js->scan->defName << " has an estimated cost of " << (js->ops*1.0e-12) << " Tops, more than maxOps = " << (P->maxOps*1.0e-12) << " Tops, and cannot be split." << std::endl;
+		}
+
+		/* start a new job before this scan if it would exceed maxOps or overshoot the balanced share more than stopping short would */
+		if(!J->scans.empty())
+		{
+			if(P->maxOps > 0.0 && J->ops + js->ops > P->maxOps)
+			{
+				breakBefore = true;
+			}
+			if(shareOps > 0.0 && cumulativeOps + js->ops > nextBreakOps && nextBreakOps - cumulativeOps < cumulativeOps + js->ops - nextBreakOps)
+			{
+				breakBefore = true;
+				nextBreakOps += shareOps;
+			}
+		}
+		if(breakBefore)
+		{
+			finishJob(J, scanTime, size);
+			J = startNextJob(jobs, jobTimeRange, scanTime, size);
+		}
+
+		J->modeName = js->scan->modeDefName;
+		J->scans.push_back(eventTimeline.getName(js->nameId));
+		J->logicalOr(*js);
+		scanTime += js->duration();
+
+		// Work in progress: calculate correlated size of scan, or of the part of it in this job
+		size += js->scan->size*js->duration()/js->scan->duration();
+
+		J->ops += js->ops;
+		cumulativeOps += js->ops;
+
+		/* start a new job at scan boundary if maxLength, maxSize or the balanced share is exceeded */
+		bool breakAfter = (J->duration() > P->maxLength || size > P->maxSize);
+		if(shareOps > 0.0 && cumulativeOps >= nextBreakOps)
+		{
+			breakAfter = true;
+			while(nextBreakOps <= cumulativeOps)
+			{
+				nextBreakOps += shareOps;
+			}
+		}
+		if(breakAfter)
+		{
+			finishJob(J, scanTime, size);
+			J = startNextJob(jobs, jobTimeRange, scanTime, size);
+		}
+	}
+
 	totalTime = J->duration();
 	
-	if(totalTime < minLength)
+	if(totalTime < P->minLength)
 	{
 		jobs.pop_back();
 	}
 	else
 	{
-		J->dutyCycle = scanTime / totalTime;
-		J->dataSize = size;
+		finishJob(J, scanTime, size);
 	}
 }
 
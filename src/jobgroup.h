@@ -37,16 +37,17 @@
 #include "job.h"
 #include "event.h"
 #include "vex_data.h"
+#include "corrparams.h"
 
 class JobGroup : public Interval
 {
 public:
 	std::vector<std::string> scans;
-	std::list<Event> events;
+	std::vector<Event> events;	// the events of this group; names refer to the EventTimeline they were taken from
 
 	bool hasScan(const std::string &scanName) const;
-	void genEvents(const std::list<Event> &eventList);
-	void createJobs(std::vector<Job> &jobs, Interval &jobTimeRange, const VexData *V, double minLength, double maxLength, double maxSize) const;
+	void genEvents(const EventTimeline &eventTimeline);
+	void createJobs(std::vector<Job> &jobs, Interval &jobTimeRange, const VexData *V, const CorrParams *P, const EventTimeline &eventTimeline) const;
 };
 
 std::ostream& operator << (std::ostream &os, const JobGroup &x);
@@ -28,6 +28,7 @@
  *==========================================================================*/
 
 #include <cstdlib>
+#include <cmath>
 #include <sstream>
 #include <map>
 #include <algorithm>
@@ -38,12 +39,12 @@
 // A is assumed to be the first scan in time order
 static bool areScansCompatible(const VexScan *A, const VexScan *B, const CorrParams *P)
 {
-	if(((B->mjdStart < A->mjdStop) && (fabs(B->mjdStart-A->mjdStop) > 1.0e-8)) ||
+	if((B->mjdStart < A->mjdStop) ||
 	   (B->mjdStart > A->mjdStop + P->maxGap))
 	{
 		return false;
 	}
-	if(A->overlap(*B) >= -0.1/86400.0)
+	if(A->overlap_nanoseconds(*B) >= -VexTime::NanosecondsPerSecond/10)
 	{
 		return false;
 	}
@@ -62,70 +63,99 @@ static bool areScansCompatible(const VexScan *A, const VexScan *B, const CorrPar
 
 // Divides scans into different groups where each group contains scans that can be correlated at the same time.
 // This does not pay attention to media or clock breaks
-static void genJobGroups(std::vector<JobGroup> &JGs, const VexData *V, const CorrParams *P, const std::list<Event> &events, int verbose)
+//
+// Groups are seeded in vex order.  Each group is then extended one scan at a time by the
+// earliest (in vex order) remaining scan after the current last scan that has the same
+// correlator setup and is compatible with it.  Since compatible scans must start within
+// maxGap of the end of the previous one, candidates are found with a binary search over
+// the scans sorted by start time rather than by visiting every remaining scan.
+static void genJobGroups(std::vector<JobGroup> &JGs, const VexData *V, const CorrParams *P, const EventTimeline &events, int verbose)
 {
 	unsigned int nNoRecordScan = 0;
-	std::list<std::string> scans;
-	V->getScanList(scans);
+	unsigned int nScan = V->nScan();
+	std::vector<const CorrSetup *> corrSetups(nScan);		// resolved setup for each scan
+	std::vector<bool> inRange(nScan);				// true if scan overlaps .v2d mjdStart/mjdStop
+	std::vector<bool> used(nScan, false);				// true once a scan is grouped or dropped
+	std::vector<std::pair<double,unsigned int> > byStart(nScan);	// (mjdStart, scan index), sorted
 
-	while(!scans.empty())
+	for(unsigned int s = 0; s < nScan; ++s)
 	{
-		const VexScan *scan = V->getScanByDefName(scans.front());
+		const VexScan *scan = V->getScan(s);
+		const std::string &corrSetupName = P->findSetup(scan->defName, scan->sourceDefName, scan->modeDefName);
+
+		corrSetups[s] = P->getCorrSetup(corrSetupName);
+		inRange[s] = (P->overlap(*scan) > 0.0);
+		byStart[s] = std::pair<double,unsigned int>(scan->mjdStart, s);
+	}
+	std::sort(byStart.begin(), byStart.end());
+
+	for(unsigned int s = 0; s < nScan; ++s)
+	{
+		if(used[s])
+		{
+			continue;
+		}
+		used[s] = true;
+
+		const VexScan *scan = V->getScan(s);
 		unsigned int nRecordedAnt = V->nAntennasWithRecordedData(*scan);
 
 		if(nRecordedAnt < P->minSubarraySize)
 		{
 			if(verbose > 2)
 			{
-				std::cout << "Skipping scan " << scans.front() << " because it has no recorded data." << std::endl;
+				std::cout << "Skipping scan " << scan->defName << " because it has no recorded data." << std::endl;
 			}
 			
-			scans.pop_front();
 			++nNoRecordScan;
 
 			continue;
 		}
 		JGs.push_back(JobGroup());
 		JobGroup &JG = JGs.back();
-		JG.scans.push_back(scans.front());
+		JG.scans.push_back(scan->defName);
 		JG.setTimeRange(*scan);
-		scans.pop_front();
-
-		const VexScan *scan1 = V->getScanByDefName(JG.scans.back());
-		const std::string &corrSetupName1 = P->findSetup(scan1->defName, scan1->sourceDefName, scan1->modeDefName);
-		const CorrSetup *corrSetup1 = P->getCorrSetup(corrSetupName1);
 
-		for(std::list<std::string>::iterator it = scans.begin(); it != scans.end();)
+		unsigned int last = s;
+		for(;;)
 		{
-			const VexScan *scan2 = V->getScanByDefName(*it);
-			const std::string &corrSetupName2 = P->findSetup(scan2->defName, scan2->sourceDefName, scan2->modeDefName);
-			const CorrSetup *corrSetup2 = P->getCorrSetup(corrSetupName2);
+			const VexScan *scan1 = V->getScan(last);
+			const CorrSetup *corrSetup1 = corrSetups[last];
+			int next = -1;
 
-			// Skip any scans that don't overlap with .v2d mjdStart and mjdStop
-			if(P->overlap(*scan2) <= 0.0)
+			// Any scan passing areScansCompatible() starts within [mjdStop - 1e-8, mjdStop + maxGap]; pad slightly
+			std::vector<std::pair<double,unsigned int> >::const_iterator it = std::lower_bound(byStart.begin(), byStart.end(), std::pair<double,unsigned int>(scan1->mjdStop - 1.0e-7, 0));
+			for(; it != byStart.end() && it->first <= scan1->mjdStop + P->maxGap + 1.0e-7; ++it)
 			{
-				++it;
+				unsigned int c = it->second;
 
-				continue;
-			}
+				// Skip any scans that don't overlap with .v2d mjdStart and mjdStop
+				if(c <= last || used[c] || !inRange[c] || (next >= 0 && c > static_cast<unsigned int>(next)))
+				{
+					continue;
+				}
 
 #warning "FIXME: verify modes are compatible"
-			// Note: here we are forcing any change in correlator setup to cause new job, even if setups are compatible. 
-			// Revisit this in the future after DiFX 2.5 release.  Original, more general, test is below:
-			//    if(areCorrSetupsCompatible(corrSetup1, corrSetup2, P) && areScansCompatible(scan1, scan2, P))
-			
-			if(corrSetup1 == corrSetup2 && areScansCompatible(scan1, scan2, P))
-			{
-				JG.logicalOr(*scan2);	// expand jobGroup time to include this scan
-				JG.scans.push_back(*it);
-				it = scans.erase(it);
-				scan1 = scan2;
-				corrSetup1 = corrSetup2;
+				// Note: here we are forcing any change in correlator setup to cause new job, even if setups are compatible. 
+				// Revisit this in the future after DiFX 2.5 release.  Original, more general, test is below:
+				//    if(areCorrSetupsCompatible(corrSetup1, corrSetup2, P) && areScansCompatible(scan1, scan2, P))
+
+				if(corrSetup1 == corrSetups[c] && areScansCompatible(scan1, V->getScan(c), P))
+				{
+					next = c;
+				}
 			}
-			else
-			{	
-				++it;
+
+			if(next < 0)
+			{
+				break;
 			}
+
+			const VexScan *scan2 = V->getScan(next);
+			JG.logicalOr(*scan2);	// expand jobGroup time to include this scan
+			JG.scans.push_back(scan2->defName);
+			used[next] = true;
+			last = next;
 		}
 	}
 
@@ -141,9 +171,117 @@ static void genJobGroups(std::vector<JobGroup> &JGs, const VexData *V, const Cor
 	}
 }
 
-static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V, const CorrParams *P, int verbose)
+static int64_t gcd(int64_t a, int64_t b)
 {
-	std::map<std::string,double> recordStop;
+	while(b != 0)
+	{
+		int64_t r = a % b;
+		a = b;
+		b = r;
+	}
+
+	return a;
+}
+
+// Returns the length [ns] of the time slices for a scan: a whole number of seconds, integrations
+// and subintegrations close to sliceLength, or 0 if the setup does not allow slicing.
+static int64_t calcSliceNS(const CorrSetup *corrSetup, double sliceLength)
+{
+	int64_t unitNS = VexTime::NanosecondsPerSecond;
+	int64_t tIntNS = static_cast<int64_t>(1.0e9*corrSetup->tInt + 0.5);
+	int64_t nUnit;
+
+	if(tIntNS <= 0)
+	{
+		return 0;
+	}
+	unitNS = unitNS/gcd(unitNS, tIntNS)*tIntNS;
+	if(corrSetup->subintNS > 0)
+	{
+		unitNS = unitNS/gcd(unitNS, corrSetup->subintNS)*corrSetup->subintNS;
+	}
+
+	nUnit = static_cast<int64_t>(sliceLength*86400.0e9/unitNS + 0.5);
+	if(nUnit < 1)
+	{
+		nUnit = 1;
+	}
+
+	return nUnit*unitNS;
+}
+
+// Adds breaks that cut each scan longer than sliceLength into slices on the scan's own integration grid.
+// No slice shorter than half a slice is made, either at the scan end or next to an existing break such as a media change.
+static void addSliceBreaks(std::list<double> &breaks, const JobGroup &JG, const VexData *V, const CorrParams *P, const EventTimeline &events, const Interval &scanRange, int verbose)
+{
+	std::vector<double> otherBreaks(breaks.begin(), breaks.end());
+	std::vector<Event>::const_iterator s;
+	unsigned int id = EventTimeline::NoName;
+
+	for(std::vector<Event>::const_iterator e = JG.events.begin(); e != JG.events.end(); ++e)
+	{
+		if(e->eventType == Event::SCAN_START)
+		{
+			s = e;
+			id = e->nameId;
+		}
+		if(e->eventType != Event::SCAN_STOP || id != e->nameId)
+		{
+			continue;
+		}
+
+		Interval scanTimeRange(s->mjd, e->mjd);
+		scanTimeRange.logicalAnd(scanRange);
+		if(scanTimeRange.duration() <= P->sliceLength)
+		{
+			continue;
+		}
+
+		const VexScan *scan = V->getScanByDefName(events.getName(id));
+		const CorrSetup *corrSetup = P->getCorrSetup(P->findSetup(scan->defName, scan->sourceDefName, scan->modeDefName));
+		if(!corrSetup)
+		{
+			continue;
+		}
+		int64_t sliceNS = calcSliceNS(corrSetup, P->sliceLength);
+		if(sliceNS <= 0)
+		{
+			continue;
+		}
+
+		int nSlice = 1;
+		VexTime t = scanTimeRange.mjdStart;
+		for(t.addNanoseconds(sliceNS); scanTimeRange.mjdStop.nanosecondsSince(t) >= sliceNS/2; t.addNanoseconds(sliceNS))
+		{
+			bool nearBreak = false;
+
+			for(std::vector<double>::const_iterator b = otherBreaks.begin(); b != otherBreaks.end(); ++b)
+			{
+				int64_t dt = VexTime(*b).nanosecondsSince(t);
+
+				if(dt < sliceNS/2 && dt > -sliceNS/2)
+				{
+					nearBreak = true;
+					break;
+				}
+			}
+			if(!nearBreak)
+			{
+				breaks.push_back(t);
+				++nSlice;
+			}
+		}
+
+		if(verbose > 0 && nSlice > 1)
+		{
+			std::cout << "Scan " << scan->defName << " cut into " << nSlice << " slices of " << (sliceNS*1.0e-9) << " seconds" << std::endl;
+		}
+	}
+}
+
+static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V, const CorrParams *P, const EventTimeline &events, int verbose)
+{
+	std::map<unsigned int,double> recordStop;	// indexed by antenna name id
 	std::map<double,int> usage;
 	std::map<double,int> clockBreaks;
 	int nClockBreaks = 0;
@@ -158,12 +296,16 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 	Interval scanRange;
 
 	// first initialize recordStop and usage
-	for(std::list<Event>::const_iterator e = JG.events.begin(); e != JG.events.end(); ++e)
+	// recordStop covers all recording antennas in the experiment, not just those recording during this group
+	for(std::vector<Event>::const_iterator e = events.getRecordEvents().begin(); e != events.getRecordEvents().end(); ++e)
 	{
 		if(e->eventType == Event::RECORD_START)
 		{
-			recordStop[e->name] = -1.0;
+			recordStop[e->nameId] = -1.0;
 		}
+	}
+	for(std::vector<Event>::const_iterator e = JG.events.begin(); e != JG.events.end(); ++e)
+	{
 		if(e->eventType == Event::SCAN_START && (scanRange.mjdStart < 1.0 || e->mjd < scanRange.mjdStart))
 		{
 			scanRange.mjdStart = e->mjd;
@@ -182,7 +324,7 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 
 
 	// populate changes, times, and usage
-	for(std::list<Event>::const_iterator e = JG.events.begin(); e != JG.events.end(); ++e)
+	for(std::vector<Event>::const_iterator e = JG.events.begin(); e != JG.events.end(); ++e)
 	{
 		if(mjdLast > 0.0 && e->mjd > mjdLast)
 		{
@@ -205,23 +347,23 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 
 		if(e->eventType == Event::RECORD_START)
 		{
-			if(recordStop[e->name] > 0.0)
+			if(recordStop[e->nameId] > 0.0)
 			{
-				if(JG.containsAbsolutely(recordStop[e->name]) &&
+				if(JG.containsAbsolutely(recordStop[e->nameId]) &&
 				   JG.containsAbsolutely(e->mjd) &&
 				   scanRange.containsAbsolutely(e->mjd))
 				{
-					changes.push_back(MediaChange(e->name, recordStop[e->name], e->mjd));
+					changes.push_back(MediaChange(events.getName(*e), recordStop[e->nameId], e->mjd));
 					if(verbose > 0)
 					{
-						std::cout << "Media change: " << e->name << " " << (Interval)(changes.back()) << std::endl;
+						std::cout << "Media change: " << events.getName(*e) << " " << (Interval)(changes.back()) << std::endl;
 					}
 				}
 			}
 		}
 		else if(e->eventType == Event::RECORD_STOP)
 		{
-			recordStop[e->name] = e->mjd;
+			recordStop[e->nameId] = e->mjd;
 		}
 		else if(e->eventType == Event::ANT_SCAN_START)
 		{
@@ -257,10 +399,12 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 			std::cerr << "Developer error: jobs not converging after " << nLoop << " tries.\n" << std::endl;
 
 			std::cerr << "Events:" << std::endl;
-			std::list<Event>::const_iterator iter;
+			std::vector<Event>::const_iterator iter;
 			for(iter = JG.events.begin(); iter != JG.events.end(); ++iter)
 			{
-				std::cerr << "   " << *iter << std::endl;
+				std::cerr << "   ";
+				events.print(std::cerr, *iter);
+				std::cerr << std::endl;
 			}
 
 			std::cerr << "nClockBreaks = " << nClockBreaks << std::endl;
@@ -305,6 +449,10 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 			}
 		}
 	}
+	if(P->sliceLength > 0.0)
+	{
+		addSliceBreaks(breaks, JG, V, P, events, scanRange, verbose);
+	}
 	breaks.sort();
 
 	// Add a break at end so num breaks = num jobs
@@ -317,7 +465,7 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 		Interval jobTimeRange(start, *t);
 		if(jobTimeRange.duration() > P->minLength)
 		{
-			JG.createJobs(Js, jobTimeRange, V, P->minLength, P->maxLength, P->maxSize);
+			JG.createJobs(Js, jobTimeRange, V, P, events);
 		}
 		else
 		{
@@ -327,9 +475,54 @@ static void genJobs(std::vector<Job> &Js, const JobGroup &JG, const VexData *V,
 	}
 }
 
-void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, std::list<Event> &events, std::list<std::pair<int,std::string> > &removedAntennas, int verbose)
+// Summarize how evenly the estimated correlation cost is spread over the jobs that will be written
+static void reportJobOps(const std::vector<Job> &J)
+{
+	unsigned int n = 0;
+	double total = 0.0, sumSquare = 0.0;
+	double minOps = 0.0, maxOps = 0.0;
+	double mean, rms;
+	int p;
+
+	for(std::vector<Job>::const_iterator j = J.begin(); j != J.end(); ++j)
+	{
+		if(j->jobSeries == "-")
+		{
+			continue;
+		}
+		if(n == 0 || j->ops < minOps)
+		{
+			minOps = j->ops;
+		}
+		if(n == 0 || j->ops > maxOps)
+		{
+			maxOps = j->ops;
+		}
+		total += j->ops;
+		sumSquare += j->ops*j->ops;
+		++n;
+	}
+
+	if(n == 0 || total <= 0.0)
+	{
+		return;
+	}
+
+	mean = total/n;
+	rms = sqrt(fabs(sumSquare/n - mean*mean));
+
+	p = std::cout.precision();
+	std::cout.precision(4);
+	std::cout << "Estimated job cost: " << n << " jobs, " << (total*1.0e-12) << " Tops total; per job min/mean/max = "
+		<< (minOps*1.0e-12) << "/" << (mean*1.0e-12) << "/" << (maxOps*1.0e-12) << " Tops" << std::endl;
+	std::cout << "  Imbalance: max/mean = " << (maxOps/mean) << "  rms/mean = " << (rms/mean) << std::endl;
+	std::cout.precision(p);
+}
+
+void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, EventTimeline &events, std::list<std::pair<int,std::string> > &removedAntennas, int verbose)
 {
 	std::vector<JobGroup> JG;
+	size_t nEvent;
 
 	// Do splitting of jobs
 	genJobGroups(JG, V, P, events, verbose);
@@ -345,9 +538,11 @@ void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, std::l
 
 	for(std::vector<JobGroup>::const_iterator jg = JG.begin(); jg != JG.end(); ++jg)
 	{
-		genJobs(J, *jg, V, P, verbose);
+		genJobs(J, *jg, V, P, events, verbose);
 	}
 
+	nEvent = events.size();
+
 	// Finalize all the new job structures
 	int jobId = P->startSeries;
 	for(std::vector<Job>::iterator j = J.begin(); j != J.end(); ++j)
@@ -360,8 +555,8 @@ void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, std::l
 		// becomes part of the filenames
 		name << j->jobSeries << "_" << j->jobId;
 
-		addEvent(events, j->mjdStart, Event::JOB_START, name.str());
-		addEvent(events, j->mjdStop,  Event::JOB_STOP,  name.str());
+		events.add(j->mjdStart, Event::JOB_START, name.str());
+		events.add(j->mjdStop,  Event::JOB_STOP,  name.str());
 
 		// finds antennas that are active during at least a subset of the jobs scans and have media
 		j->assignAntennas(*V, removedAntennas, P->sortAntennas);
@@ -396,5 +591,10 @@ void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, std::l
 		}
 		++jobId;
 	}
-	events.sort();
+	events.merge(nEvent);
+
+	if(verbose > 0 || P->maxOps > 0.0 || P->targetOps > 0.0)
+	{
+		reportJobOps(J);
+	}
 }
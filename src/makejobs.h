@@ -38,6 +38,6 @@
 #include "job.h"
 #include "corrparams.h"
 
-void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, std::list<Event> &events, std::list<std::pair<int,std::string> > &removedAntennas, int verbose);
+void makeJobs(std::vector<Job>& J, const VexData *V, const CorrParams *P, EventTimeline &events, std::list<std::pair<int,std::string> > &removedAntennas, int verbose);
 
 #endif
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <vexdatamodel.h>
+#include "pulsarcache.h"
+
+PulsarConfigCache::~PulsarConfigCache()
+{
+	if(D)
+	{
+		deleteDifxInput(D);
+	}
+}
+
+void PulsarConfigCache::add(const std::string &binConfigFile)
+{
+	entries[binConfigFile].pulsarId = -1;
+}
+
+void PulsarConfigCache::load(int verbose)
+{
+	if(D || entries.empty())
+	{
+		return;
+	}
+
+	D = newDifxInput();
+	D->pulsar = newDifxPulsarArray(entries.size());
+	D->nPulsar = 0;
+
+	for(std::map<std::string,Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		const std::string &binConfigFile = it->first;
+		Entry &E = it->second;
+		std::vector<std::pair<double,double> > ranges;
+		const DifxPulsar *dp;
+		int ok;
+
+		ok = checkCRLF(binConfigFile.c_str(), (verbose > 1));
+		if(ok < 0)
+		{
+			std::cerr << "The pulsar bin config file " << binConfigFile << " has problems.  Exiting." << std::endl;
+
+			exit(EXIT_FAILURE);
+		}
+
+		E.pulsarId = D->nPulsar;
+		loadPulsarConfigFile(D, binConfigFile.c_str());
+		dp = D->pulsar + E.pulsarId;
+
+		for(int p = 0; p < dp->nPolyco; ++p)
+		{
+			const DifxPolyco *pc = dp->polyco + p;
+
+			ok = checkCRLF(pc->fileName, (verbose > 1));
+			if(ok < 0)
+			{
+				std::cerr << "The pulsar polyco file " << pc->fileName << " has problems.  Exiting." << std::endl;
+
+				exit(EXIT_FAILURE);
+			}
+
+			// each polynomial is centered on mjd and valid for nBlk minutes
+			ranges.push_back(std::pair<double,double>(pc->mjd - pc->nBlk/2880.0, pc->mjd + pc->nBlk/2880.0));
+		}
+
+		// merge into disjoint spans
+		sort(ranges.begin(), ranges.end());
+		for(std::vector<std::pair<double,double> >::const_iterator r = ranges.begin(); r != ranges.end(); ++r)
+		{
+			if(!E.spans.empty() && r->first <= E.spans.back().second)
+			{
+				E.spans.back().second = std::max(E.spans.back().second, r->second);
+			}
+			else
+			{
+				E.spans.push_back(*r);
+			}
+		}
+	}
+}
+
+const DifxPulsar *PulsarConfigCache::find(const std::string &binConfigFile) const
+{
+	std::map<std::string,Entry>::const_iterator it = entries.find(binConfigFile);
+
+	if(it == entries.end() || it->second.pulsarId < 0 || !D)
+	{
+		return 0;
+	}
+
+	return D->pulsar + it->second.pulsarId;
+}
+
+bool PulsarConfigCache::covers(const std::string &binConfigFile, double mjdStart, double mjdStop) const
+{
+	std::map<std::string,Entry>::const_iterator it = entries.find(binConfigFile);
+
+	if(it == entries.end())
+	{
+		return false;
+	}
+	for(std::vector<std::pair<double,double> >::const_iterator s = it->second.spans.begin(); s != it->second.spans.end(); ++s)
+	{
+		if(s->first <= mjdStart && s->second >= mjdStop)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+/*
+This is a helper class used within vex2difx.cpp
+*/
+
+#ifndef __PULSARCACHE_H__
+#define __PULSARCACHE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <difxio/difx_input.h>
+
+// Pulsar bin configurations and their polycos, each read and checked once per run
+// and then copied into the pulsar table of every job that uses them.
+class PulsarConfigCache
+{
+public:
+	PulsarConfigCache() : D(0) {}
+	~PulsarConfigCache();
+
+	// Call for each bin config file used by any job before load()
+	void add(const std::string &binConfigFile);
+
+	// Reads all of the bin config files and polycos, exiting on failure; not thread safe
+	void load(int verbose);
+
+	// Returns the loaded pulsar, or 0 if not cached.  May be called concurrently after load().
+	const DifxPulsar *find(const std::string &binConfigFile) const;
+
+	// True if the polycos of binConfigFile span the whole of mjdStart to mjdStop
+	bool covers(const std::string &binConfigFile, double mjdStart, double mjdStop) const;
+
+private:
+	class Entry
+	{
+	public:
+		int pulsarId;					// index into D->pulsar
+		std::vector<std::pair<double,double> > spans;	// disjoint, sorted MJD ranges of the polycos
+	};
+
+	PulsarConfigCache(const PulsarConfigCache &);
+	PulsarConfigCache &operator=(const PulsarConfigCache &);
+
+	DifxInput *D;		// holds the pulsar table of all loaded files
+	std::map<std::string,Entry> entries;
+};
+
+#endif
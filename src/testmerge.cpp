@@ -58,7 +58,7 @@ int main(int argc, char **argv)
 	VexData *V;
 	const VexScan * S;
 	const SourceSetup * sourceSetup;
-	list<Event> events;
+	EventTimeline events;
 	set<std::string> canonicalVDIFUsers;
 	string shelfFile;
 	string missingDataFile;	// created if file-based and no files for a particular antenna/job are found
@@ -38,10 +38,15 @@
 #include <algorithm>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <difxio/difx_input.h>
 #include <difxmessage.h>
 #include <vexdatamodel.h>
 
+#include "configcache.h"
+#include "ephemcache.h"
+#include "pulsarcache.h"
 #include "corrparams.h"
 #include "freq.h"
 #include "job.h"
@@ -62,6 +67,10 @@ const string author("Walter Brisken/Adam Deller");
 
 const int defaultMaxNSBetweenACAvg = 2000000;	// 2ms, good default for use with transient detection
 
+// Cleared, atomically, the first time the warning is issued by any job
+static int firstChanBWWarning = 1;
+static pthread_mutex_t spiceLock = PTHREAD_MUTEX_INITIALIZER;	// serializes SPICE use by the job writing threads
+
 static int calculateWorstcaseGuardNS(double sampleRate, int subintNS, int nBit, int nSubband)
 {
 	double sampleTimeNS = 1.0e9/sampleRate;
@@ -335,12 +344,13 @@ static DifxDatastream *makeDifxDatastreams(const Job& J, const VexData *V, int n
 					break;
 				case DataSourceFile:
 					{
-						int nFile = ant->files.size();
+						vector<unsigned int> fileIds;
 						int count = 0;
 
-						for(int j = 0; j < nFile; ++j)
+						ant->getFileIndex().getOverlapping(fileIds, J);
+						for(vector<unsigned int>::const_iterator j = fileIds.begin(); j != fileIds.end(); ++j)
 						{
-							if(ant->files[j].streamId == d && J.overlap(ant->files[j]) > 0.0)
+							if(ant->files[*j].streamId == d)
 							{
 								++count;
 							}
@@ -350,11 +360,11 @@ static DifxDatastream *makeDifxDatastreams(const Job& J, const VexData *V, int n
 
 						count = 0;
 
-						for(int j = 0; j < nFile; ++j)
+						for(vector<unsigned int>::const_iterator j = fileIds.begin(); j != fileIds.end(); ++j)
 						{
-							if(ant->files[j].streamId == d && J.overlap(ant->files[j]) > 0.0)
+							if(ant->files[*j].streamId == d)
 							{
-								dd->file[count] = strdup(ant->files[j].filename.c_str());
+								dd->file[count] = strdup(ant->files[*j].filename.c_str());
 								++count;
 							}
 						}
@@ -363,12 +373,13 @@ static DifxDatastream *makeDifxDatastreams(const Job& J, const VexData *V, int n
 				case DataSourceMark6: 
 					{
 						// mark6 has both files and vsns
-						int nFile = ant->files.size();
+						vector<unsigned int> fileIds;
 						int count = 0;
 
-						for(int j = 0; j < nFile; ++j)
+						ant->getFileIndex().getOverlapping(fileIds, J);
+						for(vector<unsigned int>::const_iterator j = fileIds.begin(); j != fileIds.end(); ++j)
 						{
-							if(ant->files[j].streamId == d && J.overlap(ant->files[j]) > 0.0)
+							if(ant->files[*j].streamId == d)
 							{
 								++count;
 							}
@@ -378,24 +389,25 @@ static DifxDatastream *makeDifxDatastreams(const Job& J, const VexData *V, int n
 
 						count = 0;
 
-						for(int j = 0; j < nFile; ++j)
+						for(vector<unsigned int>::const_iterator j = fileIds.begin(); j != fileIds.end(); ++j)
 						{
-							if(ant->files[j].streamId == d && J.overlap(ant->files[j]) > 0.0)
+							if(ant->files[*j].streamId == d)
 							{
-								dd->file[count] = strdup(ant->files[j].filename.c_str());
+								dd->file[count] = strdup(ant->files[*j].filename.c_str());
 								++count;
 							}
 						}
 						
 						string sVSN;
-						int nVSN = ant->vsns.size();
+						vector<unsigned int> vsnIds;
 						count = 0;
 
-						for(int j = 0; j < nVSN; ++j)
+						ant->getVSNIndex().getOverlapping(vsnIds, J);
+						for(vector<unsigned int>::const_iterator j = vsnIds.begin(); j != vsnIds.end(); ++j)
 						{
-							if(ant->vsns[j].streamId == d && J.overlap(ant->vsns[j]) > 0.0)
+							if(ant->vsns[*j].streamId == d)
 							{
-								sVSN = ant->vsns[j].filename;
+								sVSN = ant->vsns[*j].filename;
 								++count;
 							}
 						}
@@ -409,15 +421,16 @@ static DifxDatastream *makeDifxDatastreams(const Job& J, const VexData *V, int n
 					break;
 				case DataSourceModule:
 					{
-						int nVSN = ant->vsns.size();
+						vector<unsigned int> vsnIds;
 						int count = 0;
 						
 						DifxDatastreamAllocFiles(dd, 1);
-						for(int j = 0; j < nVSN; ++j)
+						ant->getVSNIndex().getOverlapping(vsnIds, J);
+						for(vector<unsigned int>::const_iterator j = vsnIds.begin(); j != vsnIds.end(); ++j)
 						{
-							if(ant->vsns[j].streamId == d && J.overlap(ant->vsns[j]) > 0.0)
+							if(ant->vsns[*j].streamId == d)
 							{
-								dd->file[0] = strdup(ant->vsns[j].filename.c_str());
+								dd->file[0] = strdup(ant->vsns[*j].filename.c_str());
 								++count;
 							}
 						}
@@ -485,30 +498,14 @@ static int getBand(vector<pair<int,int> >& bandMap, int fqId)
 	return bandMap.size() - 1;
 }
 
-static int getToneSetId(vector<vector<unsigned int> > &toneSets, const vector<unsigned int> &tones)
-{
-	for(vector<vector<unsigned int> >::const_iterator it = toneSets.begin(); it != toneSets.end(); ++it)
-	{
-		if(*it == tones)
-		{
-			return it - toneSets.begin();
-		}
-	}
-
-	// not in list yet, so add
-	toneSets.push_back(tones);
-
-	return toneSets.size() - 1;
-}
-
 // The information feeding this function (.vex and .v2d) considers a recorded channel to be one that was intended to be recorded.
 // Due to possible thread filtering in VDIF, the number of actually present channels could be less.
 // It is this number of present channels that is reported in the .input files as "recorded channels", so some room for confusion here.
 
 // FIXME: the name "startBand" is confusing.  
-static unsigned int setFormat(DifxInput *D, int dsId, vector<freq>& freqs, vector<vector<unsigned int> >& toneSets, const VexMode *mode, const string &antName, unsigned int startBand, const VexSetup &setup, const VexStream &stream, const CorrSetup *corrSetup, enum V2D_Mode v2dMode)
+static void makeDatastreamLayout(DatastreamLayout &layout, const VexMode *mode, const string &antName, unsigned int startBand, const VexSetup &setup, const VexStream &stream, enum V2D_Mode v2dMode)
 {
-	vector<pair<int,int> > bandMap;
+	char dataFormat[DIFXIO_FORMAT_LENGTH];
 	unsigned int streamPresentChan = 0;	// "present channel" index
 
 	if(mode == 0)
@@ -518,19 +515,11 @@ static unsigned int setFormat(DifxInput *D, int dsId, vector<freq>& freqs, vecto
 		exit(EXIT_FAILURE);
 	}
 
-	// just check to make sure antId is legal
-	int antId = D->datastream[dsId].antennaId;
-	if(antId < 0 || antId >= D->nAntenna)
-	{
-		cerr << "Developer error: setFormat: antId=" << antId << " while nAntenna=" << D->nAntenna << endl;
-		
-		exit(EXIT_FAILURE);
-	}
-
-	stream.snprintDifxFormatName(D->datastream[dsId].dataFormat, DIFXIO_FORMAT_LENGTH);
-	D->datastream[dsId].dataFrameSize = stream.dataFrameSize();
-	D->datastream[dsId].quantBits = stream.nBit;
-	DifxDatastreamAllocBands(D->datastream + dsId, stream.nPresentChan());
+	stream.snprintDifxFormatName(dataFormat, DIFXIO_FORMAT_LENGTH);
+	layout.dataFormat = dataFormat;
+	layout.dataFrameSize = stream.dataFrameSize();
+	layout.quantBits = stream.nBit;
+	layout.bands.clear();
 
 	for(unsigned int i = 0; i < stream.nRecordChan; ++i)
 	{
@@ -551,15 +540,15 @@ static unsigned int setFormat(DifxInput *D, int dsId, vector<freq>& freqs, vecto
 		int setupRecChan = ch->recordChan;
 		if(setupRecChan >= 0)
 		{
-			unsigned int toneSetId, fqId;
 			const VexSubband& subband = mode->subbands[ch->subbandId];
 			int streamRecChan;
+			DatastreamBand band;
 
 			streamRecChan = setupRecChan - startBand;
 			if(streamRecChan < 0 || streamRecChan >= stream.nRecordChan)
 			{
 				cerr << "Error: setFormat: index to stream record channel=" << streamRecChan << " is out of range.  antName=" << antName << " mode=" << mode->defName << endl;
-				cerr << "nRecBand = " << D->datastream[dsId].nRecBand << endl;
+				cerr << "nRecBand = " << stream.nPresentChan() << endl;
 				cerr << "startBand = " << startBand << endl;
 				cerr << "subband = " << mode->subbands[ch->subbandId] << endl;
 				cerr << "nRecordChan = " << stream.nRecordChan << "  i = " << i << "  streamRecChan = " << streamRecChan << "  streamPresentChan = " << streamPresentChan << endl;
@@ -572,37 +561,28 @@ static unsigned int setFormat(DifxInput *D, int dsId, vector<freq>& freqs, vecto
 				continue;
 			}
 			
-			if(v2dMode == V2D_MODE_PROFILE || setup.phaseCalIntervalMHz() == 0)
-			{
-				// In profile mode don't extract any tones
-				toneSetId = 0;
-			}
-			else
+			band.freq = subband.freq;
+			band.bandwidth = subband.bandwidth;
+			band.sideBand = subband.sideBand;
+			band.pol = subband.pol;
+
+			// In profile mode don't extract any tones
+			band.extractTones = !(v2dMode == V2D_MODE_PROFILE || setup.phaseCalIntervalMHz() == 0);
+			if(band.extractTones)
 			{
-				toneSetId = getToneSetId(toneSets, ch->tones);
+				band.tones = ch->tones;
 			}
-			
-			fqId = getFreqId(freqs, subband.freq, subband.bandwidth, subband.sideBand, corrSetup->FFTSpecRes, corrSetup->outputSpecRes, 1, 0, toneSetId);	// 0 means not zoom band
-
-			// index into the difxio datastream object arrays is by "present band"
-			D->datastream[dsId].recBandFreqId[streamPresentChan] = getBand(bandMap, fqId);
-			D->datastream[dsId].recBandPolName[streamPresentChan] = subband.pol;
 
 			// Mark threads to be ignored by changing polarization to lower case
 			if(stream.recordChanIgnore(streamRecChan))
 			{
-				D->datastream[dsId].recBandPolName[streamPresentChan] += ('a'-'A');
+				band.pol += ('a'-'A');
 			}
 
+			layout.bands.push_back(band);
 			++streamPresentChan;
 		}
 	}
-	DifxDatastreamAllocFreqs(D->datastream + dsId, bandMap.size());
-	for(size_t j = 0; j < bandMap.size(); ++j)
-	{
-		D->datastream[dsId].recFreqId[j] = bandMap[j].first;
-		D->datastream[dsId].nRecPol[j]   = bandMap[j].second;
-	}
 
 	if(streamPresentChan != stream.nPresentChan())
 	{
@@ -610,8 +590,64 @@ static unsigned int setFormat(DifxInput *D, int dsId, vector<freq>& freqs, vecto
 
 		exit(EXIT_FAILURE);
 	}
+}
+
+// Returns the layout of one datastream, deriving it from the vex only the first time it is needed by any job
+static const DatastreamLayout *getDatastreamLayout(ConfigCache &cache, const VexMode *mode, const string &antName, unsigned int streamId, unsigned int startBand, const VexSetup &setup, enum V2D_Mode v2dMode)
+{
+	const DatastreamLayout *layout;
+
+	layout = cache.findLayout(mode->defName, antName, streamId);
+	if(!layout)
+	{
+		DatastreamLayout newLayout;
+
+		makeDatastreamLayout(newLayout, mode, antName, startBand, setup, setup.streams[streamId], v2dMode);
+		layout = cache.addLayout(mode->defName, antName, streamId, newLayout);
+	}
+
+	return layout;
+}
+
+static unsigned int setFormat(DifxInput *D, int dsId, FreqTable &freqs, ToneSetTable &toneSets, const DatastreamLayout &layout, const CorrSetup *corrSetup)
+{
+	vector<pair<int,int> > bandMap;
+	unsigned int nBand = layout.bands.size();
+
+	// just check to make sure antId is legal
+	int antId = D->datastream[dsId].antennaId;
+	if(antId < 0 || antId >= D->nAntenna)
+	{
+		cerr << "Developer error: setFormat: antId=" << antId << " while nAntenna=" << D->nAntenna << endl;
+		
+		exit(EXIT_FAILURE);
+	}
+
+	snprintf(D->datastream[dsId].dataFormat, DIFXIO_FORMAT_LENGTH, "%s", layout.dataFormat.c_str());
+	D->datastream[dsId].dataFrameSize = layout.dataFrameSize;
+	D->datastream[dsId].quantBits = layout.quantBits;
+	DifxDatastreamAllocBands(D->datastream + dsId, nBand);
+
+	for(unsigned int b = 0; b < nBand; ++b)
+	{
+		const DatastreamBand &band = layout.bands[b];
+		unsigned int toneSetId, fqId;
+
+		toneSetId = band.extractTones ? toneSets.getId(band.tones) : 0;
+		fqId = getFreqId(freqs, band.freq, band.bandwidth, band.sideBand, corrSetup->FFTSpecRes, corrSetup->outputSpecRes, 1, 0, toneSetId);	// 0 means not zoom band
+
+		// index into the difxio datastream object arrays is by "present band"
+		D->datastream[dsId].recBandFreqId[b] = getBand(bandMap, fqId);
+		D->datastream[dsId].recBandPolName[b] = band.pol;
+	}
+	DifxDatastreamAllocFreqs(D->datastream + dsId, bandMap.size());
+	for(size_t j = 0; j < bandMap.size(); ++j)
+	{
+		D->datastream[dsId].recFreqId[j] = bandMap[j].first;
+		D->datastream[dsId].nRecPol[j]   = bandMap[j].second;
+	}
 
-	return streamPresentChan;
+	return nBand;
 }
 
 static void populateRuleTable(DifxInput *D, const CorrParams *P)
@@ -664,14 +700,13 @@ static void populateRuleTable(DifxInput *D, const CorrParams *P)
 	}
 }
 
-static void populateFreqTable(DifxInput *D, const vector<freq>& freqs, const vector<vector<unsigned int> > &toneSets)
+static void populateFreqTable(DifxInput *D, const FreqTable &freqs, const ToneSetTable &toneSets)
 {
 	D->nFreq = freqs.size();
 	D->freq = newDifxFreqArray(D->nFreq);
 
 	for(int f = 0; f < D->nFreq; ++f)
 	{
-		static int firstChanBWWarning=1;
 		DifxFreq *df = D->freq + f;
 		double chanBW;
 
@@ -684,9 +719,8 @@ static void populateFreqTable(DifxInput *D, const vector<freq>& freqs, const vec
 		df->overSamp = 1;	// FIXME: eventually provide this again.
 
 		chanBW = freqs[f].outputSpecRes*1e-6;
-		if(chanBW > 0.51 && firstChanBWWarning)
+		if(chanBW > 0.51 && __sync_bool_compare_and_swap(&firstChanBWWarning, 1, 0))
 		{
-			firstChanBWWarning = 0;
 			cout << "Warning: channel bandwidth is " << chanBW << " MHz, which is larger than the minimum recommended 0.5 MHz.  Consider decreasing the output spectral resolution." << endl;
 		}
 
@@ -708,7 +742,280 @@ static void populateFreqTable(DifxInput *D, const vector<freq>& freqs, const vec
 	}
 }
 
-static double populateBaselineTable(DifxInput *D, const CorrParams *P, const CorrSetup *corrSetup, vector<set<int> > blockedfreqids)
+// Value of a DiFX frequency used to find a partner for it on the other side of a baseline
+class FreqKey
+{
+public:
+	FreqKey(double f, double b, char s = 0) : freq(f), bandwidth(b), sideBand(s) {}
+	bool operator < (const FreqKey &k) const
+	{
+		if(freq != k.freq)
+		{
+			return freq < k.freq;
+		}
+		if(bandwidth != k.bandwidth)
+		{
+			return bandwidth < k.bandwidth;
+		}
+
+		return sideBand < k.sideBand;
+	}
+
+	double freq;		// MHz; band edge or tuning depending on use
+	double bandwidth;	// MHz
+	char sideBand;		// 0 if not part of the key
+};
+
+// For one datastream, the frequency id that each partner search in populateBaselineTable()
+// would settle on.  Those searches keep the last match, so later entries replace earlier ones.
+class FreqPairIndex
+{
+public:
+	map<FreqKey,int> recByEdge;	// recorded, not ignored: (low edge, bandwidth)
+	map<FreqKey,int> recByEdgeAll;	// recorded: (low edge, bandwidth)
+	map<FreqKey,int> recUSBByFreq;	// recorded upper sideband: (frequency, bandwidth)
+	map<FreqKey,int> zoomByFreq;	// zoom: (frequency, bandwidth, sideband)
+	map<FreqKey,int> zoomByEdge;	// zoom: (low edge, bandwidth)
+};
+
+static int findFreq(const map<FreqKey,int> &index, const FreqKey &key)
+{
+	map<FreqKey,int>::const_iterator it = index.find(key);
+
+	if(it == index.end())
+	{
+		return -1;
+	}
+
+	return it->second;
+}
+
+static void makeFreqPairIndex(FreqPairIndex &index, const DifxInput *D, const DifxDatastream *dd, const set<int> &blocked)
+{
+	for(int f2 = 0; f2 < dd->nRecFreq; ++f2)
+	{
+		int altFreqId = dd->recFreqId[f2];
+		const DifxFreq *df = D->freq + altFreqId;
+		double altlowedgefreq;
+
+		if(blocked.find(altFreqId) != blocked.end())
+		{
+			continue;
+		}
+
+		altlowedgefreq = df->freq;
+		if(df->sideband == 'L')
+		{
+			altlowedgefreq -= df->bw;
+		}
+
+		index.recByEdgeAll[FreqKey(altlowedgefreq, df->bw)] = altFreqId;
+		if(!islower(dd->recBandPolName[f2]))
+		{
+			index.recByEdge[FreqKey(altlowedgefreq, df->bw)] = altFreqId;
+		}
+		if(df->sideband == 'U')
+		{
+			index.recUSBByFreq[FreqKey(df->freq, df->bw)] = altFreqId;
+		}
+	}
+
+	for(int f2 = 0; f2 < dd->nZoomFreq; ++f2)
+	{
+		int altFreqId = dd->zoomFreqId[f2];
+		const DifxFreq *df = D->freq + altFreqId;
+		double altlowedgefreq;
+
+		if(blocked.find(altFreqId) != blocked.end())
+		{
+			continue;
+		}
+
+		altlowedgefreq = df->freq;
+		if(df->sideband == 'L')
+		{
+			altlowedgefreq -= df->bw;
+		}
+
+		index.zoomByFreq[FreqKey(df->freq, df->bw, df->sideband)] = altFreqId;
+		index.zoomByEdge[FreqKey(altlowedgefreq, df->bw)] = altFreqId;
+	}
+}
+
+// Evaluates the baselines= list once per antenna pair; use[a1*nAntenna + a2] for a1 <= a2
+static void makeBaselineSelection(vector<bool> &use, const DifxInput *D, const CorrParams *P)
+{
+	use.assign(D->nAntenna*D->nAntenna, false);
+	for(int a1 = 0; a1 < D->nAntenna; ++a1)
+	{
+		for(int a2 = a1; a2 < D->nAntenna; ++a2)
+		{
+			use[a1*D->nAntenna + a2] = P->useBaseline(D->antenna[a1].name, D->antenna[a2].name);
+		}
+	}
+}
+
+// Appends to a baseline key one frequency of a datastream.  Frequency ids are replaced by their
+// order of first appearance, so jobs that number the same frequencies differently share a key.
+static void addFreqToKey(ostream &key, map<int,int> &localFreqIds, const DifxInput *D, const CorrSetup *corrSetup, int freqId, const set<int> *blocked)
+{
+	map<int,int>::const_iterator it = localFreqIds.find(freqId);
+
+	if(it == localFreqIds.end())
+	{
+		const DifxFreq *df = D->freq + freqId;
+		int localFreqId = localFreqIds.size();
+
+		localFreqIds[freqId] = localFreqId;
+		key << " [" << localFreqId << ' ' << df->freq << ' ' << df->bw << ' ' << df->sideband << ' ' << corrSetup->correlateFreqId(freqId) << ']';
+	}
+	else
+	{
+		key << ' ' << it->second;
+	}
+	if(blocked && blocked->find(freqId) != blocked->end())
+	{
+		key << '*';
+	}
+}
+
+// Describes by value everything the baseline pairing of one config depends on: the correlator setup,
+// and the antenna, frequencies and bands of each of its datastreams
+static string makeBaselineKey(const DifxInput *D, const DifxConfig *config, const CorrSetup *corrSetup, const vector<set<int> > &blockedfreqids)
+{
+	ostringstream key;
+	map<int,int> localFreqIds;
+
+	key.precision(17);
+	key << corrSetup->corrSetupName << '\n';
+	for(int configds = 0; configds < config->nDatastream; ++configds)
+	{
+		const DifxDatastream *dd = D->datastream + config->datastreamId[configds];
+		const set<int> *blocked = 0;
+
+		key << dd->antennaId;
+		if(dd->antennaId >= 0 && dd->antennaId < D->nAntenna)
+		{
+			key << ' ' << D->antenna[dd->antennaId].name;
+		}
+		if(dd->antennaId >= 0 && dd->antennaId < static_cast<int>(blockedfreqids.size()))
+		{
+			blocked = &blockedfreqids[dd->antennaId];
+		}
+		key << "\nR";
+		for(int f = 0; f < dd->nRecFreq; ++f)
+		{
+			addFreqToKey(key, localFreqIds, D, corrSetup, dd->recFreqId[f], blocked);
+		}
+		key << "\nr";
+		for(int b = 0; b < dd->nRecBand; ++b)
+		{
+			key << ' ' << dd->recBandFreqId[b] << dd->recBandPolName[b];
+		}
+		key << "\nZ";
+		for(int f = 0; f < dd->nZoomFreq; ++f)
+		{
+			addFreqToKey(key, localFreqIds, D, corrSetup, dd->zoomFreqId[f], blocked);
+		}
+		key << "\nz";
+		for(int b = 0; b < dd->nZoomBand; ++b)
+		{
+			key << ' ' << dd->zoomBandFreqId[b] << dd->zoomBandPolName[b];
+		}
+		key << '\n';
+	}
+
+	return key.str();
+}
+
+static int getConfigDatastreamIndex(const DifxConfig *config, int ds)
+{
+	for(int configds = 0; configds < config->nDatastream; ++configds)
+	{
+		if(config->datastreamId[configds] == ds)
+		{
+			return configds;
+		}
+	}
+
+	return -1;
+}
+
+// Copies out the baselines just paired up for config, which are all those it lists
+static void makeConfigBaselines(ConfigBaselines &baselines, const DifxInput *D, const DifxConfig *config, double bandwidth)
+{
+	baselines.globalBandwidth = bandwidth;
+	for(int c = 0; c < config->nBaseline; ++c)
+	{
+		const DifxBaseline *b = D->baseline + config->baselineId[c];
+		BaselinePattern pattern;
+
+		pattern.configDsA = getConfigDatastreamIndex(config, b->dsA);
+		pattern.configDsB = getConfigDatastreamIndex(config, b->dsB);
+		for(int f = 0; f < b->nFreq; ++f)
+		{
+			pattern.bandA.push_back(vector<int>(b->bandA[f], b->bandA[f] + b->nPolProd[f]));
+			pattern.bandB.push_back(vector<int>(b->bandB[f], b->bandB[f] + b->nPolProd[f]));
+		}
+		baselines.baselines.push_back(pattern);
+	}
+}
+
+// Appends the cached baselines of config to the baseline table at bl, advancing bl and blId
+static void applyConfigBaselines(DifxInput *D, DifxConfig *config, const ConfigBaselines &baselines, DifxBaseline *&bl, int &blId)
+{
+	for(vector<BaselinePattern>::const_iterator p = baselines.baselines.begin(); p != baselines.baselines.end(); ++p)
+	{
+		int nFreq = p->bandA.size();
+
+		if(config->nBaseline >= D->nBaseline)
+		{
+			std::cerr << "Developer error: populateBaselineTable: trying to add " << config->nBaseline+1 << "th baseline, but pre-allocated only D->nBaseline=" << D->nBaseline << ": skipping!" << std::endl;
+			continue;
+		}
+
+		bl->dsA = config->datastreamId[p->configDsA];
+		bl->dsB = config->datastreamId[p->configDsB];
+		DifxBaselineAllocFreqs(bl, nFreq);
+		for(int f = 0; f < nFreq; ++f)
+		{
+			int nPol = p->bandA[f].size();
+
+			DifxBaselineAllocPolProds(bl, f, nPol);
+			for(int u = 0; u < nPol; ++u)
+			{
+				bl->bandA[f][u] = p->bandA[f][u];
+				bl->bandB[f][u] = p->bandB[f][u];
+			}
+			bl->nPolProd[f] = nPol;
+		}
+		bl->nFreq = nFreq;
+
+		config->baselineId[config->nBaseline] = blId;
+		++config->nBaseline;
+		++bl;
+		++blId;
+	}
+}
+
+// Folds the bandwidth found for one config into that of the whole job; 0 means none yet and -1 that they differ
+static void mergeGlobalBandwidth(double &globalBandwidth, double bandwidth)
+{
+	if(bandwidth == 0)
+	{
+		return;
+	}
+	if(globalBandwidth == 0)
+	{
+		globalBandwidth = bandwidth;
+	}
+	else if(globalBandwidth > 0 && bandwidth != globalBandwidth)
+	{
+		globalBandwidth = -1;
+	}
+}
+
+static double populateBaselineTable(DifxInput *D, const CorrParams *P, const CorrSetup *corrSetup, vector<set<int> > blockedfreqids, ConfigCache &cache)
 {	
 	int n1, n2;
 	int nPol;
@@ -718,7 +1025,7 @@ static double populateBaselineTable(DifxInput *D, const CorrParams *P, const Cor
 	DifxBaseline *bl;
 	DifxConfig *config;
 	int freqId, altFreqId, blId, configId;
-	double lowedgefreq, altlowedgefreq;
+	double lowedgefreq;
 	double globalBandwidth = 0;
 
 	// Calculate maximum number of possible baselines based on list of configs
@@ -734,6 +1041,24 @@ static double populateBaselineTable(DifxInput *D, const CorrParams *P, const Cor
 	bl = D->baseline;
 	blId = 0;	// baseline table index
 
+	// The baselines= selection and the partner frequencies of each datastream do not depend on config
+	vector<bool> useBaseline;
+	vector<FreqPairIndex> freqPairIndex;
+	if(P->v2dMode != V2D_MODE_PROFILE)
+	{
+		makeBaselineSelection(useBaseline, D, P);
+		freqPairIndex.resize(D->nDatastream);
+		for(int ds = 0; ds < D->nDatastream; ++ds)
+		{
+			int antId = D->datastream[ds].antennaId;
+
+			if(antId >= 0 && antId < static_cast<int>(blockedfreqids.size()))
+			{
+				makeFreqPairIndex(freqPairIndex[ds], D, D->datastream + ds, blockedfreqids[antId]);
+			}
+		}
+	}
+
 	for(configId = 0; configId < D->nConfig; ++configId)
 	{
 		config = D->config + configId;
@@ -914,362 +1239,315 @@ static double populateBaselineTable(DifxInput *D, const CorrParams *P, const Cor
 				enda1 = D->nAntenna;
 				config->doAutoCorr = 0;
 			}
-			for(int a1 = 0; a1 < enda1; ++a1)
+
+			// datastreams of this config belonging to each antenna, in config order
+			vector<vector<int> > antennaDatastreams(D->nAntenna);
+			for(int configds = 0; configds < config->nDatastream; ++configds)
 			{
-				int starta2 = a1 + 1;
-				if(P->exhaustiveAutocorrs)
-				{
-					starta2 = a1;
-				}
-				for(int a2 = starta2; a2 < D->nAntenna; ++a2)
+				int ds, antId;
+
+				ds = config->datastreamId[configds];
+
+				if(ds >= D->nDatastream)
 				{
-					for(int configds1 = 0; configds1 < config->nDatastream; ++configds1)
-					{
-						int ds1;
+					std::cerr << "Developer error: populateBaselineTable pos 2: ds=" << ds << " , nDatastream=" << D->nDatastream << std::endl;
+					std::cerr << "configds=" << configds << " config->nDatastream=" << config->nDatastream << std::endl;
 
-						ds1 = config->datastreamId[configds1];
+					std::cerr << "All values of config->datastreamId[] array are:";
+					for(int y = 0; y < config->nDatastream; ++y)
+					{
+						std::cerr << " " << config->datastreamId[y];
+					}
+					std::cerr << std::endl;
 
-						if(ds1 >= D->nDatastream)
-						{
-							std::cerr << "Developer error: populateBaselineTable pos 2: ds1=" << ds1 << " , nDatastream=" << D->nDatastream << std::endl;
-							std::cerr << "configds1=" << configds1 << " config->nDatastream=" << config->nDatastream << " a1=" << a1 << std::endl;
+					exit(EXIT_FAILURE);
+				}
 
-							std::cerr << "All values of config->datastreamId[] array are:";
-							for(int y = 0; y < config->nDatastream; ++y)
-							{
-								std::cerr << " " << config->datastreamId[y];
-							}
-							std::cerr << std::endl;
+				antId = D->datastream[ds].antennaId;
+				if(antId >= 0 && antId < D->nAntenna)
+				{
+					antennaDatastreams[antId].push_back(ds);
+				}
+			}
 
-							exit(EXIT_FAILURE);
-						}
+			// Jobs with the same setup, antennas and bands pair up the same baselines
+			string baselineKey = makeBaselineKey(D, config, corrSetup, blockedfreqids);
+			const ConfigBaselines *cached = cache.findBaselines(baselineKey);
+			if(cached)
+			{
+				applyConfigBaselines(D, config, *cached, bl, blId);
+				mergeGlobalBandwidth(globalBandwidth, cached->globalBandwidth);
+			}
+			else
+			{
+				double configBandwidth = 0;
+				bool truncated = false;
 
-						if(a1 != D->datastream[ds1].antennaId)
+				for(int a1 = 0; a1 < enda1; ++a1)
+				{
+					int starta2 = a1 + 1;
+					if(P->exhaustiveAutocorrs)
+					{
+						starta2 = a1;
+					}
+					for(int a2 = starta2; a2 < D->nAntenna; ++a2)
+					{
+						// Excape if this baseline is not requested
+						if(!useBaseline[a1*D->nAntenna + a2])
 						{
 							continue;
 						}
 
-						for(int configds2 = 0; configds2 < config->nDatastream; ++configds2)
+						for(vector<int>::const_iterator it1 = antennaDatastreams[a1].begin(); it1 != antennaDatastreams[a1].end(); ++it1)
 						{
-							int ds2;
-
-							ds2 = config->datastreamId[configds2];
-							if(a2 != D->datastream[ds2].antennaId)
-							{
-								continue;
-							}
-							
-							// Excape if this baseline is not requested
-							if(!P->useBaseline(D->antenna[a1].name, D->antenna[a2].name))
-							{
-								continue;
-							}
+							int ds1 = *it1;
 
-							if (config->nBaseline >= D->nBaseline)
+							for(vector<int>::const_iterator it2 = antennaDatastreams[a2].begin(); it2 != antennaDatastreams[a2].end(); ++it2)
 							{
-								std::cerr << "Developer error: populateBaselineTable: trying to add " << config->nBaseline+1 << "th baseline for DS " << ds1 << " x " << ds2 << ", but pre-allocated only D->nBaseline=" << D->nBaseline << ": skipping!" << std::endl;
-								continue;
-							}
+								int ds2 = *it2;
+								const FreqPairIndex &pairs2 = freqPairIndex[ds2];
 
-							bl->dsA = ds1;
-							bl->dsB = ds2;
+								if (config->nBaseline >= D->nBaseline)
+								{
+									std::cerr << "Developer error: populateBaselineTable: trying to add " << config->nBaseline+1 << "th baseline for DS " << ds1 << " x " << ds2 << ", but pre-allocated only D->nBaseline=" << D->nBaseline << ": skipping!" << std::endl;
+									truncated = true;
+									continue;
+								}
 
-							// Allocate enough space for worst case possibility
-							DifxBaselineAllocFreqs(bl, D->datastream[ds1].nRecFreq + D->datastream[ds1].nZoomFreq);
+								bl->dsA = ds1;
+								bl->dsB = ds2;
 
-							nFreq = 0; // this counts the actual number of freqs
+								// Allocate enough space for worst case possibility
+								DifxBaselineAllocFreqs(bl, D->datastream[ds1].nRecFreq + D->datastream[ds1].nZoomFreq);
 
-							for(int f = 0; f < D->datastream[ds1].nRecFreq; ++f)
-							{
-								bool zoom2 = false;	// did antenna 2 zoom band make match? 
+								nFreq = 0; // this counts the actual number of freqs
 
-								freqId = D->datastream[ds1].recFreqId[f];
-
-								if(!corrSetup->correlateFreqId(freqId))
+								for(int f = 0; f < D->datastream[ds1].nRecFreq; ++f)
 								{
-									continue;
-								}
-								if(!blockedfreqids[a1].empty() && blockedfreqids[a1].find(freqId) != blockedfreqids[a1].end())
-								{
-									continue;
-								}
-								//if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(freqId) != blockedfreqids[a2].end())
-								//{
-								//	continue;
-								//}
+									bool zoom2 = false;	// did antenna 2 zoom band make match? 
 
-								if(islower(D->datastream[ds1].recBandPolName[f]))
-								{
-									continue;
-								}
+									freqId = D->datastream[ds1].recFreqId[f];
 
-								DifxBaselineAllocPolProds(bl, nFreq, 4);
+									if(!corrSetup->correlateFreqId(freqId))
+									{
+										continue;
+									}
+									if(!blockedfreqids[a1].empty() && blockedfreqids[a1].find(freqId) != blockedfreqids[a1].end())
+									{
+										continue;
+									}
+									//if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(freqId) != blockedfreqids[a2].end())
+									//{
+									//	continue;
+									//}
 
-								n1 = DifxDatastreamGetRecBands(D->datastream+ds1, freqId, a1p, a1c);
-								n2 = DifxDatastreamGetRecBands(D->datastream+ds2, freqId, a2p, a2c);
+									if(islower(D->datastream[ds1].recBandPolName[f]))
+									{
+										continue;
+									}
 
-								lowedgefreq = D->freq[freqId].freq;
-								if(D->freq[freqId].sideband == 'L')
-								{
-									lowedgefreq -= D->freq[freqId].bw;
-								}
+									DifxBaselineAllocPolProds(bl, nFreq, 4);
 
-								if(n2 == 0)
-								{
-									//look for another freqId which matches band but is opposite sideband
-									for(int f2 = 0; f2 < D->datastream[ds2].nRecFreq; ++f2)
+									n1 = DifxDatastreamGetRecBands(D->datastream+ds1, freqId, a1p, a1c);
+									n2 = DifxDatastreamGetRecBands(D->datastream+ds2, freqId, a2p, a2c);
+
+									lowedgefreq = D->freq[freqId].freq;
+									if(D->freq[freqId].sideband == 'L')
 									{
-										altFreqId = D->datastream[ds2].recFreqId[f2];
-										altlowedgefreq = D->freq[altFreqId].freq;
-										if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(altFreqId) != blockedfreqids[a2].end())
-										{
-											continue;
-										}
-										if(islower(D->datastream[ds2].recBandPolName[f2]))
-										{
-											continue;
-										}
+										lowedgefreq -= D->freq[freqId].bw;
+									}
 
-										if(D->freq[altFreqId].sideband == 'L')
-										{
-											altlowedgefreq -= D->freq[altFreqId].bw;
-										}
-										if(altlowedgefreq     == lowedgefreq &&
-										   D->freq[freqId].bw == D->freq[altFreqId].bw)
+									if(n2 == 0)
+									{
+										//look for another freqId which matches band but is opposite sideband
+										altFreqId = findFreq(pairs2.recByEdge, FreqKey(lowedgefreq, D->freq[freqId].bw));
+										if(altFreqId >= 0)
 										{
 											n2 = DifxDatastreamGetRecBands(D->datastream+ds2, altFreqId, a2p, a2c);
 										}
 									}
-								}
-								if(n2 == 0)
-								{
-									//still no dice? Try the zoom bands of datastream 2 with the same sideband
-									for(int f2 = 0; f2 < D->datastream[ds2].nZoomFreq; ++f2)
+									if(n2 == 0)
 									{
-										altFreqId = D->datastream[ds2].zoomFreqId[f2];
-										if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(altFreqId) != blockedfreqids[a2].end())
-										{
-											continue;
-										}
-										if(D->freq[freqId].freq == D->freq[altFreqId].freq &&
-										   D->freq[freqId].bw   == D->freq[altFreqId].bw &&
-										   D->freq[freqId].sideband == D->freq[altFreqId].sideband)
+										//still no dice? Try the zoom bands of datastream 2 with the same sideband
+										altFreqId = findFreq(pairs2.zoomByFreq, FreqKey(D->freq[freqId].freq, D->freq[freqId].bw, D->freq[freqId].sideband));
+										if(altFreqId >= 0)
 										{
 											n2 = DifxDatastreamGetZoomBands(D->datastream+ds2, altFreqId, a2p, a2c);
 											zoom2 = true;
 										}
 									}
-								}
-								if(n2 == 0)
-								{
-									//still no dice? Try the opposite sidebands of zoom bands of datastream 2
-									for(int f2 = 0; f2 < D->datastream[ds2].nZoomFreq; ++f2)
+									if(n2 == 0)
 									{
-										altFreqId = D->datastream[ds2].zoomFreqId[f2];
-										altlowedgefreq = D->freq[altFreqId].freq;
-										if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(altFreqId) != blockedfreqids[a2].end())
-										{
-											continue;
-										}
-										if(D->freq[altFreqId].sideband == 'L')
-										{
-											altlowedgefreq -= D->freq[altFreqId].bw;
-										}
-										if(altlowedgefreq == lowedgefreq &&
-										   D->freq[freqId].bw == D->freq[altFreqId].bw)
+										//still no dice? Try the opposite sidebands of zoom bands of datastream 2
+										altFreqId = findFreq(pairs2.zoomByEdge, FreqKey(lowedgefreq, D->freq[freqId].bw));
+										if(altFreqId >= 0)
 										{
 											n2 = DifxDatastreamGetZoomBands(D->datastream+ds2, altFreqId, a2p, a2c);
 											zoom2 = true;
 										}
 									}
-								}
 
-								nPol = 0;
-								for(int u = 0; u < n1; ++u)
-								{
-									for(int v = 0; v < n2; ++v)
+									nPol = 0;
+									for(int u = 0; u < n1; ++u)
 									{
-										if(corrSetup->doPolar || (a1p[u] == a2p[v] && (corrSetup->onlyPol == ' ' || corrSetup->onlyPol == a1p[u])))
+										for(int v = 0; v < n2; ++v)
 										{
-											bl->bandA[nFreq][nPol] = a1c[u];
-											bl->bandB[nFreq][nPol] = a2c[v];
-											if(zoom2)
+											if(corrSetup->doPolar || (a1p[u] == a2p[v] && (corrSetup->onlyPol == ' ' || corrSetup->onlyPol == a1p[u])))
 											{
-												bl->bandB[nFreq][nPol] += D->datastream[ds2].nRecBand;
+												bl->bandA[nFreq][nPol] = a1c[u];
+												bl->bandB[nFreq][nPol] = a2c[v];
+												if(zoom2)
+												{
+													bl->bandB[nFreq][nPol] += D->datastream[ds2].nRecBand;
+												}
+												++nPol;
 											}
-											++nPol;
 										}
 									}
-								}
-								bl->nPolProd[nFreq] = nPol;
+									bl->nPolProd[nFreq] = nPol;
 
-								if(nPol == 0)
-								{
-									// This deallocates
-									DifxBaselineAllocPolProds(bl, nFreq, 0);
+									if(nPol == 0)
+									{
+										// This deallocates
+										DifxBaselineAllocPolProds(bl, nFreq, 0);
 
-									continue;
-								}
+										continue;
+									}
 
-								if(globalBandwidth == 0)
-								{
-									globalBandwidth = D->freq[freqId].bw;
-								}
-								else if(globalBandwidth > 0)
-								{
-									if(globalBandwidth != D->freq[freqId].bw)
+									if(configBandwidth == 0)
 									{
-										globalBandwidth = -1;
+										configBandwidth = D->freq[freqId].bw;
+									}
+									else if(configBandwidth > 0)
+									{
+										if(configBandwidth != D->freq[freqId].bw)
+										{
+											configBandwidth = -1;
+										}
 									}
-								}
-
-								++nFreq;
-							}
 
-							for(int f = 0; f < D->datastream[ds1].nZoomFreq; ++f)
-							{
-								bool zoom2 = false;	// did antenna 2 zoom band make match? 
+									++nFreq;
+								}
 
-								n2 = 0;
+								for(int f = 0; f < D->datastream[ds1].nZoomFreq; ++f)
+								{
+									bool zoom2 = false;	// did antenna 2 zoom band make match? 
 
-								freqId = D->datastream[ds1].zoomFreqId[f];
+									n2 = 0;
 
-								// Unlike for recbands, don't query corrSetup->correlateFreqId as all defined zoom bands should be correlated
+									freqId = D->datastream[ds1].zoomFreqId[f];
 
-								DifxBaselineAllocPolProds(bl, nFreq, 4);
+									// Unlike for recbands, don't query corrSetup->correlateFreqId as all defined zoom bands should be correlated
 
-								n1 = DifxDatastreamGetZoomBands(D->datastream+ds1, freqId, a1p, a1c);
+									DifxBaselineAllocPolProds(bl, nFreq, 4);
 
-								lowedgefreq = D->freq[freqId].freq;
-								if(D->freq[freqId].sideband == 'L')
-								{
-									lowedgefreq -= D->freq[freqId].bw;
-								}
+									n1 = DifxDatastreamGetZoomBands(D->datastream+ds1, freqId, a1p, a1c);
 
-								for(int f2 = 0; f2 < D->datastream[ds2].nRecFreq; ++f2)
-								{
-									altFreqId = D->datastream[ds2].recFreqId[f2];
-									if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(altFreqId) != blockedfreqids[a2].end())
+									lowedgefreq = D->freq[freqId].freq;
+									if(D->freq[freqId].sideband == 'L')
 									{
-										continue;
+										lowedgefreq -= D->freq[freqId].bw;
 									}
-									if(D->freq[freqId].freq == D->freq[altFreqId].freq &&
-									   D->freq[freqId].bw   == D->freq[altFreqId].bw &&
-									   D->freq[altFreqId].sideband == 'U')
+
+									altFreqId = findFreq(pairs2.recUSBByFreq, FreqKey(D->freq[freqId].freq, D->freq[freqId].bw));
+									if(altFreqId >= 0)
 									{
 										n2 = DifxDatastreamGetRecBands(D->datastream+ds2, altFreqId, a2p, a2c);
 									}
-								}
 
-								if(n2 == 0)
-								{
-									//look for another freqId which matches band but is opposite sideband
-									for(int f2 = 0; f2 < D->datastream[ds2].nRecFreq; ++f2)
+									if(n2 == 0)
 									{
-										altFreqId = D->datastream[ds2].recFreqId[f2];
-										altlowedgefreq = D->freq[altFreqId].freq;
-										if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(altFreqId) != blockedfreqids[a2].end())
-										{
-											continue;
-										}
-										if(D->freq[altFreqId].sideband == 'L')
-										{
-											altlowedgefreq -= D->freq[altFreqId].bw;
-										}
-										if(altlowedgefreq     == lowedgefreq &&
-										   D->freq[freqId].bw == D->freq[altFreqId].bw)
+										//look for another freqId which matches band but is opposite sideband
+										altFreqId = findFreq(pairs2.recByEdgeAll, FreqKey(lowedgefreq, D->freq[freqId].bw));
+										if(altFreqId >= 0)
 										{
 											n2 = DifxDatastreamGetRecBands(D->datastream+ds2, altFreqId, a2p, a2c);
 										}
 									}
-								}
-								if(n2 == 0)
-								{
-									n2 = DifxDatastreamGetZoomBands(D->datastream+ds2, freqId, a2p, a2c);
-									if(n2 > 0)
+									if(n2 == 0)
 									{
-										zoom2 = true;
-									}
-								}
-								if(n2 == 0)
-								{
-									//still no dice? Try the opposite sidebands of zoom bands of datastream 2
-									for(int f2 = 0; f2 < D->datastream[ds2].nZoomFreq; ++f2)
-									{
-										altFreqId = D->datastream[ds2].zoomFreqId[f2];
-										altlowedgefreq = D->freq[altFreqId].freq;
-										if(!blockedfreqids[a2].empty() && blockedfreqids[a2].find(altFreqId) != blockedfreqids[a2].end())
-										{
-											continue;
-										}
-										if(D->freq[altFreqId].sideband == 'L')
+										n2 = DifxDatastreamGetZoomBands(D->datastream+ds2, freqId, a2p, a2c);
+										if(n2 > 0)
 										{
-											altlowedgefreq -= D->freq[altFreqId].bw;
+											zoom2 = true;
 										}
-										if(altlowedgefreq == lowedgefreq &&
-										   D->freq[freqId].bw == D->freq[altFreqId].bw)
+									}
+									if(n2 == 0)
+									{
+										//still no dice? Try the opposite sidebands of zoom bands of datastream 2
+										altFreqId = findFreq(pairs2.zoomByEdge, FreqKey(lowedgefreq, D->freq[freqId].bw));
+										if(altFreqId >= 0)
 										{
 											n2 = DifxDatastreamGetZoomBands(D->datastream+ds2, altFreqId, a2p, a2c);
 											zoom2 = true;
 										}
 									}
-								}
 
-								nPol = 0;
-								for(int u = 0; u < n1; ++u)
-								{
-									for(int v = 0; v < n2; ++v)
+									nPol = 0;
+									for(int u = 0; u < n1; ++u)
 									{
-										if(corrSetup->doPolar || (a1p[u] == a2p[v] && (corrSetup->onlyPol == ' ' || corrSetup->onlyPol == a1p[u])))
+										for(int v = 0; v < n2; ++v)
 										{
-											bl->bandA[nFreq][nPol] = D->datastream[ds1].nRecBand + a1c[u];
-											bl->bandB[nFreq][nPol] = a2c[v];
-											if(zoom2)
+											if(corrSetup->doPolar || (a1p[u] == a2p[v] && (corrSetup->onlyPol == ' ' || corrSetup->onlyPol == a1p[u])))
 											{
-												bl->bandB[nFreq][nPol] += D->datastream[ds2].nRecBand;
+												bl->bandA[nFreq][nPol] = D->datastream[ds1].nRecBand + a1c[u];
+												bl->bandB[nFreq][nPol] = a2c[v];
+												if(zoom2)
+												{
+													bl->bandB[nFreq][nPol] += D->datastream[ds2].nRecBand;
+												}
+												++nPol;
 											}
-											++nPol;
 										}
 									}
-								}
-								bl->nPolProd[nFreq] = nPol;
+									bl->nPolProd[nFreq] = nPol;
 
-								if(nPol == 0)
-								{
-									// This deallocates
-									DifxBaselineAllocPolProds(bl, nFreq, 0);
+									if(nPol == 0)
+									{
+										// This deallocates
+										DifxBaselineAllocPolProds(bl, nFreq, 0);
 
-									continue;
-								}
+										continue;
+									}
 
-								if(globalBandwidth == 0)
-								{
-									globalBandwidth = D->freq[freqId].bw;
-								}
-								else if(globalBandwidth > 0)
-								{
-									if(globalBandwidth != D->freq[freqId].bw)
+									if(configBandwidth == 0)
+									{
+										configBandwidth = D->freq[freqId].bw;
+									}
+									else if(configBandwidth > 0)
 									{
-										globalBandwidth = -1;
+										if(configBandwidth != D->freq[freqId].bw)
+										{
+											configBandwidth = -1;
+										}
 									}
-								}
 
-								++nFreq;
-							}
+									++nFreq;
+								}
 			
-							bl->nFreq = nFreq;
+								bl->nFreq = nFreq;
 			
-							if(bl->nFreq > 0)
-							{
-								config->baselineId[config->nBaseline] = blId;
-								++config->nBaseline;
-								++bl;
-								++blId;
-							}
-						} // config datastream 2 loop
-					} // config datastream 1 loop
-				} // ant 2 loop
-			} // ant 1 loop
+								if(bl->nFreq > 0)
+								{
+									config->baselineId[config->nBaseline] = blId;
+									++config->nBaseline;
+									++bl;
+									++blId;
+								}
+							} // datastream 2 loop
+						} // datastream 1 loop
+					} // ant 2 loop
+				} // ant 1 loop
+
+				mergeGlobalBandwidth(globalBandwidth, configBandwidth);
+				if(!truncated)
+				{
+					ConfigBaselines baselines;
+
+					makeConfigBaselines(baselines, D, config, configBandwidth);
+					cache.addBaselines(baselineKey, baselines);
+				}
+			}
 		}
 		config->baselineId[config->nBaseline] = -1;
 	}
@@ -1298,62 +1576,19 @@ static void populateEOPTable(DifxInput *D, const vector<VexEOP>& E)
 	}
 }
 
-static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, const VexData *V, const CorrParams *P, const VexScan *S)
+// Chooses subintNS and, if allowed, adjusts tInt and nDataSegments for one (mode, correlator setup).
+// This depends on nothing job-specific other than the incoming nDataSegments.
+static void computeConfigTiming(ConfigTiming &timing, const VexMode *mode, const CorrSetup *corrSetup, const CorrParams *P, int dataBufferFactor, int nDataSegments)
 {
-	int nConfig, nFFTsPerIntegration, nSubintsPerIntegration;
+	int nFFTsPerIntegration, nSubintsPerIntegration;
 	int max5div, max2div;
 	int fftDurNS;
-	DifxConfig *config;
-	const CorrSetup *corrSetup;
-	const VexMode *mode;
-	string configName;
 	double floatReadTimeNS, floatFFTDurNS, floatSubintDurNS;
 	double msgSize, dataRate, readSize;
 	int64_t tintNS;
-	int nDatastream;
-
-	const std::string &corrSetupName = P->findSetup(S->defName, S->sourceDefName, S->modeDefName);
-	corrSetup = P->getCorrSetup(corrSetupName);
-	if(corrSetup == 0)
-	{
-		cerr << "Error: correlator setup[" << corrSetupName << "] == 0" << endl;
-		
-		exit(EXIT_FAILURE);
-	}
-
-	mode = V->getModeByDefName(S->modeDefName);
-	if(mode == 0)
-	{
-		cerr << "Error: mode[" << S->modeDefName << "] == 0" << endl;
-		
-		exit(EXIT_FAILURE);
-	}
-
-	nConfig = configs.size();
-	for(int i = 0; i < nConfig; ++i)
-	{
-		if(configs[i].first  == S->modeDefName &&
-		   configs[i].second == corrSetupName)
-		{
-			return i;
-		}
-	}
-
-	// get worst case datastream count
-	nDatastream = mode->nStream();
-	configName = S->modeDefName + string("_") + corrSetupName;
 
-	configs.push_back(pair<string,string>(S->modeDefName, corrSetupName));
-	config = D->config + nConfig;
-	snprintf(config->name, DIFXIO_NAME_LENGTH, "%s", configName.c_str());
-	for(int i = 0; i < D->nRule; ++i)
-	{
-		if(corrSetupName == D->rule[i].configName)
-		{
-			snprintf(D->rule[i].configName, DIFXIO_NAME_LENGTH, "%s", configName.c_str());
-		}
-	}
-	config->tInt = corrSetup->tInt;
+	timing.tInt = corrSetup->tInt;
+	timing.nDataSegments = nDataSegments;
 	tintNS = static_cast<int64_t>(1e9*corrSetup->tInt + 0.5);
 	floatFFTDurNS = 1000000000.0/corrSetup->FFTSpecRes;
 	fftDurNS = static_cast<int>(floatFFTDurNS);
@@ -1372,15 +1607,15 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 
 	if(corrSetup->subintNS > 0) //This is relatively easy - just see if the provided values are reasonable
 	{
-		config->subintNS = corrSetup->subintNS;
-		if(config->subintNS % fftDurNS != 0)
+		timing.subintNS = corrSetup->subintNS;
+		if(timing.subintNS % fftDurNS != 0)
 		{
-			cerr << "Error: The provided subintNS (" << config->subintNS << ") is not an integer multiple of the FFT duration (" << fftDurNS << ")" << endl;
+			cerr << "Error: The provided subintNS (" << timing.subintNS << ") is not an integer multiple of the FFT duration (" << fftDurNS << ")" << endl;
 			cerr << "You should adjust your subint time, or leave subint unset and vex2difx will set it for you" << endl;
 
 			exit(EXIT_FAILURE);
 		}
-		if(tintNS % config->subintNS != 0)
+		if(tintNS % timing.subintNS != 0)
 		{
 			if(P->tweakIntTime)
 			{
@@ -1388,7 +1623,7 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 			}
 			else
 			{
-				cerr << "Error: The provided tInt (" << config->tInt << ") is not an integer multiple of the provided subint (" << corrSetup->subintNS/1.0e9 << ")" << endl;
+				cerr << "Error: The provided tInt (" << timing.tInt << ") is not an integer multiple of the provided subint (" << corrSetup->subintNS/1.0e9 << ")" << endl;
 				cerr << "You should adjust your subint and/or int time, or leave subint unset and vex2difx will set it for you" << endl;
 
 				exit(EXIT_FAILURE);
@@ -1420,9 +1655,9 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 			}
 		}
 
-		config->subintNS = fftDurNS;
-		msgSize = (config->subintNS*1.0e-9)*dataRate/8.0;
-		readSize = msgSize*D->dataBufferFactor/D->nDataSegments;
+		timing.subintNS = fftDurNS;
+		msgSize = (timing.subintNS*1.0e-9)*dataRate/8.0;
+		readSize = msgSize*dataBufferFactor/timing.nDataSegments;
 		if(readSize > P->maxReadSize)
 		{
 			cerr << "Warning: a single FFT gives a read size of " << readSize << " bytes" << endl;
@@ -1465,30 +1700,30 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 
 				int64_t testsubintNS = tintNS / divisor;
 				msgSize = (testsubintNS*1.0e-9)*dataRate/8.0;
-				readSize = msgSize*D->dataBufferFactor/D->nDataSegments;
+				readSize = msgSize*dataBufferFactor/timing.nDataSegments;
 				if(readSize > P->minReadSize && readSize < P->maxReadSize && 
-					testsubintNS <= 1020000000 && testsubintNS > config->subintNS && 
+					testsubintNS <= 1020000000 && testsubintNS > timing.subintNS && 
 					fabs(testsubintNS/floatFFTDurNS - static_cast<int>(testsubintNS/floatFFTDurNS + 0.5)) < 1e-9)
 				{
-					config->subintNS = testsubintNS;
+					timing.subintNS = testsubintNS;
 				}
 			}
 		}
 		//refuse to run if the generated read size is too small
-		msgSize = (config->subintNS*1.0e-9)*dataRate/8.0;
-		readSize = msgSize*D->dataBufferFactor/D->nDataSegments;
+		msgSize = (timing.subintNS*1.0e-9)*dataRate/8.0;
+		readSize = msgSize*dataBufferFactor/timing.nDataSegments;
 		if(readSize < P->minReadSize)
 		{
 			if(P->tweakIntTime)
 			{
-				while(((config->subintNS*1.0e-9)*dataRate/8.0)*(D->dataBufferFactor/D->nDataSegments) < P->minReadSize && config->subintNS <= 510000000)
+				while(((timing.subintNS*1.0e-9)*dataRate/8.0)*(dataBufferFactor/timing.nDataSegments) < P->minReadSize && timing.subintNS <= 510000000)
 				{
-					config->subintNS *= 2;
+					timing.subintNS *= 2;
 				}
 			}
 			else
 			{
-				cerr << "Automatic subint duration selection generated " << config->subintNS << " nanoseconds" << endl;
+				cerr << "Automatic subint duration selection generated " << timing.subintNS << " nanoseconds" << endl;
 				cerr << "This leads to a read size of " << readSize << " B" << endl;
 				cerr << "The minimum read size was set or defaulted to " << P->minReadSize << " B" << endl;
 				cerr << "Either decrease minReadSize (which may lead to slow correlation) or explicitly set subintNS" << endl;
@@ -1500,20 +1735,20 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 	}
 
 	// change nDataSegments if needed to get send sizes under 2^31 nanoseconds
-	floatReadTimeNS = static_cast<double>(config->subintNS)*D->dataBufferFactor/D->nDataSegments;
+	floatReadTimeNS = static_cast<double>(timing.subintNS)*dataBufferFactor/timing.nDataSegments;
 	if(floatReadTimeNS > 2140000000.0)
 	{
-		int f = static_cast<int>(2140000000.0/config->subintNS);
+		int f = static_cast<int>(2140000000.0/timing.subintNS);
 		if(f < 1)
 		{
 			cerr << "Error: There is no way to change dataBufferFactor to keep send sizes below 2^31 seconds" << endl;
 
 			exit(EXIT_FAILURE);
 		}
-		cout << "Note: changing nDataSegments from " << D->nDataSegments << " to " << (D->dataBufferFactor/f) << " in order to keep data send sizes below 2.14 seconds" << endl;
-		D->nDataSegments = D->dataBufferFactor/f;
-		msgSize = (config->subintNS*1.0e-9)*dataRate/8.0;
-		readSize = msgSize*D->dataBufferFactor/D->nDataSegments;
+		cout << "Note: changing nDataSegments from " << timing.nDataSegments << " to " << (dataBufferFactor/f) << " in order to keep data send sizes below 2.14 seconds" << endl;
+		timing.nDataSegments = dataBufferFactor/f;
+		msgSize = (timing.subintNS*1.0e-9)*dataRate/8.0;
+		readSize = msgSize*dataBufferFactor/timing.nDataSegments;
 		if(readSize < P->minReadSize)
 		{
 			cout << "This has lead to a read size " << readSize << " smaller than the provided guideline " << P->minReadSize << ": correlation may run more slowly" << endl;
@@ -1522,7 +1757,7 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 	}
 
 	//now check that the int time is an integer number of subints, and tweak if necessary
-	floatSubintDurNS = (double)config->subintNS;
+	floatSubintDurNS = (double)timing.subintNS;
 	nSubintsPerIntegration = static_cast<int>(1e9*corrSetup->tInt/floatSubintDurNS + 0.5);
 	if(fabs(1e9*corrSetup->tInt/floatSubintDurNS - nSubintsPerIntegration) > 1e-9)
 	{
@@ -1532,37 +1767,110 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 			int best2div = 0;
 			double bestfractionaldiff;
 
-			cout << "The provided tInt (" << config->tInt << ") is not an integer multiple of the subint (" << floatSubintDurNS/1.0e9 << ")" << endl;
-			max5div = static_cast<int>(config->tInt/(5*floatSubintDurNS/1.0e9)) + 1;
-			max2div = static_cast<int>(config->tInt/(2*floatSubintDurNS/1.0e9)) + 1;
-			bestfractionaldiff = fabs(1.0 - (floatSubintDurNS/1.0e9)/config->tInt);
+			cout << "The provided tInt (" << timing.tInt << ") is not an integer multiple of the subint (" << floatSubintDurNS/1.0e9 << ")" << endl;
+			max5div = static_cast<int>(timing.tInt/(5*floatSubintDurNS/1.0e9)) + 1;
+			max2div = static_cast<int>(timing.tInt/(2*floatSubintDurNS/1.0e9)) + 1;
+			bestfractionaldiff = fabs(1.0 - (floatSubintDurNS/1.0e9)/timing.tInt);
 			for(int i = 0; i <= max5div; ++i)
 			{
 				for(int j = 0; j <= max5div; ++j)
 				{
 					double test_tint = (floatSubintDurNS/1.0e9)*pow(5.0,i)*pow(2.0,j);
-					if(fabs(1.0 - (test_tint)/config->tInt) < bestfractionaldiff)
+					if(fabs(1.0 - (test_tint)/timing.tInt) < bestfractionaldiff)
 					{
-						bestfractionaldiff = fabs(1.0 - (test_tint)/config->tInt);
+						bestfractionaldiff = fabs(1.0 - (test_tint)/timing.tInt);
 						best5div = i;
 						best2div = j;
 					}
 				}
 			}
-			cout << "tInt has been updated from " << config->tInt << " to " << (floatSubintDurNS/1.0e9)*pow(5.0,best5div)*pow(2.0,best2div) << endl;
+			cout << "tInt has been updated from " << timing.tInt << " to " << (floatSubintDurNS/1.0e9)*pow(5.0,best5div)*pow(2.0,best2div) << endl;
 			cout << "(You could also try modifying the subintNS if you want to try harder to get your desired integration time)" << endl;
-			config->tInt = (floatSubintDurNS/1.0e9)*pow(5.0,best5div)*pow(2.0,best2div);
+			timing.tInt = (floatSubintDurNS/1.0e9)*pow(5.0,best5div)*pow(2.0,best2div);
 		}
 		else
 		{
-			cerr << "Error: The provided tInt (" << config->tInt << ") is not an integer multiple of the subint (" << floatSubintDurNS/1.0e9 << ")" << endl; 
+			cerr << "Error: The provided tInt (" << timing.tInt << ") is not an integer multiple of the subint (" << floatSubintDurNS/1.0e9 << ")" << endl; 
 			cerr << "Either change your integration time to a more friendly value, or tweak number of channels or subint time, or set tweakIntTime = true" << endl;
 
 			exit(EXIT_FAILURE);
 		}
 	}
 
-	config->guardNS = corrSetup->guardNS;
+	//if guardNS was set to negative value, change it to the right amount to allow for
+	//adjustment to get to an integer NS + geometric rate slippage (assumes Earth-based antenna)
+	//Note: if not set explicitly, zero will be passed to mpifxcorr where it will do the calculation
+	timing.guardNS = corrSetup->guardNS;
+	if(timing.guardNS < 0)
+	{
+		timing.guardNS = calculateWorstcaseGuardNS(mode->getLowestSampleRate(), timing.subintNS, mode->getMinBits(), mode->getMinSubbands());
+	}
+}
+
+static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, const VexData *V, const CorrParams *P, const VexScan *S, ConfigCache &cache)
+{
+	int nConfig;
+	DifxConfig *config;
+	const CorrSetup *corrSetup;
+	const VexMode *mode;
+	const ConfigTiming *timing;
+	string configName;
+	int nDatastream;
+
+	const std::string &corrSetupName = P->findSetup(S->defName, S->sourceDefName, S->modeDefName);
+	corrSetup = P->getCorrSetup(corrSetupName);
+	if(corrSetup == 0)
+	{
+		cerr << "Error: correlator setup[" << corrSetupName << "] == 0" << endl;
+		
+		exit(EXIT_FAILURE);
+	}
+
+	mode = V->getModeByDefName(S->modeDefName);
+	if(mode == 0)
+	{
+		cerr << "Error: mode[" << S->modeDefName << "] == 0" << endl;
+		
+		exit(EXIT_FAILURE);
+	}
+
+	nConfig = configs.size();
+	for(int i = 0; i < nConfig; ++i)
+	{
+		if(configs[i].first  == S->modeDefName &&
+		   configs[i].second == corrSetupName)
+		{
+			return i;
+		}
+	}
+
+	// get worst case datastream count
+	nDatastream = mode->nStream();
+	configName = S->modeDefName + string("_") + corrSetupName;
+
+	configs.push_back(pair<string,string>(S->modeDefName, corrSetupName));
+	config = D->config + nConfig;
+	snprintf(config->name, DIFXIO_NAME_LENGTH, "%s", configName.c_str());
+	for(int i = 0; i < D->nRule; ++i)
+	{
+		if(corrSetupName == D->rule[i].configName)
+		{
+			snprintf(D->rule[i].configName, DIFXIO_NAME_LENGTH, "%s", configName.c_str());
+		}
+	}
+	// The subint search gives the same answer for every job using this mode and setup
+	timing = cache.findTiming(S->modeDefName, corrSetupName, D->nDataSegments);
+	if(!timing)
+	{
+		ConfigTiming newTiming;
+
+		computeConfigTiming(newTiming, mode, corrSetup, P, D->dataBufferFactor, D->nDataSegments);
+		timing = cache.addTiming(S->modeDefName, corrSetupName, D->nDataSegments, newTiming);
+	}
+	config->tInt = timing->tInt;
+	config->subintNS = timing->subintNS;
+	D->nDataSegments = timing->nDataSegments;
+	config->guardNS = timing->guardNS;
 	config->fringeRotOrder = corrSetup->fringeRotOrder;
 	config->strideLength = corrSetup->strideLength;
 	config->xmacLength = corrSetup->xmacLength;
@@ -1588,14 +1896,6 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 		}
 	}
 
-	//if guardNS was set to negative value, change it to the right amount to allow for
-	//adjustment to get to an integer NS + geometric rate slippage (assumes Earth-based antenna)
-	//Note: if not set explicitly, zero will be passed to mpifxcorr where it will do the calculation
-	if(config->guardNS < 0)
-	{
-		config->guardNS = calculateWorstcaseGuardNS(mode->getLowestSampleRate(), config->subintNS, mode->getMinBits(), mode->getMinSubbands());
-	}
-	
 	DifxConfigAllocDatastreamIds(config, config->nDatastream, D->nConfig*config->nDatastream);
 	DifxConfigAllocBaselineIds(config, config->nBaseline, nConfig*config->nBaseline);
 
@@ -1605,7 +1905,7 @@ static int getConfigIndex(vector<pair<string,string> >& configs, DifxInput *D, c
 	return nConfig;
 }
 
-static bool matchingFreq(const ZoomFreq &zoomfreq, const DifxDatastream *dd, int dfreqIndex, const vector<freq> &freqs)
+static bool matchingFreq(const ZoomFreq &zoomfreq, const DifxDatastream *dd, int dfreqIndex, const FreqTable &freqs)
 {
 	const double epsilon = 0.000001;
 	double channeloffset;
@@ -1700,7 +2000,7 @@ static void populateSourceTable(DifxInput *D, const Job& J, const VexData *V, se
 	}
 }
 
-static void populateScanTable(DifxInput *D, const Job& J, const VexData *V, const CorrParams *P, const CorrSetup *corrSetup, vector<pair<string,string> > &configs, unsigned int &maxScanPhaseCentres)
+static void populateScanTable(DifxInput *D, const Job& J, const VexData *V, const CorrParams *P, const CorrSetup *corrSetup, vector<pair<string,string> > &configs, unsigned int &maxScanPhaseCentres, ConfigCache &cache)
 {
 	maxScanPhaseCentres = 0;
 
@@ -1756,7 +2056,7 @@ static void populateScanTable(DifxInput *D, const Job& J, const VexData *V, cons
 		{
 			difxScan->durSeconds = 1;
 		}
-		difxScan->configId = getConfigIndex(configs, D, V, P, vexScan);
+		difxScan->configId = getConfigIndex(configs, D, V, P, vexScan, cache);
 		difxScan->maxNSBetweenUVShifts = corrSetup->maxNSBetweenUVShifts;
 		fftDurNS = static_cast<int>(1000000000.0/corrSetup->FFTSpecRes);  
 		if(corrSetup->maxNSBetweenACAvg > 0)
@@ -1794,10 +2094,9 @@ static void populateScanTable(DifxInput *D, const Job& J, const VexData *V, cons
 	}
 }
 
-static void populateSpacecraftTable(DifxInput *D, const VexData *V, const std::set<std::string> &spacecraftSet, int verbose)
+static void populateSpacecraftTable(DifxInput *D, const VexData *V, const std::set<std::string> &spacecraftSet, const SpacecraftEphemerisCache &ephemCache, int verbose)
 {
 	DifxSpacecraft *ds;
-	int v;
 
 	D->spacecraft = newDifxSpacecraftArray(spacecraftSet.size());
 	D->nSpacecraft = spacecraftSet.size();
@@ -1814,102 +2113,21 @@ static void populateSpacecraftTable(DifxInput *D, const VexData *V, const std::s
 			exit(EXIT_FAILURE);
 		}
 
-		const long int deltaT = vexSource->ephemDeltaT;	// seconds -- interval between ephemeris calculations.  24 sec is normal
-		const int intMJD = static_cast<int>(D->mjdStart);
-		// start time in seconds rounded down to nearest 2 minute boundary, and then one more
-		const int secStart = (static_cast<int>((D->mjdStart - intMJD)*720.0) - 1)*120;
-		// end time in seconds rounded up to nearest 2 minute boundary, and then one more
-		const int secEnd = static_cast<int>((D->mjdStop - intMJD)*720.0 + 1.999)*120;
-		const int nPoint = (secEnd - secStart)/deltaT + 1;
-		const double mjd0 = intMJD + secStart/86400.0;
-
-		/* initialize state vector structure with evaluation times */
-		ds->nPoint = nPoint;
-		ds->pos = (sixVector *)calloc(ds->nPoint, sizeof(sixVector));
-		for(int p = 0; p < nPoint; ++p)
-		{
-			sixVectorSetTime(ds->pos + p, intMJD, secStart + p*deltaT);
-		}
-
-		if(vexSource->type == VexSource::BSP)		// process a .bsp file through spice
-		{
-			if(verbose > 0)
-			{
-				cout << "Computing ephemeris for source: " << *vexSource << endl;
-				cout << "  start mjd = " << intMJD << "  sec = " << secStart << endl;
-				cout << "  nPoint = " << nPoint << endl;
-			}
-
-			v = populateSpiceLeapSecondsFromEOP(D->eop, D->nEOP);
-			if(v != 0)
-			{
-				cerr << "Error: populateSpiceLeapSecondsFromEOP returned " << v << endl;
-
-				exit(EXIT_FAILURE);
-			}
-
-			v = computeDifxSpacecraftEphemeris(ds, mjd0, deltaT/86400.0, nPoint, 
-				vexSource->bspObject.c_str(),
-				0,
-				vexSource->bspFile.c_str(), 
-				vexSource->ephemStellarAber,
-				vexSource->ephemClockError);
-			if(v != 0)
-			{
-				cerr << "Error: ephemeris calculation failed.  Must stop." << endl;
-				
-				exit(EXIT_FAILURE);
-			}
-		}
-		else if(vexSource->type == VexSource::TLE)
-		{
-			if(verbose > 0)
-			{
-				cout << "Computing ephemeris for source: " << *vexSource << endl;
-				cout << "  start mjd = " << intMJD << "  sec = " << secStart << endl;
-				cout << "  nPoint = " << nPoint << endl;
-			}
-
-			v = populateSpiceLeapSecondsFromEOP(D->eop, D->nEOP);
-			if(v != 0)
-			{
-				cerr << "Error: populateSpiceLeapSecondsFromEOP returned " << v << endl;
-
-				exit(EXIT_FAILURE);
-			}
+		const EphemerisGrid grid(vexSource, D->mjdStart, D->mjdStop);
+		const sixVector *pos = ephemCache.find(vexSource, grid);
 
-			v = computeDifxSpacecraftTwoLineElement(ds, mjd0, deltaT/86400.0, nPoint, 
-				vexSource->defName.c_str(),
-				0,
-				vexSource->tle[1].c_str(), 
-				vexSource->tle[2].c_str(), 
-				vexSource->ephemStellarAber,
-				vexSource->ephemClockError);
-			if(v != 0)
-			{
-				cerr << "Error: TLE ephemeris calculation failed.  Must stop." << endl;
-				
-				exit(EXIT_FAILURE);
-			}
-		}
-		else if(vexSource->type == VexSource::Fixed)
+		if(pos)
 		{
-			v = computeDifxSpacecraftEphemerisFromXYZ(ds, mjd0, deltaT/86400.0, nPoint, 
-				vexSource->X, vexSource->Y, vexSource->Z,
-				0,
-				vexSource->ephemClockError);
-			if(v != 0)
-			{
-				cerr << "Error: XYZ ephemeris calculation failed.  Must stop." << endl;
-				
-				exit(EXIT_FAILURE);
-			}
+			ds->nPoint = grid.nPoint;
+			ds->pos = (sixVector *)calloc(ds->nPoint, sizeof(sixVector));
+			memcpy(ds->pos, pos, ds->nPoint*sizeof(sixVector));
 		}
 		else
 		{
-			cerr << "Developer error: unknown source type; don't know how to compute state vectors." << endl;
-
-			exit(EXIT_FAILURE);
+			// not expected since the cache covers every job, but SPICE must not be entered by two threads
+			pthread_mutex_lock(&spiceLock);
+			computeSpacecraftEphemeris(ds, vexSource, grid, D->eop, D->nEOP, verbose);
+			pthread_mutex_unlock(&spiceLock);
 		}
 
 		// give the spacecraft table the right name so it can be linked to the source
@@ -1931,7 +2149,7 @@ static void populateSpacecraftTable(DifxInput *D, const VexData *V, const std::s
 	}
 }
 
-static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const std::list<Event> &events, const Shelves &shelves, int verbose, ofstream *of, int nDigit, char ext, int strict)
+static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const EventTimeline &events, const Shelves &shelves, ConfigCache &cache, const SpacecraftEphemerisCache &ephemCache, const PulsarConfigCache &pulsarCache, int verbose, ostream *of, int nDigit, char ext, int strict)
 {
 	DifxInput *D;
 	const CorrSetup *corrSetup;
@@ -1941,8 +2159,8 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 	set<string> sourceSet;
 	set<string> spacecraftSet;
 	vector<pair<string,string> > configs;
-	vector<freq> freqs;
-	vector<vector<unsigned int> > toneSets;
+	FreqTable freqs;
+	ToneSetTable toneSets;
 	int nPulsar=0;
 	int nbin, maxPulsarBins;
 	unsigned int maxScanPhaseCentres;
@@ -1954,7 +2172,7 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 
 	// Initialize toneSets with the trivial case, which is used for all zoom bands
 	vector<unsigned int> noTones;
-	toneSets.push_back(noTones);
+	toneSets.getId(noTones);
 
 	// Assume same correlator setup for all scans
 	if(J.scans.empty())
@@ -2025,7 +2243,7 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 	getSpacecraftSet(V, sourceSet, spacecraftSet);
 
 	// now run through all scans, populating things as we go
-	populateScanTable(D, J, V, P, corrSetup, configs, maxScanPhaseCentres);
+	populateScanTable(D, J, V, P, corrSetup, configs, maxScanPhaseCentres, cache);
 
 
 	// look for pulsars
@@ -2077,20 +2295,20 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 
 		if(!corrSetup->binConfigFile.empty())
 		{
-			int ok;
+			const DifxPulsar *pulsar = pulsarCache.find(corrSetup->binConfigFile);
 
-			ok = checkCRLF(corrSetup->binConfigFile.c_str(), (verbose > 1));
-			if(ok < 0)
+			if(pulsar == 0)
 			{
-				cerr << "The pulsar bin config file " << corrSetup->binConfigFile << " has problems.  Exiting." << endl;
+				cerr << "Developer error: writeJob: pulsar bin config file " << corrSetup->binConfigFile << " was not preloaded" << endl;
 
 				exit(EXIT_FAILURE);
 			}
 
 			config->pulsarId = D->nPulsar;
-			loadPulsarConfigFile(D, corrSetup->binConfigFile.c_str());
-			nbin = D->pulsar[D->nPulsar-1].nBin;
-			if(D->pulsar[D->nPulsar-1].scrunch > 0)
+			copyDifxPulsar(D->pulsar + D->nPulsar, pulsar);
+			++D->nPulsar;
+			nbin = pulsar->nBin;
+			if(pulsar->scrunch > 0)
 			{
 				nbin = 1;
 			}
@@ -2099,15 +2317,9 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 				maxPulsarBins = nbin;
 			}
 
-			for(int p = 0; p < D->pulsar[D->nPulsar-1].nPolyco; ++p)
+			if(!pulsarCache.covers(corrSetup->binConfigFile, J.mjdStart, J.mjdStop))
 			{
-				ok = checkCRLF(D->pulsar[D->nPulsar-1].polyco[p].fileName, (verbose > 1));
-				if(ok < 0)
-				{
-					cerr << "The pulsar polyco file " << D->pulsar[D->nPulsar-1].polyco[p].fileName << " has problems.  Exiting." << endl;
-
-					exit(EXIT_FAILURE);
-				}
+				cerr << "Warning: the polycos of pulsar bin config file " << corrSetup->binConfigFile << " do not cover the whole time range of job " << J.jobSeries << "_" << J.jobId << endl;
 			}
 		}
 
@@ -2128,8 +2340,9 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 			for(unsigned int ds = 0; ds < setup.nStream(); ++ds)
 			{
 				const VexStream &stream = setup.streams[ds];
+				const DatastreamLayout *layout = getDatastreamLayout(cache, mode, antName, ds, startBand, setup, P->v2dMode);
 				// the zero below is just to provide a legal slot to do some prodding.  the loop below will properly populate all datastreams.
-				setFormat(D, 0, freqs, toneSets, mode, antName, startBand, setup, stream, corrSetup, P->v2dMode);
+				setFormat(D, 0, freqs, toneSets, *layout, corrSetup);
 				startBand += stream.nRecordChan;
 			}
 		}
@@ -2153,7 +2366,8 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 			for(unsigned int ds = 0; ds < setup.nStream(); ++ds)
 			{
 				const VexStream &stream = setup.streams[ds];
-				int v = setFormat(D, D->nDatastream, freqs, toneSets, mode, antName, startBand, setup, stream, corrSetup, P->v2dMode);
+				const DatastreamLayout *layout = getDatastreamLayout(cache, mode, antName, ds, startBand, setup, P->v2dMode);
+				int v = setFormat(D, D->nDatastream, freqs, toneSets, *layout, corrSetup);
 				if(v)
 				{
 					dd = D->datastream + D->nDatastream;
@@ -2366,14 +2580,14 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 	// Populate spacecraft table
 	if(!spacecraftSet.empty())
 	{
-		populateSpacecraftTable(D, V, spacecraftSet, verbose);
+		populateSpacecraftTable(D, V, spacecraftSet, ephemCache, verbose);
 	}
 
 	// Make frequency table
 	populateFreqTable(D, freqs, toneSets);
 
 	// Make baseline table
-	globalBandwidth = populateBaselineTable(D, P, corrSetup, blockedfreqids);
+	globalBandwidth = populateBaselineTable(D, P, corrSetup, blockedfreqids, cache);
 	if(globalBandwidth < 0)	// Implies conflicting bandwidths found
 	{
 		cerr << "Warning: differing correlation channel bandwidths found.  You can correlate this data, but won't be able to convert to FITS!" << endl;
@@ -2552,6 +2766,126 @@ static int writeJob(const Job& J, const VexData *V, const CorrParams *P, const s
 	}
 }
 
+// One job to be written; the .joblist line is kept so lines can be emitted in job order
+class JobWriteTask
+{
+public:
+	const Job *job;
+	std::string jobListEntry;
+	int created;
+};
+
+class JobWriteWork
+{
+public:
+	std::vector<JobWriteTask> *tasks;
+	const VexData *V;
+	const CorrParams *P;
+	const EventTimeline *events;
+	const Shelves *shelves;
+	ConfigCache *cache;
+	const SpacecraftEphemerisCache *ephemCache;
+	const PulsarConfigCache *pulsarCache;
+	int verbose;
+	int nDigit;
+	int strict;
+	unsigned int nextTask;
+	pthread_mutex_t lock;
+};
+
+static void runJobWriteTask(JobWriteTask &task, const JobWriteWork &work)
+{
+	ostringstream entry;
+
+	entry.precision(12);	// as for the .joblist file itself
+	if(work.verbose > 0)
+	{
+		cout << *task.job;
+	}
+	if(task.job->jobSeries == "-")
+	{
+		return;
+	}
+	task.created = writeJob(*task.job, work.V, work.P, *work.events, *work.shelves, *work.cache, *work.ephemCache, *work.pulsarCache, work.verbose, &entry, work.nDigit, 0, work.strict);
+	task.jobListEntry = entry.str();
+}
+
+static void *jobWriteWorker(void *arg)
+{
+	JobWriteWork *work = static_cast<JobWriteWork *>(arg);
+
+	for(;;)
+	{
+		unsigned int t;
+
+		pthread_mutex_lock(&work->lock);
+		t = work->nextTask++;
+		pthread_mutex_unlock(&work->lock);
+
+		if(t >= work->tasks->size())
+		{
+			break;
+		}
+		runJobWriteTask((*work->tasks)[t], *work);
+	}
+
+	return 0;
+}
+
+// Jobs only read V, P, events and shelves, so any number may be written at once.  nThread = 0 means one per CPU.
+static void runJobWriteTasks(std::vector<JobWriteTask> &tasks, const VexData *V, const CorrParams *P, const EventTimeline &events, const Shelves &shelves, ConfigCache &cache, const SpacecraftEphemerisCache &ephemCache, const PulsarConfigCache &pulsarCache, int verbose, int nDigit, int strict, unsigned int nThread)
+{
+	JobWriteWork work;
+	std::vector<pthread_t> threads;
+
+	work.tasks = &tasks;
+	work.V = V;
+	work.P = P;
+	work.events = &events;
+	work.shelves = &shelves;
+	work.cache = &cache;
+	work.ephemCache = &ephemCache;
+	work.pulsarCache = &pulsarCache;
+	work.verbose = verbose;
+	work.nDigit = nDigit;
+	work.strict = strict;
+	work.nextTask = 0;
+	pthread_mutex_init(&work.lock, 0);
+
+	if(nThread == 0)
+	{
+		long nCPU = sysconf(_SC_NPROCESSORS_ONLN);
+
+		nThread = (nCPU > 1) ? nCPU : 1;
+	}
+	if(nThread > tasks.size())
+	{
+		nThread = tasks.size();
+	}
+
+	// Make sure lookups by name in the workers never rebuild an index
+	V->buildNameIndexes();
+
+	// The calling thread is one of the workers
+	for(unsigned int i = 1; i < nThread; ++i)
+	{
+		pthread_t thread;
+
+		if(pthread_create(&thread, 0, jobWriteWorker, &work) != 0)
+		{
+			break;
+		}
+		threads.push_back(thread);
+	}
+	jobWriteWorker(&work);
+	for(std::vector<pthread_t>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		pthread_join(*it, 0);
+	}
+
+	pthread_mutex_destroy(&work.lock);
+}
+
 static void usage(int argc, char **argv)
 {
 	cout << endl;
@@ -2581,6 +2915,16 @@ static void usage(int argc, char **argv)
 	cout << "     -6" << endl;
 	cout << "     --mk6         call mk62v2d utility to generate mark6 related files" << endl;
 	cout << endl;
+	cout << "     -n" << endl;
+	cout << "     --no-cache    do not write cache files (the vex snapshot and filelist" << endl;
+	cout << "                   .cache and .times files) beside the input files;" << endl;
+	cout << "                   existing ones are still used." << endl;
+	cout << endl;
+	cout << "     -j <n>" << endl;
+	cout << "     --jobs <n>    write up to <n> jobs concurrently; 0 means one per CPU [1]." << endl;
+	cout << "                   The .joblist is the same as for a serial run, but messages" << endl;
+	cout << "                   from different jobs may be interleaved." << endl;
+	cout << endl;
 	cout << "  <v2d file> is the vex2difx configuration file to process." << endl;
 	cout << endl;
 	cout << "When running " << program << " you will likely see some output to the screen." << endl;
@@ -2696,9 +3040,12 @@ int main(int argc, char **argv)
 	CorrParams *P;
 	VexData *V;
 	Shelves shelves;
+	ConfigCache configCache;
+	SpacecraftEphemerisCache ephemCache;
+	PulsarConfigCache pulsarCache;
 	const VexScan *S;
 	const SourceSetup *sourceSetup;
-	list<Event> events;
+	EventTimeline events;
 	set<string> canonicalVDIFUsers;
 	vector<Job> J;
 	string shelfFile;
@@ -2711,11 +3058,14 @@ int main(int argc, char **argv)
 	bool deleteOld = false;
 	bool strict = true;
 	bool mk6 = false;
+	bool writeCache = true;
 	unsigned int nWarn = 0;
 	unsigned int nError = 0;
 	unsigned int nSkip = 0;
 	unsigned int nDigit;
 	unsigned int nJob = 0;
+	unsigned int nJobThread = 1;
+	std::vector<JobWriteTask> jobWriteTasks;
 	std::list<std::pair<int,std::string> > removedAntennas;
 
 	if(argc < 2)
@@ -2771,6 +3121,24 @@ int main(int argc, char **argv)
 			{
 				mk6 = 1;
 			}
+			else if(strcmp(argv[a], "-n") == 0 ||
+				strcmp(argv[a], "--no-cache") == 0)
+			{
+				writeCache = false;
+			}
+			else if(strcmp(argv[a], "-j") == 0 ||
+				strcmp(argv[a], "--jobs") == 0)
+			{
+				if(a+1 >= argc || atoi(argv[a+1]) < 0)
+				{
+					cerr << "Error: " << argv[a] << " requires a non-negative number of jobs." << endl;
+					cerr << "Run with -h for help information." << endl;
+
+					exit(EXIT_FAILURE);
+				}
+				++a;
+				nJobThread = atoi(argv[a]);
+			}
 			else
 			{
 				cerr << "Error: unknown option " << argv[a] << endl;
@@ -2839,7 +3207,7 @@ int main(int argc, char **argv)
 	      	system(command.c_str());
 	}
 
-	P = new CorrParams(v2dFile);
+	P = new CorrParams(v2dFile, writeCache);
 	if(P->vexFile.empty())
 	{
 		cerr << "Error: vex file parameter (vex) not found in file." << endl;
@@ -2874,7 +3242,7 @@ int main(int argc, char **argv)
 	command = "rm -f " + missingDataFile;
 	system(command.c_str());
 
-	V = loadVexFile(P->vexFile, &nWarn);
+	V = loadVexFile(P->vexFile, &nWarn, verbose, writeCache);
 	if(!V)
 	{
 		cerr << "Error: cannot load vex file: " << P->vexFile << endl;
@@ -2883,6 +3251,7 @@ int main(int argc, char **argv)
 	}
 
 	applyCorrParams(V, *P, nWarn, nError, canonicalVDIFUsers);
+	P->assignScanSetups(V);
 	calculateScanSizes(V, *P);
 
 	if(!canonicalVDIFUsers.empty())
@@ -2904,11 +3273,11 @@ int main(int argc, char **argv)
 	{
 		if(as->mjdStart > 0.0)
 		{
-			addEvent(events, as->mjdStart, Event::ANTENNA_START, as->vexName);
+			events.add(as->mjdStart, Event::ANTENNA_START, as->vexName);
 		}
 		if(as->mjdStop > 0.0)
 		{
-			addEvent(events, as->mjdStop, Event::ANTENNA_STOP, as->vexName);
+			events.add(as->mjdStop, Event::ANTENNA_STOP, as->vexName);
 		}
 	}
 	events.sort();
@@ -3086,14 +3455,14 @@ int main(int argc, char **argv)
 	if(verbose > 3)
 	{
 		cout << "Pre-job making events:" << endl;
-		printEventList(events);
+		events.print();
 	}
 
 	makeJobs(J, V, P, events, removedAntennas, verbose);
 
 	if(verbose > 2)
 	{
-		printEventList(events);
+		events.print();
 	}
 
 	if(deleteOld)
@@ -3159,24 +3528,83 @@ int main(int argc, char **argv)
 	
 	for(vector<Job>::iterator j = J.begin(); j != J.end(); ++j)
 	{
-		if(verbose > 0)
+		if(j->jobSeries == "-")
+		{
+			++nSkip;
+		}
+		jobWriteTasks.push_back(JobWriteTask());
+		jobWriteTasks.back().job = &*j;
+		jobWriteTasks.back().created = 0;
+	}
+
+	// Spacecraft state vectors are computed once for the whole experiment, before any job is written
+	for(vector<Job>::const_iterator j = J.begin(); j != J.end(); ++j)
+	{
+		set<string> sourceSet, spacecraftSet;
+
+		if(j->jobSeries == "-")
+		{
+			continue;
+		}
+		j->getCorrelationSourceSet(V, sourceSet);
+		getSpacecraftSet(V, sourceSet, spacecraftSet);
+		for(set<string>::const_iterator s = spacecraftSet.begin(); s != spacecraftSet.end(); ++s)
 		{
-			cout << *j;
+			ephemCache.addJob(V->getSourceByDefName(*s), j->mjdStart, j->mjdStop);
 		}
+	}
+	{
+		DifxInput *D = newDifxInput();
+
+		populateEOPTable(D, V->getEOPs());
+		ephemCache.compute(D->eop, D->nEOP, verbose);
+		deleteDifxInput(D);
+	}
+
+	// Likewise each pulsar bin config file and its polycos are read only once
+	for(vector<Job>::const_iterator j = J.begin(); j != J.end(); ++j)
+	{
 		if(j->jobSeries == "-")
 		{
-			++nSkip;
+			continue;
 		}
-		else
+		for(vector<string>::const_iterator si = j->scans.begin(); si != j->scans.end(); ++si)
 		{
-			nJob += writeJob(*j, V, P, events, shelves, verbose, &of, nDigit, 0, strict);
+			const VexScan *scan = V->getScanByDefName(*si);
+			const CorrSetup *corrSetup;
+
+			if(!scan)
+			{
+				continue;
+			}
+			corrSetup = P->getCorrSetup(P->findSetup(scan->defName, scan->sourceDefName, scan->modeDefName));
+			if(corrSetup && !corrSetup->binConfigFile.empty())
+			{
+				pulsarCache.add(corrSetup->binConfigFile);
+			}
 		}
 	}
+	pulsarCache.load(verbose);
+
+	runJobWriteTasks(jobWriteTasks, V, P, events, shelves, configCache, ephemCache, pulsarCache, verbose, nDigit, strict, nJobThread);
+
+	// Emit in job order regardless of which job finished first
+	for(vector<JobWriteTask>::const_iterator t = jobWriteTasks.begin(); t != jobWriteTasks.end(); ++t)
+	{
+		of << t->jobListEntry;
+		nJob += t->created;
+	}
 	of.close();
 
 	cout << endl;
 	cout << nJob << " job(s) created." << endl;
 
+	if(verbose > 0)
+	{
+		cout << "VexData name lookups: " << V->getNameLookupCount() << " using " << V->getIndexBuildCount() << " index build(s)" << endl;
+		cout << "Configuration cache: " << configCache.nHit() << " hit(s), " << configCache.nMiss() << " miss(es)" << endl;
+	}
+
 	if(nJob > 0 && P->v2dComment.length() > 0)
 	{
 		cout << endl;
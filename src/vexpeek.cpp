@@ -77,6 +77,12 @@ void usage(const char *pgm)
 double totalDiskUsageGB(const VexData *V, const std::string &antName, double* rate = NULL)
 {
 	double GB = 0.0;
+	int antId = V->getStationNames().getId(antName);
+
+	if(antId < 0)
+	{
+		return GB;
+	}
 
 	for(unsigned int s = 0; s < V->nScan(); ++s)
 	{
@@ -86,7 +92,7 @@ double totalDiskUsageGB(const VexData *V, const std::string &antName, double* ra
 			continue;
 		}
 
-		const Interval *I = scan->getAntennaInterval(antName);
+		const Interval *I = scan->getStation(static_cast<unsigned int>(antId));
 		if(!I)
 		{
 			continue;
@@ -124,34 +130,35 @@ void antennaSummary(const VexData *V, int doFormat, int doUsage)
 	{
 		const VexScan *scan = V->getScan(s);
 
-		for(std::map<std::string,Interval>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
+		for(std::vector<VexScanStation>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
 		{
-			const Interval &vi = it->second;
+			const Interval &vi = *it;
+			const std::string &antName = scan->getStationName(*it);
 
-			if(as.count(it->first) == 0)
+			if(as.count(antName) == 0)
 			{
-				as[it->first] = Interval(vi);
+				as[antName] = Interval(vi);
 
 				// get format
 				const VexMode *M = V->getModeByDefName(scan->modeDefName);
 				if(M)
 				{
-					const VexSetup *S = M->getSetup(it->first);
+					const VexSetup *S = M->getSetup(antName);
 					if(S)
 					{
-						af[it->first] = VexStream::DataFormatNames[S->streams[0].format];
+						af[antName] = VexStream::DataFormatNames[S->streams[0].format];
 					}
 				}
 			}
 			else
 			{
-				if(vi.mjdStart < as[it->first].mjdStart)
+				if(vi.mjdStart < as[antName].mjdStart)
 				{
-					as[it->first].mjdStart = vi.mjdStart;
+					as[antName].mjdStart = vi.mjdStart;
 				}
-				if(vi.mjdStop > as[it->first].mjdStop)
+				if(vi.mjdStop > as[antName].mjdStop)
 				{
-					as[it->first].mjdStop = vi.mjdStop;
+					as[antName].mjdStop = vi.mjdStop;
 				}
 			}
 		}
@@ -191,23 +198,24 @@ void moduleSummary(VexData *V)
 	{
 		const VexScan *scan = V->getScan(s);
 
-		for(std::map<std::string,Interval>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
+		for(std::vector<VexScanStation>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
 		{
-			const Interval &vi = it->second;
+			const Interval &vi = *it;
+			const std::string &antName = scan->getStationName(*it);
 
-			if(as.count(it->first) == 0)
+			if(as.count(antName) == 0)
 			{
-				as[it->first] = Interval(vi);
+				as[antName] = Interval(vi);
 			}
 			else
 			{
-				if(vi.mjdStart < as[it->first].mjdStart)
+				if(vi.mjdStart < as[antName].mjdStart)
 				{
-					as[it->first].mjdStart = vi.mjdStart;
+					as[antName].mjdStart = vi.mjdStart;
 				}
-				if(vi.mjdStop > as[it->first].mjdStop)
+				if(vi.mjdStop > as[antName].mjdStop)
 				{
-					as[it->first].mjdStop = vi.mjdStop;
+					as[antName].mjdStop = vi.mjdStop;
 				}
 			}
 		}
@@ -242,12 +250,14 @@ void scanList(const VexData *V)
 		std::cout << std::left << std::setw(12) << scan->modeDefName << "   ";
 
 		std::vector<std::string> currStations;
-		for(std::map<std::string,Interval>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
+		for(std::vector<VexScanStation>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
 		{
-			currStations.push_back(it->first);
-			if(std::find(allStations.begin(), allStations.end(), it->first) == allStations.end())
+			const std::string &antName = scan->getStationName(*it);
+
+			currStations.push_back(antName);
+			if(std::find(allStations.begin(), allStations.end(), antName) == allStations.end())
 			{
-				allStations.push_back(it->first);
+				allStations.push_back(antName);
 			}
 		}
 		for(std::vector<std::string>::iterator it = allStations.begin(); it != allStations.end(); ++it)
@@ -273,9 +283,9 @@ void scanListWithTimes(const VexData *V)
 		std::cout << std::left << std::setw(12) << scan->modeDefName << "   ";
 
 		std::cout.precision(14);
-		for(std::map<std::string,Interval>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
+		for(std::vector<VexScanStation>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
 		{
-			std::cout << it->first << " " << it->second.mjdStart << " " << it->second.mjdStop << "  ";
+			std::cout << scan->getStationName(*it) << " " << it->mjdStart << " " << it->mjdStop << "  ";
 		}
 		std::cout << std::endl;
 	}
@@ -288,14 +298,16 @@ void scanListByAntenna(const VexData *V, const char *ant)
 		const VexScan *scan = V->getScan(s);
 
 		std::cout.precision(14);
-		for(std::map<std::string,Interval>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
+		for(std::vector<VexScanStation>::const_iterator it = scan->stations.begin(); it != scan->stations.end(); ++it)
 		{
-			if(strcasecmp(ant, it->first.c_str()) == 0)
+			const std::string &antName = scan->getStationName(*it);
+
+			if(strcasecmp(ant, antName.c_str()) == 0)
 			{
 				std::cout << std::left << std::setw(8) << scan->defName << " ";
 				std::cout << std::left << std::setw(12) << scan->sourceDefName << " ";
 				std::cout << std::left << std::setw(12) << scan->modeDefName << "   ";
-				std::cout << it->first << " " << it->second.mjdStart << " " << it->second.mjdStop;
+				std::cout << antName << " " << it->mjdStart << " " << it->mjdStop;
 				std::cout << std::endl;
 			}
 		}
@@ -51,9 +51,12 @@ struct llist {
 
 typedef struct llist Llist;
 
+struct open_vex;
+
 struct vex {
   struct llist *version;
   struct llist *blocks;
+  struct open_vex *open;	/* local addition: set by vex_open_r() */
 };
 
 typedef struct vex Vex;
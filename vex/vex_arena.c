@@ -0,0 +1,161 @@
+/*
+ * A simple bump allocator for the VEX parse tree; see vex_arena.h.
+ *
+ * This file is a local addition and is not part of the NVI distribution.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "vex_arena.h"
+
+/* all allocations are aligned to this */
+#define ARENA_ALIGN 16
+
+struct vex_arena_chunk {
+  struct vex_arena_chunk *next;
+  size_t size;			/* usable bytes following this header */
+  size_t used;
+};
+
+/* size of the chunk header, rounded up to keep data aligned */
+#define CHUNK_HEADER \
+  ((sizeof(struct vex_arena_chunk)+ARENA_ALIGN-1)&~(size_t)(ARENA_ALIGN-1))
+
+struct vex_arena {
+  struct vex_arena_chunk *chunks;	/* most recent first */
+  size_t chunk_size;
+  size_t total;
+};
+
+struct vex_arena *vex_parse_arena=NULL;
+struct vex_arena *vex_list_arena=NULL;
+
+/*---------------------------------------------------------------------------*/
+static struct vex_arena_chunk *
+new_chunk(struct vex_arena *arena, size_t size)
+{
+  struct vex_arena_chunk *chunk;
+
+  chunk=(struct vex_arena_chunk *)malloc(CHUNK_HEADER+size);
+  if(chunk==NULL)
+    return NULL;
+
+  chunk->size=size;
+  chunk->used=0;
+  chunk->next=arena->chunks;
+  arena->chunks=chunk;
+  arena->total+=CHUNK_HEADER+size;
+
+  return chunk;
+}
+/*---------------------------------------------------------------------------*/
+struct vex_arena *
+vex_arena_new(size_t chunk_size)
+{
+  struct vex_arena *arena;
+
+  arena=(struct vex_arena *)calloc(1,sizeof(struct vex_arena));
+  if(arena==NULL)
+    return NULL;
+
+  arena->chunk_size=chunk_size;
+
+  return arena;
+}
+/*---------------------------------------------------------------------------*/
+void
+vex_arena_delete(struct vex_arena *arena)
+{
+  struct vex_arena_chunk *chunk, *next;
+
+  if(arena==NULL)
+    return;
+
+  for(chunk=arena->chunks; chunk!=NULL; chunk=next) {
+    next=chunk->next;
+    free(chunk);
+  }
+  free(arena);
+}
+/*---------------------------------------------------------------------------*/
+void *
+vex_arena_alloc(struct vex_arena *arena, size_t size)
+{
+  struct vex_arena_chunk *chunk;
+  void *ptr;
+
+  size=(size+ARENA_ALIGN-1)&~(size_t)(ARENA_ALIGN-1);
+
+  chunk=arena->chunks;
+  if(chunk==NULL || chunk->size-chunk->used < size) {
+    /* oversized requests get a chunk of their own */
+    chunk=new_chunk(arena,size > arena->chunk_size ? size : arena->chunk_size);
+    if(chunk==NULL)
+      return NULL;
+  }
+
+  ptr=(char *)chunk+CHUNK_HEADER+chunk->used;
+  chunk->used+=size;
+
+  return ptr;
+}
+/*---------------------------------------------------------------------------*/
+char *
+vex_arena_strdup(struct vex_arena *arena, const char *str)
+{
+  size_t len=strlen(str)+1;
+  char *ptr;
+
+  ptr=(char *)vex_arena_alloc(arena,len);
+  if(ptr!=NULL)
+    memcpy(ptr,str,len);
+
+  return ptr;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+vex_arena_size(const struct vex_arena *arena)
+{
+  return arena->total;
+}
+/*---------------------------------------------------------------------------*/
+void *
+vex_malloc(size_t size)
+{
+  if(vex_parse_arena!=NULL)
+    return vex_arena_alloc(vex_parse_arena,size);
+
+  return malloc(size);
+}
+/*---------------------------------------------------------------------------*/
+void *
+vex_list_malloc(size_t size)
+{
+  if(vex_list_arena!=NULL)
+    return vex_arena_alloc(vex_list_arena,size);
+
+  return malloc(size);
+}
+/*---------------------------------------------------------------------------*/
+char *
+vex_strdup(const char *str)
+{
+  if(vex_parse_arena!=NULL)
+    return vex_arena_strdup(vex_parse_arena,str);
+
+  return strdup(str);
+}
+/*---------------------------------------------------------------------------*/
+char *
+vex_keep_string(char *str)
+{
+  char *copy;
+
+  if(vex_parse_arena==NULL || str==NULL)
+    return str;
+
+  copy=vex_arena_strdup(vex_parse_arena,str);
+  if(copy!=NULL)
+    free(str);
+
+  return copy;
+}
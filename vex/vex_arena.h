@@ -0,0 +1,52 @@
+/*
+ * A simple bump allocator for the VEX parse tree.
+ *
+ * Memory is handed out from large chunks and is only released all at
+ * once by vex_arena_delete().  While vex_open_r() is parsing,
+ * vex_parse_arena and vex_list_arena point at the arenas for that parse:
+ * the scanner and the make_*() functions of vex_util.c allocate token
+ * strings and tree nodes from the former and Llist and Lowl nodes from
+ * the latter, so that the spine of the tree walked by the get_*()
+ * functions is packed together.  At other times both are NULL and the
+ * allocation functions below fall back to malloc() and strdup().
+ *
+ * This file is a local addition and is not part of the NVI distribution.
+ */
+
+#ifndef __VEX_ARENA_H__
+#define __VEX_ARENA_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vex_arena;
+
+extern struct vex_arena *vex_parse_arena;
+extern struct vex_arena *vex_list_arena;
+
+struct vex_arena *vex_arena_new(size_t chunk_size);
+void vex_arena_delete(struct vex_arena *arena);
+void *vex_arena_alloc(struct vex_arena *arena, size_t size);
+char *vex_arena_strdup(struct vex_arena *arena, const char *str);
+
+/* total bytes obtained from the system by this arena */
+size_t vex_arena_size(const struct vex_arena *arena);
+
+/* allocate from vex_parse_arena or vex_list_arena if set */
+void *vex_malloc(size_t size);
+void *vex_list_malloc(size_t size);
+
+/* strdup() into vex_parse_arena if set */
+char *vex_strdup(const char *str);
+
+/* move a malloc()ed string into vex_parse_arena if set */
+char *vex_keep_string(char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,791 @@
+/*
+ * Re-entrant counterparts of the vex_get.c query functions; see
+ * vex_cursor.h.  The traversal logic follows that of vex_get.c exactly,
+ * with each function's static state moved into struct vex_cursor.
+ *
+ * This file is a local addition and is not part of the NVI distribution.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "vex.h"
+#include "vex_parse.tab.h"
+#include "vex_cursor.h"
+#include "vex_index.h"
+#include "vex_arena.h"
+
+#define TRUE 1
+#define FALSE 0
+
+/* phases of get_all_lowl_r(): mode, then station, then global scope */
+#define PHASE_MODE    1
+#define PHASE_STATION 2
+#define PHASE_GLOBAL  3
+#define PHASE_DONE    4
+
+/* sizes of the arena chunks holding the tree, and its list nodes */
+#define NODE_CHUNK_SIZE (256*1024)
+#define LIST_CHUNK_SIZE (64*1024)
+
+extern struct vex *vex_ptr;
+
+void *vex_lex_scan_buffer(char *base, size_t size);
+void vex_lex_delete_buffer(void *buffer);
+
+/* memory holding a tree opened by vex_open_r(), released by vex_close();
+ * reached from the tree through vex->open */
+struct open_vex {
+  struct vex_arena *arena;
+  struct vex_arena *list_arena;
+  struct vex_index *index;	/* NULL if there was no memory to build it */
+};
+
+static pthread_mutex_t vex_parse_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*---------------------------------------------------------------------------*/
+/*
+ * Read file `name' into a writable buffer of *size bytes followed by two
+ * zero bytes, as the scanner requires.  The file is mapped rather than
+ * copied when the zero padding falls within its last page.
+ */
+static char *
+load_file(const char *name, size_t *size, int *mapped)
+{
+  struct stat st;
+  long page;
+  char *base=NULL;
+  size_t n;
+  ssize_t got;
+  int fd;
+
+  *mapped=FALSE;
+
+  fd=open(name,O_RDONLY);
+  if(fd<0)
+    return NULL;
+
+  if(fstat(fd,&st)<0) {
+    close(fd);
+    return NULL;
+  }
+  *size=st.st_size;
+
+  page=sysconf(_SC_PAGESIZE);
+  if(*size>0 && page>0 && page-(long)(*size%page)>=2 && *size%page!=0) {
+    base=(char *)mmap(NULL,*size+2,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+    if(base==MAP_FAILED)
+      base=NULL;
+    else
+      *mapped=TRUE;
+  }
+
+  if(base==NULL) {
+    base=(char *)malloc(*size+2);
+    if(base==NULL) {
+      close(fd);
+      return NULL;
+    }
+    for(n=0; n<*size; n+=got) {
+      got=read(fd,base+n,*size-n);
+      if(got<=0) {
+	free(base);
+	close(fd);
+	return NULL;
+      }
+    }
+    base[*size]=0;
+    base[*size+1]=0;
+  }
+
+  close(fd);
+
+  return base;
+}
+/*---------------------------------------------------------------------------*/
+static void
+unload_file(char *base, size_t size, int mapped)
+{
+  if(mapped)
+    munmap(base,size+2);
+  else
+    free(base);
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+
+  return t.tv_sec+t.tv_usec*1.0e-6;
+}
+/*---------------------------------------------------------------------------*/
+int vex_open_r(const char *name, struct vex **vex, struct vex_parse_stats *stats)
+{
+  struct open_vex *open;
+  struct rusage usage;
+  void *buffer;
+  char *base;
+  size_t size;
+  int mapped;
+  double t0;
+  int r=0;
+
+  *vex=NULL;
+  t0=now();
+
+  open=(struct open_vex *)calloc(1,sizeof(struct open_vex));
+  if(open==NULL)
+    return -1;
+
+  base=load_file(name,&size,&mapped);
+  if(base==NULL) {
+    free(open);
+    return -1;
+  }
+
+  /* all of the tree, including its strings, lives in these two arenas */
+  open->arena=vex_arena_new(NODE_CHUNK_SIZE);
+  open->list_arena=vex_arena_new(LIST_CHUNK_SIZE);
+  if(open->arena==NULL || open->list_arena==NULL) {
+    vex_arena_delete(open->arena);
+    vex_arena_delete(open->list_arena);
+    free(open);
+    unload_file(base,size,mapped);
+    return -1;
+  }
+
+  pthread_mutex_lock(&vex_parse_lock);
+  vex_ptr=NULL;
+  vex_parse_arena=open->arena;
+  vex_list_arena=open->list_arena;
+  buffer=vex_lex_scan_buffer(base,size+2);
+  if(yyparse())
+    r=-2;
+  else
+    *vex=vex_ptr;
+  vex_lex_delete_buffer(buffer);
+  vex_parse_arena=NULL;
+  vex_list_arena=NULL;
+  vex_ptr=NULL;
+  pthread_mutex_unlock(&vex_parse_lock);
+
+  unload_file(base,size,mapped);
+
+  if(*vex==NULL) {
+    vex_arena_delete(open->arena);
+    vex_arena_delete(open->list_arena);
+    free(open);
+    return r;
+  }
+
+  open->index=vex_index_build(*vex);
+
+  if(stats!=NULL) {
+    getrusage(RUSAGE_SELF,&usage);
+    stats->file_size=size;
+    stats->mapped=mapped;
+    stats->arena_size=vex_arena_size(open->arena)+vex_arena_size(open->list_arena);
+    stats->parse_time=now()-t0;
+    stats->peak_rss=usage.ru_maxrss;
+  }
+
+  (*vex)->open=open;
+
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+void vex_close(struct vex *vex)
+{
+  struct open_vex *open;
+
+  if(vex==NULL || vex->open==NULL)
+    return;
+
+  /* vex itself lives in the arenas */
+  open=vex->open;
+  vex->open=NULL;
+
+  vex_index_free(open->index);
+  vex_arena_delete(open->arena);
+  vex_arena_delete(open->list_arena);
+  free(open);
+}
+/*---------------------------------------------------------------------------*/
+static void
+cursor_reset(struct vex_cursor *cursor, struct vex *vex)
+{
+  memset(cursor,0,sizeof(struct vex_cursor));
+  cursor->vex=vex;
+  if(vex!=NULL && vex->open!=NULL)
+    cursor->index=vex->open->index;
+}
+/*---------------------------------------------------------------------------*/
+/* find_block(), using the index if there is one */
+static Llist *
+cursor_block(struct vex_cursor *cursor, int block)
+{
+  if(cursor->index!=NULL)
+    return vex_index_block(cursor->index,block);
+
+  return find_block(block,cursor->vex);
+}
+/*---------------------------------------------------------------------------*/
+/* find_def() in the given block of type block, using the index if there is one */
+static Llist *
+cursor_def(struct vex_cursor *cursor, int block, Llist *blocks, const char *name)
+{
+  if(cursor->index!=NULL)
+    return vex_index_def(cursor->index,block,name);
+
+  return find_def(((struct block *)blocks->ptr)->items,name);
+}
+/*---------------------------------------------------------------------------*/
+/* step through cursor->lowls returning each item of type cursor->statement */
+static void *
+next_lowl(struct vex_cursor *cursor)
+{
+  Llist *lowls_this;
+
+  cursor->lowls=find_lowl(cursor->lowls,cursor->statement);
+  if(cursor->lowls==NULL) {
+    cursor->state=FALSE;
+    return NULL;
+  }
+
+  cursor->state=TRUE;
+
+  lowls_this=cursor->lowls;
+  cursor->lowls=cursor->lowls->next;
+  return ((Lowl *)lowls_this->ptr)->item;
+}
+/*---------------------------------------------------------------------------*/
+/* step through the defs of one block returning each def name */
+static char *
+next_def_name(struct vex_cursor *cursor)
+{
+  Llist *defs_this;
+
+  cursor->defs=find_next_def(cursor->defs);
+  if(cursor->defs==NULL) {
+    cursor->state=FALSE;
+    return NULL;
+  }
+
+  cursor->state=TRUE;
+
+  defs_this=cursor->defs;
+  cursor->defs=cursor->defs->next;
+  return ((Def *)((Lowl *)defs_this->ptr)->item)->name;
+}
+/*---------------------------------------------------------------------------*/
+static char *
+start_def_name(struct vex_cursor *cursor, int block, struct vex *vex)
+{
+  Llist *blocks;
+
+  cursor_reset(cursor,vex);
+
+  blocks=cursor_block(cursor,block);
+  if(blocks==NULL)
+    return NULL;
+
+  cursor->defs=((struct block *)blocks->ptr)->items;
+
+  return next_def_name(cursor);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Walk cursor->refs (a list of Qrefs) looking for references to the
+ * primitive block cursor->blocks and return each matching statement in
+ * the referenced defs.  If qualify is set, qualified refs must name
+ * cursor->station (as within a $MODE def).
+ */
+static void *
+next_ref_lowl(struct vex_cursor *cursor, int qualify)
+{
+  Llist *qualifiers, *lowls_this;
+  Llist *defs;
+  Qref *qref;
+
+  if(cursor->state)
+    goto lstate;
+
+lstart:
+  if(cursor->refs==NULL || cursor->refs->ptr==NULL)
+    goto ldone;
+
+  qref=(Qref *)((Lowl *)cursor->refs->ptr)->item;
+
+  if(qref->primitive!=cursor->primitive)
+    goto lend;
+
+  if(qualify) {
+    qualifiers=qref->qualifiers;
+
+    while(qualifiers!=NULL && qualifiers->ptr != NULL
+	  && (cursor->station==NULL
+	      || 0!=strcmp((char *)qualifiers->ptr,cursor->station)))
+      qualifiers=qualifiers->next;
+
+    if(qualifiers != NULL && qualifiers->ptr == NULL)
+      goto lend;
+
+    if(qualifiers==NULL && NULL!=qref->qualifiers)
+      goto lend;
+  }
+
+  /* find this def */
+
+  defs=cursor_def(cursor,cursor->primitive,cursor->blocks,qref->name);
+  if(defs==NULL)
+    goto lend;
+
+  cursor->lowls=((Def *)((Lowl *)defs->ptr)->item)->refs;
+
+lstate:
+  cursor->lowls=find_lowl(cursor->lowls,cursor->statement);
+  if(cursor->lowls==NULL)
+    goto lend;
+
+  cursor->state=TRUE;
+
+  lowls_this=cursor->lowls;
+  cursor->lowls=cursor->lowls->next;
+  return ((Lowl *)lowls_this->ptr)->item;
+
+lend:
+  cursor->refs=cursor->refs->next;
+  goto lstart;
+
+ldone:
+  cursor->state=FALSE;
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Point cursor->refs at the refs of def `name' in block `block', and
+ * cursor->blocks at the primitive block.  Returns FALSE if any is missing.
+ */
+static int
+start_def_refs(struct vex_cursor *cursor, int block, const char *name)
+{
+  Llist *blocks;
+  Llist *defs;
+
+  cursor->state=FALSE;
+
+  if(name==NULL)
+    return FALSE;
+
+  blocks=cursor_block(cursor,block);
+  if(blocks==NULL)
+    return FALSE;
+
+  defs=cursor_def(cursor,block,blocks,name);
+  if(defs==NULL)
+    return FALSE;
+
+  cursor->refs=((Def *)((Lowl *)defs->ptr)->item)->refs;
+
+  cursor->blocks=cursor_block(cursor,cursor->primitive);
+
+  return cursor->blocks!=NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+start_global_refs(struct vex_cursor *cursor)
+{
+  Llist *blocks;
+
+  cursor->state=FALSE;
+
+  blocks=cursor_block(cursor,B_GLOBAL);
+  if(blocks==NULL)
+    return FALSE;
+
+  cursor->refs=((struct block *)blocks->ptr)->items;
+
+  cursor->blocks=cursor_block(cursor,cursor->primitive);
+
+  return cursor->blocks!=NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+start_phase(struct vex_cursor *cursor)
+{
+  switch(cursor->phase) {
+  case PHASE_MODE:
+    return start_def_refs(cursor,B_MODE,cursor->mode);
+  case PHASE_STATION:
+    return start_def_refs(cursor,B_STATION,cursor->station);
+  case PHASE_GLOBAL:
+    return start_global_refs(cursor);
+  default:
+    return FALSE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+char *
+get_source_def_r(struct vex_cursor *cursor, struct vex *vex)
+{
+  return start_def_name(cursor,B_SOURCE,vex);
+}
+/*---------------------------------------------------------------------------*/
+char *
+get_source_def_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_def_name(cursor);
+}
+/*---------------------------------------------------------------------------*/
+char *
+get_mode_def_r(struct vex_cursor *cursor, struct vex *vex)
+{
+  return start_def_name(cursor,B_MODE,vex);
+}
+/*---------------------------------------------------------------------------*/
+char *
+get_mode_def_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_def_name(cursor);
+}
+/*---------------------------------------------------------------------------*/
+char *
+get_station_def_r(struct vex_cursor *cursor, struct vex *vex)
+{
+  return start_def_name(cursor,B_STATION,vex);
+}
+/*---------------------------------------------------------------------------*/
+char *
+get_station_def_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_def_name(cursor);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+all_lowl_step(struct vex_cursor *cursor, int fresh)
+{
+  void *ptr;
+
+  for(;;) {
+    if(fresh) {
+      fresh=FALSE;
+      if(start_phase(cursor)) {
+        ptr=next_ref_lowl(cursor,cursor->phase==PHASE_MODE);
+        if(ptr!=NULL)
+          return ptr;
+      }
+    }
+    else if(cursor->state) {
+      ptr=next_ref_lowl(cursor,cursor->phase==PHASE_MODE);
+      if(ptr!=NULL)
+        return ptr;
+    }
+
+    /* this scope is exhausted; fall back to the next wider one */
+
+    cursor->state=FALSE;
+    if(cursor->phase>=PHASE_GLOBAL) {
+      cursor->phase=PHASE_DONE;
+      return NULL;
+    }
+    cursor->phase++;
+    fresh=TRUE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_all_lowl_r(struct vex_cursor *cursor, const char *station, const char *mode,
+	       int statement, int primitive, struct vex *vex)
+{
+  cursor_reset(cursor,vex);
+  cursor->station=station;
+  cursor->mode=mode;
+  cursor->statement=statement;
+  cursor->primitive=primitive;
+
+  if(mode==NULL && station==NULL)
+    cursor->phase=PHASE_GLOBAL;
+  else if(mode==NULL)
+    cursor->phase=PHASE_STATION;
+  else
+    cursor->phase=PHASE_MODE;
+
+  return all_lowl_step(cursor,TRUE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_all_lowl_next_r(struct vex_cursor *cursor)
+{
+  if(cursor->vex==NULL || cursor->phase==PHASE_DONE)
+    return NULL;
+
+  return all_lowl_step(cursor,FALSE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_mode_lowl_r(struct vex_cursor *cursor, const char *station, const char *mode,
+		int statement, int primitive, struct vex *vex)
+{
+  cursor_reset(cursor,vex);
+  cursor->station=station;
+  cursor->mode=mode;
+  cursor->statement=statement;
+  cursor->primitive=primitive;
+
+  if(!start_def_refs(cursor,B_MODE,mode))
+    return NULL;
+
+  return next_ref_lowl(cursor,TRUE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_mode_lowl_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_ref_lowl(cursor,TRUE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_station_lowl_r(struct vex_cursor *cursor, const char *station,
+		   int statement, int primitive, struct vex *vex)
+{
+  cursor_reset(cursor,vex);
+  cursor->station=station;
+  cursor->statement=statement;
+  cursor->primitive=primitive;
+
+  if(!start_def_refs(cursor,B_STATION,station))
+    return NULL;
+
+  return next_ref_lowl(cursor,FALSE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_station_lowl_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_ref_lowl(cursor,FALSE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_global_lowl_r(struct vex_cursor *cursor, int statement, int primitive, struct vex *vex)
+{
+  cursor_reset(cursor,vex);
+  cursor->statement=statement;
+  cursor->primitive=primitive;
+
+  if(!start_global_refs(cursor))
+    return NULL;
+
+  return next_ref_lowl(cursor,FALSE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_global_lowl_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_ref_lowl(cursor,FALSE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_source_lowl_r(struct vex_cursor *cursor, const char *source, int statement, struct vex *vex)
+{
+  Llist *blocks;
+  Llist *defs;
+
+  cursor_reset(cursor,vex);
+  cursor->source=source;
+  cursor->statement=statement;
+
+  if(source==NULL)
+    return NULL;
+
+  /* find $SOURCE block */
+
+  blocks=cursor_block(cursor,B_SOURCE);
+  if(blocks==NULL)
+    return NULL;
+
+  /* find this def */
+
+  defs=cursor_def(cursor,B_SOURCE,blocks,source);
+  if(defs==NULL)
+    return NULL;
+
+  cursor->lowls=((Def *)((Lowl *)defs->ptr)->item)->refs;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_source_lowl_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+next_scan(struct vex_cursor *cursor, char **scanid)
+{
+  Llist *defs_this;
+
+  cursor->defs=find_next_scan(cursor->defs);
+  if(cursor->defs==NULL) {
+    cursor->state=FALSE;
+    return NULL;
+  }
+
+  cursor->state=TRUE;
+
+  defs_this=cursor->defs;
+  cursor->defs=cursor->defs->next;
+  *scanid=((Def *)((Lowl *)defs_this->ptr)->item)->name;
+  return ((Def *)((Lowl *)defs_this->ptr)->item)->refs;
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_r(struct vex_cursor *cursor, char **scanid, struct vex *vex)
+{
+  Llist *blocks;
+
+  cursor_reset(cursor,vex);
+
+  /* find $SCHED block */
+
+  blocks=cursor_block(cursor,B_SCHED);
+  if(blocks==NULL)
+    return NULL;
+
+  cursor->defs=((struct block *)blocks->ptr)->items;
+
+  return next_scan(cursor,scanid);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_next_r(struct vex_cursor *cursor, char **scanid)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_scan(cursor,scanid);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+start_scan_lowl(struct vex_cursor *cursor, Llist *lowls, int statement)
+{
+  cursor_reset(cursor,NULL);
+  cursor->lowls=lowls;
+  cursor->statement=statement;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_station_scan_r(struct vex_cursor *cursor, Llist *lowls)
+{
+  return start_scan_lowl(cursor,lowls,T_STATION);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_station_scan_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_source2_r(struct vex_cursor *cursor, Llist *lowls)
+{
+  return start_scan_lowl(cursor,lowls,T_SOURCE);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_source2_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_intent_r(struct vex_cursor *cursor, Llist *lowls)
+{
+  return start_scan_lowl(cursor,lowls,T_INTENT);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_intent_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_pointing_offset_r(struct vex_cursor *cursor, Llist *lowls)
+{
+  return start_scan_lowl(cursor,lowls,T_POINTING_OFFSET);
+}
+/*---------------------------------------------------------------------------*/
+void *
+get_scan_pointing_offset_next_r(struct vex_cursor *cursor)
+{
+  if(!cursor->state)
+    return NULL;
+
+  return next_lowl(cursor);
+}
+/*---------------------------------------------------------------------------*/
+Llist *
+find_block_r(int block, struct vex *vex)
+{
+  struct vex_cursor cursor;
+
+  cursor_reset(&cursor,vex);
+
+  return cursor_block(&cursor,block);
+}
+/*---------------------------------------------------------------------------*/
+Llist *
+find_def_r(int block, const char *name, struct vex *vex)
+{
+  struct vex_cursor cursor;
+  Llist *blocks;
+
+  cursor_reset(&cursor,vex);
+  blocks=cursor_block(&cursor,block);
+  if(blocks==NULL)
+    return NULL;
+
+  return cursor_def(&cursor,block,blocks,name);
+}
@@ -0,0 +1,105 @@
+/*
+ * Re-entrant counterparts of the vex_get.c query functions.
+ *
+ * The legacy get_*() / get_*_next() functions keep their position in
+ * function-level static variables, so only one iteration of each kind
+ * can be in flight per process.  The functions below keep that state in
+ * a caller-owned struct vex_cursor instead, so any number of iterations
+ * over any number of parsed files may proceed concurrently.  The parse
+ * tree is only read, never modified, by these functions.
+ *
+ * vex_open_r() may be called from several threads; the underlying
+ * flex/bison parser is not re-entrant so parses are serialized
+ * internally and the lexer state is reset before each one.  The file is
+ * scanned in place from a memory map where possible and the whole tree
+ * is allocated from arenas (see vex_arena.h), so that vex_close() can
+ * release it at once.  vex_open_r() also
+ * builds a hash index of the tree (see vex_index.h) that the functions
+ * below use to resolve block and def references.
+ *
+ * This file is a local addition and is not part of the NVI distribution.
+ */
+
+#ifndef __VEX_CURSOR_H__
+#define __VEX_CURSOR_H__
+
+#include "vex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vex_index;
+
+struct vex_cursor {
+  struct vex *vex;
+  const struct vex_index *index;	/* NULL if vex has not been indexed */
+  const char *station;
+  const char *mode;
+  const char *source;
+  int primitive;
+  int statement;
+  Llist *blocks;
+  Llist *refs;
+  Llist *lowls;
+  Llist *defs;
+  int state;
+  int phase;
+};
+
+struct vex_parse_stats {
+  size_t file_size;		/* bytes */
+  int mapped;			/* non-zero if the file was scanned in place via mmap */
+  size_t arena_size;		/* bytes of storage for the tree */
+  double parse_time;		/* seconds, including index construction */
+  long peak_rss;		/* peak resident set size of the process, kB */
+};
+
+/* stats may be NULL */
+int vex_open_r(const char *name, struct vex **vex, struct vex_parse_stats *stats);
+
+/* Free a tree returned by vex_open_r(); no cursor on it may be used after */
+void vex_close(struct vex *vex);
+
+char *get_source_def_r(struct vex_cursor *cursor, struct vex *vex);
+char *get_source_def_next_r(struct vex_cursor *cursor);
+char *get_mode_def_r(struct vex_cursor *cursor, struct vex *vex);
+char *get_mode_def_next_r(struct vex_cursor *cursor);
+char *get_station_def_r(struct vex_cursor *cursor, struct vex *vex);
+char *get_station_def_next_r(struct vex_cursor *cursor);
+
+void *get_all_lowl_r(struct vex_cursor *cursor, const char *station, const char *mode,
+	int statement, int primitive, struct vex *vex);
+void *get_all_lowl_next_r(struct vex_cursor *cursor);
+void *get_mode_lowl_r(struct vex_cursor *cursor, const char *station, const char *mode,
+	int statement, int primitive, struct vex *vex);
+void *get_mode_lowl_next_r(struct vex_cursor *cursor);
+void *get_station_lowl_r(struct vex_cursor *cursor, const char *station,
+	int statement, int primitive, struct vex *vex);
+void *get_station_lowl_next_r(struct vex_cursor *cursor);
+void *get_source_lowl_r(struct vex_cursor *cursor, const char *source, int statement, struct vex *vex);
+void *get_source_lowl_next_r(struct vex_cursor *cursor);
+void *get_global_lowl_r(struct vex_cursor *cursor, int statement, int primitive, struct vex *vex);
+void *get_global_lowl_next_r(struct vex_cursor *cursor);
+
+void *get_scan_r(struct vex_cursor *cursor, char **scanid, struct vex *vex);
+void *get_scan_next_r(struct vex_cursor *cursor, char **scanid);
+void *get_station_scan_r(struct vex_cursor *cursor, Llist *lowls);
+void *get_station_scan_next_r(struct vex_cursor *cursor);
+void *get_scan_source2_r(struct vex_cursor *cursor, Llist *lowls);
+void *get_scan_source2_next_r(struct vex_cursor *cursor);
+void *get_scan_intent_r(struct vex_cursor *cursor, Llist *lowls);
+void *get_scan_intent_next_r(struct vex_cursor *cursor);
+void *get_scan_pointing_offset_r(struct vex_cursor *cursor, Llist *lowls);
+void *get_scan_pointing_offset_next_r(struct vex_cursor *cursor);
+
+/* find_block(block, vex) and find_def() in the items of that block, using
+ * the index of a tree opened by vex_open_r() */
+Llist *find_block_r(int block, struct vex *vex);
+Llist *find_def_r(int block, const char *name, struct vex *vex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
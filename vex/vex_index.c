@@ -0,0 +1,189 @@
+/*
+ * Hash indexes over a parsed VEX tree; see vex_index.h.
+ *
+ * This file is a local addition and is not part of the NVI distribution.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vex.h"
+#include "vex_parse.tab.h"
+#include "vex_index.h"
+
+struct block_entry {
+  int block;
+  Llist *blocks;		/* as returned by find_block(); NULL if unused */
+};
+
+struct def_entry {
+  int block;
+  const char *name;		/* NULL if unused */
+  Llist *defs;			/* as returned by find_def() */
+};
+
+struct vex_index {
+  unsigned int block_mask;	/* table size - 1; size is a power of 2 */
+  struct block_entry *block_table;
+
+  unsigned int def_mask;
+  struct def_entry *def_table;
+};
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+hash_block(int block)
+{
+  unsigned int h=(unsigned int)block;
+
+  h^=h>>16;
+  h*=0x45d9f3bU;
+  h^=h>>16;
+
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned int
+hash_def(int block, const char *name)
+{
+  /* FNV-1a */
+  unsigned int h=2166136261U^hash_block(block);
+
+  for(; *name; ++name) {
+    h^=(unsigned char)*name;
+    h*=16777619U;
+  }
+
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+/* smallest power of two that is at least twice n */
+static unsigned int
+table_size(unsigned int n)
+{
+  unsigned int size=16;
+
+  while(size < 2*n)
+    size*=2;
+
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static void
+insert_block(struct vex_index *index, int block, Llist *blocks)
+{
+  unsigned int i;
+
+  for(i=hash_block(block)&index->block_mask;
+      index->block_table[i].blocks!=NULL;
+      i=(i+1)&index->block_mask)
+    if(index->block_table[i].block==block)
+      return;			/* keep the first, as find_block() does */
+
+  index->block_table[i].block=block;
+  index->block_table[i].blocks=blocks;
+}
+/*---------------------------------------------------------------------------*/
+static void
+insert_def(struct vex_index *index, int block, const char *name, Llist *defs)
+{
+  unsigned int i;
+
+  for(i=hash_def(block,name)&index->def_mask;
+      index->def_table[i].name!=NULL;
+      i=(i+1)&index->def_mask)
+    if(index->def_table[i].block==block
+       && strcmp(index->def_table[i].name,name)==0)
+      return;			/* keep the first, as find_def() does */
+
+  index->def_table[i].block=block;
+  index->def_table[i].name=name;
+  index->def_table[i].defs=defs;
+}
+/*---------------------------------------------------------------------------*/
+void vex_index_free(struct vex_index *index)
+{
+  if(index==NULL)
+    return;
+
+  free(index->block_table);
+  free(index->def_table);
+  free(index);
+}
+/*---------------------------------------------------------------------------*/
+struct vex_index *
+vex_index_build(const struct vex *vex)
+{
+  struct vex_index *index;
+  Llist *blocks, *defs;
+  unsigned int n_block=0, n_def=0;
+
+  if(vex==NULL)
+    return NULL;
+
+  for(blocks=vex->blocks; blocks!=NULL && blocks->ptr!=NULL; blocks=blocks->next) {
+    n_block++;
+    for(defs=((struct block *)blocks->ptr)->items; defs!=NULL && defs->ptr!=NULL; defs=defs->next)
+      if(((Lowl *)defs->ptr)->statement==T_DEF)
+	n_def++;
+  }
+
+  index=(struct vex_index *)calloc(1,sizeof(struct vex_index));
+  if(index==NULL)
+    return NULL;
+
+  index->block_mask=table_size(n_block)-1;
+  index->def_mask=table_size(n_def)-1;
+  index->block_table=(struct block_entry *)
+    calloc(index->block_mask+1,sizeof(struct block_entry));
+  index->def_table=(struct def_entry *)
+    calloc(index->def_mask+1,sizeof(struct def_entry));
+  if(index->block_table==NULL || index->def_table==NULL) {
+    vex_index_free(index);
+    return NULL;
+  }
+
+  for(blocks=vex->blocks; blocks!=NULL && blocks->ptr!=NULL; blocks=blocks->next) {
+    int block=((struct block *)blocks->ptr)->block;
+
+    /* only the defs of the first block of each type are reachable */
+    if(vex_index_block(index,block)!=NULL)
+      continue;
+
+    insert_block(index,block,blocks);
+
+    for(defs=((struct block *)blocks->ptr)->items; defs!=NULL && defs->ptr!=NULL; defs=defs->next)
+      if(((Lowl *)defs->ptr)->statement==T_DEF)
+	insert_def(index,block,((Def *)((Lowl *)defs->ptr)->item)->name,defs);
+  }
+
+  return index;
+}
+/*---------------------------------------------------------------------------*/
+Llist *
+vex_index_block(const struct vex_index *index, int block)
+{
+  unsigned int i;
+
+  for(i=hash_block(block)&index->block_mask;
+      index->block_table[i].blocks!=NULL;
+      i=(i+1)&index->block_mask)
+    if(index->block_table[i].block==block)
+      return index->block_table[i].blocks;
+
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+Llist *
+vex_index_def(const struct vex_index *index, int block, const char *name)
+{
+  unsigned int i;
+
+  for(i=hash_def(block,name)&index->def_mask;
+      index->def_table[i].name!=NULL;
+      i=(i+1)&index->def_mask)
+    if(index->def_table[i].block==block
+       && strcmp(index->def_table[i].name,name)==0)
+      return index->def_table[i].defs;
+
+  return NULL;
+}
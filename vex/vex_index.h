@@ -0,0 +1,46 @@
+/*
+ * Hash indexes over a parsed VEX tree.
+ *
+ * find_block() and find_def() walk linked lists comparing strings; when
+ * resolving the references of a large $MODE table this is done many
+ * thousands of times.  A struct vex_index, built once after a parse,
+ * maps block type to block and (block type, def name) to def so that
+ * these lookups take constant time.  The first block of a given type
+ * and the first def of a given name within it are indexed, matching the
+ * results of find_block() and find_def().
+ *
+ * vex_open_r() builds one automatically and attaches it to the tree,
+ * where the cursors of vex_cursor.h find it without any search or
+ * locking.
+ *
+ * This file is a local addition and is not part of the NVI distribution.
+ */
+
+#ifndef __VEX_INDEX_H__
+#define __VEX_INDEX_H__
+
+#include "vex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vex_index;
+
+/* Build an index for vex.  Returns NULL if out of memory. */
+struct vex_index *vex_index_build(const struct vex *vex);
+
+/* Free an index returned by vex_index_build(); index may be NULL */
+void vex_index_free(struct vex_index *index);
+
+/* Equivalent to find_block(block, vex) */
+Llist *vex_index_block(const struct vex_index *index, int block);
+
+/* Equivalent to find_def(find_block(block, vex)'s items, name) */
+Llist *vex_index_def(const struct vex_index *index, int block, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
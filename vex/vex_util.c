@@ -23,6 +23,7 @@
 
 #include "vex.h"
 #include "vex_parse.tab.h"
+#include "vex_arena.h"
 
 void yyerror(const char *s);
 
@@ -35,14 +36,20 @@ struct vex_version vex_version;
 
 #define NEWSTRUCTDECLARE(PTR, TYPE) \
             struct TYPE *PTR
-#define NEWSTRUCTALLOC(PTR,TYPE) \
-			PTR=(struct TYPE *) malloc(sizeof(struct TYPE));\
+#define NEWSTRUCTALLOCFROM(PTR,TYPE,ALLOC) \
+			PTR=(struct TYPE *) ALLOC(sizeof(struct TYPE));\
 			if(PTR == NULL) {\
 			    fprintf(stderr,"out of memory allocating type %s\n", #TYPE);\
 			exit(1);}
+#define NEWSTRUCTALLOC(PTR,TYPE) \
+			NEWSTRUCTALLOCFROM(PTR,TYPE,vex_malloc)
 #define NEWSTRUCT(PTR,TYPE)	\
             NEWSTRUCTDECLARE(PTR, TYPE);\
             NEWSTRUCTALLOC(PTR, TYPE)
+/* local addition: list nodes come from their own arena (see vex_arena.h) */
+#define NEWLISTSTRUCT(PTR,TYPE)	\
+            NEWSTRUCTDECLARE(PTR, TYPE);\
+            NEWSTRUCTALLOCFROM(PTR, TYPE, vex_list_malloc)
 
 static int
 get_chan_def_field(Chan_def *chan_def,int n,int *link,int *name, 
@@ -508,7 +515,7 @@ char *make_version(char *str)
 struct llist *add_list(struct llist *start,void *ptr)
 {
   struct llist *last;
-  NEWSTRUCT(new,llist);
+  NEWLISTSTRUCT(new,llist);
 
   new->ptr=ptr;
   new->next=NULL;
@@ -525,7 +532,7 @@ struct llist *add_list(struct llist *start,void *ptr)
 }
 struct llist *ins_list(void *ptr, struct llist *start)
 {
-  NEWSTRUCT(new,llist);
+  NEWLISTSTRUCT(new,llist);
 
   new->ptr=ptr;
   new->next=start;
@@ -570,13 +577,14 @@ struct vex *make_vex(struct llist *version, struct llist *vblocks)
 
   new->version=version;
   new->blocks=vblocks;
+  new->open=NULL;
 
   return new;
 }
 
 struct lowl *make_lowl(int statement,void *item)
 {
-  NEWSTRUCT(new,lowl);
+  NEWLISTSTRUCT(new,lowl);
 
   new->statement=statement;
   new->item=item;
@@ -27,6 +27,9 @@
  *
  *==========================================================================*/
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include "event.h"
 
 // Note: the ordering here is crucial!
@@ -50,39 +53,152 @@ const char Event::eventName[][20] =
 	"Ant Start"
 };
 
-bool operator<(const Event &a, const Event &b)
+const int64_t Event::TimeQuantum = 86400000;	// 1.0e-6 day
+
+const double EventTimeline::RangePadding = 1.0e-5;
+
+// Number of the nearest multiple of Event::TimeQuantum; exact, as TimeQuantum divides a day
+static int64_t quantise(const VexTime &t)
+{
+	return static_cast<int64_t>(t.intMJD())*(VexTime::NanosecondsPerDay/Event::TimeQuantum) + (t.nanosecondsOfDay() + Event::TimeQuantum/2)/Event::TimeQuantum;
+}
+
+int64_t Event::quantisedTime() const
+{
+	return quantise(mjd);
+}
+
+class EventTimelineLess
+{
+public:
+	EventTimelineLess(const EventTimeline *t) : T(t) {}
+	bool operator()(const Event &a, const Event &b) const { return T->less(a, b); }
+private:
+	const EventTimeline *T;
+};
+
+// Range searches compare quantised times, as the timeline is sorted on those
+static bool eventBeforeTime(const Event &e, int64_t q)
+{
+	return e.quantisedTime() < q;
+}
+
+static bool timeBeforeEvent(int64_t q, const Event &e)
+{
+	return q < e.quantisedTime();
+}
+
+EventTimeline::EventTimeline()
 {
-	if(a.mjd < b.mjd - 0.000001)
+	intern("");	// id 0 == NoName
+}
+
+void EventTimeline::clear()
+{
+	events.clear();
+	recordEvents.clear();
+	names.clear();
+	nameIds.clear();
+	intern("");
+}
+
+unsigned int EventTimeline::intern(const std::string &name)
+{
+	std::map<std::string,unsigned int>::const_iterator it = nameIds.find(name);
+
+	if(it != nameIds.end())
 	{
-		return true;
+		return it->second;
 	}
-	else if(a.mjd > b.mjd + 0.000001)
+	names.push_back(name);
+	nameIds[name] = names.size() - 1;
+
+	return names.size() - 1;
+}
+
+int EventTimeline::getId(const std::string &name) const
+{
+	std::map<std::string,unsigned int>::const_iterator it = nameIds.find(name);
+
+	if(it == nameIds.end())
 	{
-		return false;
+		return -1;
 	}
-	if(a.eventType < b.eventType)
+
+	return it->second;
+}
+
+void EventTimeline::add(const VexTime &mjd, Event::EventType eventType, const std::string &name)
+{
+	events.push_back(Event(mjd, eventType, intern(name), NoName));
+}
+
+void EventTimeline::add(const VexTime &mjd, Event::EventType eventType, const std::string &name, const std::string &scan)
+{
+	events.push_back(Event(mjd, eventType, intern(name), intern(scan)));
+}
+
+bool EventTimeline::less(const Event &a, const Event &b) const
+{
+	int64_t qa = a.quantisedTime();
+	int64_t qb = b.quantisedTime();
+
+	if(qa != qb)
+	{
+		return qa < qb;
+	}
+	if(a.eventType != b.eventType)
 	{
-		return true;
+		return a.eventType < b.eventType;
 	}
-	else if(a.eventType > b.eventType)
+	if(a.nameId != b.nameId)
 	{
-		return false;
+		return names[a.nameId] < names[b.nameId];
 	}
 
-	return a.name < b.name;
+	return names[a.scanId] < names[b.scanId];
 }
 
-void addEvent(std::list<Event> &events, double mjd, Event::EventType eventType, const std::string &name)
+void EventTimeline::updateRecordEvents()
 {
-	events.push_back(Event(mjd, eventType, name));
+	recordEvents.clear();
+	for(std::vector<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+	{
+		if(it->eventType == Event::RECORD_START || it->eventType == Event::RECORD_STOP)
+		{
+			recordEvents.push_back(*it);
+		}
+	}
 }
 
-void addEvent(std::list<Event> &events, double mjd, Event::EventType eventType, const std::string &name, const std::string &scan)
+void EventTimeline::sort()
 {
-	events.push_back(Event(mjd, eventType, name, scan));
+	std::stable_sort(events.begin(), events.end(), EventTimelineLess(this));
+	updateRecordEvents();
 }
 
-double getAntennaStartMJD(const std::list<Event> &events, const std::string &name)
+void EventTimeline::merge(size_t nSorted)
+{
+	if(nSorted > events.size())
+	{
+		std::cerr << "Developer error: EventTimeline::merge: nSorted = " << nSorted << " > " << events.size() << std::endl;
+
+		exit(EXIT_FAILURE);
+	}
+
+	std::stable_sort(events.begin() + nSorted, events.end(), EventTimelineLess(this));
+	std::inplace_merge(events.begin(), events.begin() + nSorted, events.end(), EventTimelineLess(this));
+	updateRecordEvents();
+}
+
+// Sets [first, last) to span all events with start <= mjd <= stop.  A few events just outside this range may be included.
+void EventTimeline::getRange(const_iterator &first, const_iterator &last, double start, double stop) const
+{
+	first = std::lower_bound(events.begin(), events.end(), quantise(VexTime(start - RangePadding)), eventBeforeTime);
+	last = std::upper_bound(first, events.end(), quantise(VexTime(stop + RangePadding)), timeBeforeEvent);
+}
+
+double EventTimeline::getAntennaStartMJD(const std::string &name) const
 {
 	if(events.empty())
 	{
@@ -90,14 +206,15 @@ double getAntennaStartMJD(const std::list<Event> &events, const std::string &nam
 	}
 
 	double earliest = 1e9;
+	int id = getId(name);
 
-	for(std::list<Event>::const_iterator e = events.begin(); e != events.end(); ++e)
+	for(std::vector<Event>::const_iterator e = events.begin(); e != events.end(); ++e)
 	{
 		if(e->mjd < earliest)
 		{
 			earliest = e->mjd;
 		}
-		if(e->eventType == Event::ANTENNA_START && e->name == name)
+		if(e->eventType == Event::ANTENNA_START && static_cast<int>(e->nameId) == id)
 		{
 			return e->mjd;
 		}
@@ -107,7 +224,7 @@ double getAntennaStartMJD(const std::list<Event> &events, const std::string &nam
 	return earliest - 1.0;
 }
 
-double getAntennaStopMJD(const std::list<Event> &events, const std::string &name)
+double EventTimeline::getAntennaStopMJD(const std::string &name) const
 {
 	if(events.empty())
 	{
@@ -115,10 +232,11 @@ double getAntennaStopMJD(const std::list<Event> &events, const std::string &name
 	}
 
 	double latest = -1e9;
+	int id = getId(name);
 
-	for(std::list<Event>::const_iterator e = events.begin(); e != events.end(); ++e)
+	for(std::vector<Event>::const_iterator e = events.begin(); e != events.end(); ++e)
 	{
-		if(e->eventType == Event::ANTENNA_STOP && e->name == name)
+		if(e->eventType == Event::ANTENNA_STOP && static_cast<int>(e->nameId) == id)
 		{
 			return e->mjd;
 		}
@@ -128,12 +246,12 @@ double getAntennaStopMJD(const std::list<Event> &events, const std::string &name
 	return latest + 1.0;
 }
 
-void getEventListTimeRange(const std::list<Event> &events, Interval &eventTimeRange)
+void EventTimeline::getTimeRange(Interval &eventTimeRange) const
 {
 	eventTimeRange.mjdStart = 1.0e7;
 	eventTimeRange.mjdStop = 0.0;
 
-	for(std::list<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+	for(std::vector<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
 	{
 		if(it->mjd < eventTimeRange.mjdStart && it->eventType != Event::CLOCK_BREAK)
 		{
@@ -146,23 +264,23 @@ void getEventListTimeRange(const std::list<Event> &events, Interval &eventTimeRa
 	}
 }
 
-void printEventList(const std::list<Event> &events)
-{
-	std::cout << "Event list:" << std::endl;
-	for(std::list<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
-	{
-		std::cout << "  " << *it << std::endl;
-	}
-}
-
-std::ostream& operator << (std::ostream &os, const Event &x)
+void EventTimeline::print(std::ostream &os, const Event &e) const
 {
 	int d, s;
 
-	d = static_cast<int>(x.mjd);
-	s = static_cast<int>((x.mjd - d)*86400.0 + 0.5);
+	d = static_cast<int>(e.mjd);
+	s = static_cast<int>((e.mjd - d)*86400.0 + 0.5);
 
-	os << "mjd=" << d << " sec=" << s << " : " << Event::eventName[x.eventType] << " " << x.name;
+	os << "mjd=" << d << " sec=" << s << " : " << Event::eventName[e.eventType] << " " << names[e.nameId];
+}
 
-	return os;
+void EventTimeline::print() const
+{
+	std::cout << "Event list:" << std::endl;
+	for(std::vector<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+	{
+		std::cout << "  ";
+		print(std::cout, *it);
+		std::cout << std::endl;
+	}
 }
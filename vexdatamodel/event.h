@@ -32,7 +32,7 @@
 
 #include <iostream>
 #include <vector>
-#include <list>
+#include <map>
 #include <string>
 #include "interval.h"
 
@@ -60,31 +60,65 @@ public:
 	};
 
 	static const char eventName[][20];
+	static const int64_t TimeQuantum;	// [ns] events closer than this are considered simultaneous; divides a day
 
-	double mjd;
+	VexTime mjd;
 	enum EventType eventType;
-	std::string name;
-	std::string scan;
+	unsigned int nameId;	// index into the owning EventTimeline's string table
+	unsigned int scanId;	// ditto; EventTimeline::NoName if not associated with a scan
 
-	Event() : mjd(0.0), eventType(NO_EVENT), name("") {}
-	Event(double m, enum EventType e, const std::string &a) : mjd(m), eventType(e), name(a), scan("") {}
-	Event(double m, enum EventType e, const std::string &a, const std::string &b) : mjd(m), eventType(e), name(a), scan(b) {}
+	Event() : mjd(0.0), eventType(NO_EVENT), nameId(0), scanId(0) {}
+	Event(const VexTime &m, enum EventType e, unsigned int a, unsigned int b) : mjd(m), eventType(e), nameId(a), scanId(b) {}
+
+	int64_t quantisedTime() const;
 };
 
-void addEvent(std::list<Event> &events, double mjd, Event::EventType eventType, const std::string &name);
+// The time ordered list of events of an experiment.  Events are kept in contiguous storage and
+// refer to antenna, scan and job names by id.  Ordering is strict: by time quantised to
+// Event::TimeQuantum, then event type, then name, then scan name, then order of insertion.
+class EventTimeline
+{
+public:
+	static const unsigned int NoName = 0;	// id of the empty string
+	static const double RangePadding;	// [days] added to each side of requested ranges
 
-void addEvent(std::list<Event> &events, double mjd, Event::EventType eventType, const std::string &name, const std::string &scan);
+	typedef std::vector<Event>::const_iterator const_iterator;
 
-double getAntennaStartMJD(const std::list<Event> &events, const std::string &name);
+	EventTimeline();
+	void clear();
+	void add(const VexTime &mjd, Event::EventType eventType, const std::string &name);
+	void add(const VexTime &mjd, Event::EventType eventType, const std::string &name, const std::string &scan);
+	void sort();
+	void merge(size_t nSorted);	// sorts events added after the first nSorted and merges them in; earlier events come first on ties
+	bool less(const Event &a, const Event &b) const;
 
-double getAntennaStopMJD(const std::list<Event> &events, const std::string &name);
+	size_t size() const { return events.size(); }
+	bool empty() const { return events.empty(); }
+	const_iterator begin() const { return events.begin(); }
+	const_iterator end() const { return events.end(); }
+	void getRange(const_iterator &first, const_iterator &last, double start, double stop) const;
+	const std::vector<Event> &getRecordEvents() const { return recordEvents; }
 
-void getEventListTimeRange(const std::list<Event> &events, Interval &eventTimeRange);
+	unsigned int intern(const std::string &name);
+	int getId(const std::string &name) const;	// returns < 0 if name is not known
+	const std::string &getName(unsigned int id) const { return names[id]; }
+	const std::string &getName(const Event &e) const { return names[e.nameId]; }
+	const std::string &getScan(const Event &e) const { return names[e.scanId]; }
+	size_t nName() const { return names.size(); }
 
-void printEventList(const std::list<Event> &events);
+	double getAntennaStartMJD(const std::string &name) const;
+	double getAntennaStopMJD(const std::string &name) const;
+	void getTimeRange(Interval &eventTimeRange) const;
+	void print(std::ostream &os, const Event &e) const;
+	void print() const;
 
-bool operator < (const Event &a, const Event &b);
+private:
+	std::vector<Event> events;
+	std::vector<Event> recordEvents;	// just the RECORD_START and RECORD_STOP events, in order
+	std::vector<std::string> names;
+	std::map<std::string,unsigned int> nameIds;
 
-std::ostream& operator << (std::ostream &os, const Event &x);
+	void updateRecordEvents();
+};
 
 #endif
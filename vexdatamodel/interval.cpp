@@ -36,6 +36,12 @@ double Interval::overlap(const Interval &v) const
 	return std::min(mjdStop, v.mjdStop) - std::max(mjdStart, v.mjdStart);
 }
 
+// exact; negative if no overlap
+int64_t Interval::overlap_nanoseconds(const Interval &v) const
+{
+	return std::min(mjdStop, v.mjdStop).nanosecondsSince(std::max(mjdStart, v.mjdStart));
+}
+
 void Interval::logicalAnd(double start, double stop)
 {
 	if(mjdStart < start)
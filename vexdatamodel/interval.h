@@ -31,19 +31,22 @@
 #define __INTERVAL_H__
 
 #include <iostream>
+#include "vex_time.h"
 
 class Interval
 {
 public:
-	double mjdStart;
-	double mjdStop;
+	VexTime mjdStart;
+	VexTime mjdStop;
 
 	Interval(double start=0.0, double end=0.0) : mjdStart(start), mjdStop(end) {}
 	Interval(const Interval &vi) : mjdStart(vi.mjdStart), mjdStop(vi.mjdStop) {}
 	double duration() const { return mjdStop-mjdStart; }
 	double duration_seconds() const { return 86400.0*(mjdStop-mjdStart); }
+	int64_t duration_nanoseconds() const { return mjdStop.nanosecondsSince(mjdStart); }
 	double overlap(const Interval &v) const;
 	double overlap_seconds(const Interval &v) const { return 86400.0*overlap(v); }
+	int64_t overlap_nanoseconds(const Interval &v) const;
 	double center() const { return 0.5*(mjdStart+mjdStop); }
 	void shift(double deltaT) { mjdStart += deltaT; mjdStop += deltaT; }
 	void setTimeRange(double start, double stop) { mjdStart = start; mjdStop = stop; }
@@ -132,6 +132,18 @@ void VexAntenna::removeBasebandData(int streamId)
 {
 	removeBasebandDataByStreamId(vsns, streamId);
 	removeBasebandDataByStreamId(files, streamId);
+	invalidateBasebandIndex();
+}
+
+// Not thread safe when a rebuild is needed; see VexData::buildNameIndexes()
+void VexAntenna::buildBasebandIndex() const
+{
+	if(!basebandIndexValid)
+	{
+		vsnIndex.build(vsns);
+		fileIndex.build(files);
+		basebandIndexValid = true;
+	}
 }
 
 VexAntenna::NasmythType VexAntenna::getNasmyth(const std::string &bandLink) const
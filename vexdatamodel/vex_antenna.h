@@ -57,13 +57,17 @@ public:
 	};
 	static const char nasmythName[][8];
 
-	VexAntenna() : x(0.0), y(0.0), z(0.0), dx(0.0), dy(0.0), dz(0.0), posEpoch(0.0), axisOffset(0.0), tcalFrequency(0), polConvert(false) {}
+	VexAntenna() : x(0.0), y(0.0), z(0.0), dx(0.0), dy(0.0), dz(0.0), posEpoch(0.0), axisOffset(0.0), tcalFrequency(0), polConvert(false), basebandIndexValid(false) {}
 
 	double getVexClocks(double mjd, double *coeffs) const;		// This version of the function is deprecated
 	double getVexClocks(double mjd, double *coeffs, int *clockorder, int maxorder) const;
 	bool hasClockModel() const { return (!clocks.empty()); }
 	bool hasData(const Interval &timerange) const;
 	void removeBasebandData(int streamId);
+	void invalidateBasebandIndex() { basebandIndexValid = false; }	// call after changing the time ranges in vsns or files
+	void buildBasebandIndex() const;
+	const VexBasebandIndex &getVSNIndex() const { buildBasebandIndex(); return vsnIndex; }
+	const VexBasebandIndex &getFileIndex() const { buildBasebandIndex(); return fileIndex; }
 	bool hasVSNs() const { return !vsns.empty(); }
 	bool isVLBA() const { return ::isVLBA(defName); }
 	void setAntennaPolConvert(bool doConvert) { polConvert = doConvert; }
@@ -94,6 +98,10 @@ public:
 
 	// Some antenna/site things that are not based on vex parameters (but could be carried as an extension)
 
+private:
+	mutable VexBasebandIndex vsnIndex;	// time index into vsns
+	mutable VexBasebandIndex fileIndex;	// time index into files
+	mutable bool basebandIndexValid;
 };
 
 VexAntenna::NasmythType stringToNasmyth(const std::string &platform);
@@ -28,6 +28,7 @@
  *==========================================================================*/
 
 #include <set>
+#include <algorithm>
 #include <cctype>
 #include "vex_basebanddata.h"
 
@@ -138,6 +139,94 @@ bool VexBasebandData::isMark6() const
 	return true;
 }
 
+class VexBasebandStartLess
+{
+public:
+	VexBasebandStartLess(const std::vector<VexBasebandData> &d) : data(d) {}
+	bool operator()(unsigned int a, unsigned int b) const { return data[a].mjdStart < data[b].mjdStart; }
+
+private:
+	const std::vector<VexBasebandData> &data;
+};
+
+static bool startLess(const Interval &a, const VexTime &mjd)
+{
+	return a.mjdStart < mjd;
+}
+
+static bool startsAfter(const VexTime &mjd, const Interval &a)
+{
+	return mjd < a.mjdStart;
+}
+
+void VexBasebandIndex::build(const std::vector<VexBasebandData> &data)
+{
+	order.resize(data.size());
+	for(unsigned int i = 0; i < data.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), VexBasebandStartLess(data));
+
+	ranges.resize(order.size());
+	maxStop.resize(order.size());
+	for(unsigned int i = 0; i < order.size(); ++i)
+	{
+		ranges[i] = data[order[i]];
+		maxStop[i] = (i == 0 || ranges[i].mjdStop > maxStop[i-1]) ? ranges[i].mjdStop : maxStop[i-1];
+	}
+}
+
+// number of leading entries (in start order) that begin before mjdStop
+unsigned int VexBasebandIndex::nCandidate(const VexTime &mjdStop) const
+{
+	return std::lower_bound(ranges.begin(), ranges.end(), mjdStop, startLess) - ranges.begin();
+}
+
+// true if any entry has positive overlap with timeRange
+bool VexBasebandIndex::overlaps(const Interval &timeRange) const
+{
+	for(unsigned int i = nCandidate(timeRange.mjdStop); i > 0 && maxStop[i-1] > timeRange.mjdStart; --i)
+	{
+		if(ranges[i-1].overlap_nanoseconds(timeRange) > 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// ids of entries having positive overlap with timeRange, in increasing order
+void VexBasebandIndex::getOverlapping(std::vector<unsigned int> &ids, const Interval &timeRange) const
+{
+	ids.clear();
+	for(unsigned int i = nCandidate(timeRange.mjdStop); i > 0 && maxStop[i-1] > timeRange.mjdStart; --i)
+	{
+		if(ranges[i-1].overlap_nanoseconds(timeRange) > 0)
+		{
+			ids.push_back(order[i-1]);
+		}
+	}
+	std::sort(ids.begin(), ids.end());
+}
+
+// ids of entries with mjdStart <= mjd <= mjdStop, in increasing order
+void VexBasebandIndex::getContaining(std::vector<unsigned int> &ids, const VexTime &mjd) const
+{
+	unsigned int n = std::upper_bound(ranges.begin(), ranges.end(), mjd, startsAfter) - ranges.begin();
+
+	ids.clear();
+	for(unsigned int i = n; i > 0 && maxStop[i-1] >= mjd; --i)
+	{
+		if(ranges[i-1].contains(mjd))
+		{
+			ids.push_back(order[i-1]);
+		}
+	}
+	std::sort(ids.begin(), ids.end());
+}
+
 std::ostream& operator << (std::ostream &os, const VexBasebandData &x)
 {
 	os << "Baseband(" << x.filename << ", recorderId=" << x.recorderId << ", streamId=" << x.streamId << ", " << (const Interval&)x << ")";
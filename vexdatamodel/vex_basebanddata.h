@@ -49,6 +49,25 @@ class VexBasebandData : public Interval
 	bool isMark6() const;
 };
 
+// Time index over a list of VexBasebandData, allowing overlap queries in O(log n + k)
+// rather than a scan of the whole list.  Only the time ranges are copied, so the index
+// stays valid while other fields of the entries change.
+class VexBasebandIndex
+{
+public:
+	void build(const std::vector<VexBasebandData> &data);
+	bool overlaps(const Interval &timeRange) const;
+	void getOverlapping(std::vector<unsigned int> &ids, const Interval &timeRange) const;
+	void getContaining(std::vector<unsigned int> &ids, const VexTime &mjd) const;
+
+private:
+	unsigned int nCandidate(const VexTime &mjdStop) const;
+
+	std::vector<unsigned int> order;	// entry ids, sorted by start time
+	std::vector<Interval> ranges;		// time ranges, in the above order
+	std::vector<VexTime> maxStop;		// maxStop[i] is the latest stop among ranges[0..i]
+};
+
 // returns number of removed entries; negative streamId implies remove from all streams
 int removeBasebandDataByStreamId(std::vector<VexBasebandData> &data, int streamId);
 
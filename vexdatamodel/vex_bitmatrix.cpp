@@ -0,0 +1,78 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include "vex_bitmatrix.h"
+
+void VexBitMatrix::resize(unsigned int rows, unsigned int columns)
+{
+	nRows = rows;
+	nColumns = columns;
+	nRowWords = (columns + WordBits - 1)/WordBits;
+	bits.assign(static_cast<std::vector<Word>::size_type>(nRows)*nRowWords, 0);
+}
+
+unsigned int VexBitMatrix::count(unsigned int row) const
+{
+	unsigned int n = 0;
+
+	for(unsigned int w = 0; w < nRowWords; ++w)
+	{
+		n += popcount(bits[row*nRowWords + w]);
+	}
+
+	return n;
+}
+
+unsigned int VexBitMatrix::countAnd(unsigned int row, const VexBitMatrix &other) const
+{
+	unsigned int n = 0;
+
+	for(unsigned int w = 0; w < nRowWords && w < other.nRowWords; ++w)
+	{
+		n += popcount(bits[row*nRowWords + w] & other.bits[row*other.nRowWords + w]);
+	}
+
+	return n;
+}
+
+unsigned int popcount(VexBitMatrix::Word w)
+{
+#ifdef __GNUC__
+	return __builtin_popcountll(w);
+#else
+	unsigned int n = 0;
+
+	for(; w; w &= w - 1)
+	{
+		++n;
+	}
+
+	return n;
+#endif
+}
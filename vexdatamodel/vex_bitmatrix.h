@@ -0,0 +1,63 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#ifndef __VEX_BITMATRIX_H__
+#define __VEX_BITMATRIX_H__
+
+#include <vector>
+#include <stdint.h>
+
+// A matrix of bits packed into 64-bit words, one run of words per row.  Used by
+// VexData for scan x antenna relations, where rows can be combined a word at a time.
+class VexBitMatrix
+{
+public:
+	typedef uint64_t Word;
+	static const unsigned int WordBits = 64;
+
+	VexBitMatrix() : nRows(0), nColumns(0), nRowWords(0) {}
+	void resize(unsigned int rows, unsigned int columns);	// all bits are cleared
+	unsigned int nRow() const { return nRows; }
+	unsigned int nColumn() const { return nColumns; }
+	unsigned int nWord() const { return nRowWords; }	// words per row
+	void set(unsigned int row, unsigned int column) { bits[row*nRowWords + column/WordBits] |= static_cast<Word>(1) << (column % WordBits); }
+	bool test(unsigned int row, unsigned int column) const { return (bits[row*nRowWords + column/WordBits] >> (column % WordBits)) & 1; }
+	unsigned int count(unsigned int row) const;
+	unsigned int countAnd(unsigned int row, const VexBitMatrix &other) const;	// bits set in this row of both matrices
+
+private:
+	unsigned int nRows;
+	unsigned int nColumns;
+	unsigned int nRowWords;
+	std::vector<Word> bits;
+};
+
+unsigned int popcount(VexBitMatrix::Word w);
+
+#endif
@@ -39,6 +39,144 @@
 #include "vex_utility.h"
 
 
+// Fills index with name -> position for each element of items.  The first
+// element with a given name wins, matching the old linear search behavior.
+// Elements without a name are set aside; lookupNameIndex() checks them each
+// time, as an element is usually named only after its new*() call returns.
+template <class T> static void buildNameIndex(VexNameIndex &index, const std::vector<T> &items, std::string T::*key)
+{
+	index.positions.clear();
+	index.unnamed.clear();
+	for(unsigned int i = 0; i < items.size(); ++i)
+	{
+		const std::string &name = items[i].*key;
+
+		if(name.empty())
+		{
+			index.unnamed.push_back(i);
+		}
+		else
+		{
+			index.positions.insert(std::pair<std::string,unsigned int>(name, i));
+		}
+	}
+}
+
+template <class T> static int lookupNameIndex(const VexNameIndex &index, const std::vector<T> &items, std::string T::*key, const std::string &name)
+{
+	std::map<std::string,unsigned int>::const_iterator it = index.positions.find(name);
+	int pos = (it == index.positions.end()) ? -1 : static_cast<int>(it->second);
+
+	// an element named since the index was built is found here, unless an earlier one has the same name
+	for(std::vector<unsigned int>::const_iterator u = index.unnamed.begin(); u != index.unnamed.end(); ++u)
+	{
+		if(pos >= 0 && *u > static_cast<unsigned int>(pos))
+		{
+			break;
+		}
+		if(*u < items.size() && items[*u].*key == name)
+		{
+			return *u;
+		}
+	}
+
+	return pos;
+}
+
+void VexData::updateSourceIndex() const
+{
+	__sync_fetch_and_add(&nNameLookup, 1);	// atomic: lookups may come from several threads
+	if(!sourceIndexValid)
+	{
+		buildNameIndex(sourceDefNameIndex, sources, &VexSource::defName);
+		sourceIndexValid = true;
+		__sync_fetch_and_add(&nIndexBuild, 1);
+	}
+}
+
+void VexData::updateScanIndex() const
+{
+	__sync_fetch_and_add(&nNameLookup, 1);
+	if(!scanIndexValid)
+	{
+		buildNameIndex(scanDefNameIndex, scans, &VexScan::defName);
+		scanIndexValid = true;
+		__sync_fetch_and_add(&nIndexBuild, 1);
+	}
+}
+
+void VexData::updateModeIndex() const
+{
+	__sync_fetch_and_add(&nNameLookup, 1);
+	if(!modeIndexValid)
+	{
+		buildNameIndex(modeDefNameIndex, modes, &VexMode::defName);
+		modeIndexValid = true;
+		__sync_fetch_and_add(&nIndexBuild, 1);
+	}
+}
+
+void VexData::updateAntennaIndex() const
+{
+	__sync_fetch_and_add(&nNameLookup, 1);
+	if(!antennaIndexValid)
+	{
+		buildNameIndex(antennaNameIndex, antennas, &VexAntenna::name);
+		buildNameIndex(antennaDefNameIndex, antennas, &VexAntenna::defName);
+		antennaIndexValid = true;
+		__sync_fetch_and_add(&nIndexBuild, 1);
+	}
+}
+
+// One row per scan of the packed participation, record enable and baseband data bits of each antenna
+void VexData::updateScanMatrices() const
+{
+	if(scanMatrixValid)
+	{
+		return;
+	}
+
+	scanStations.resize(scans.size(), stationNames.size());
+	scanRecordEnable.resize(scans.size(), stationNames.size());
+	scanHasData.resize(scans.size(), stationNames.size());
+	for(unsigned int s = 0; s < scans.size(); ++s)
+	{
+		const VexScan &scan = scans[s];
+		bool knownMode = (getModeByDefName(scan.modeDefName) != 0);
+
+		for(std::vector<VexScanStation>::const_iterator it = scan.stations.begin(); it != scan.stations.end(); ++it)
+		{
+			const std::string &antName = stationNames.getName(it->antId);
+
+			scanStations.set(s, it->antId);
+			if(it->recordEnable)
+			{
+				scanRecordEnable.set(s, it->antId);
+			}
+			// hasData() treats an unknown antenna or mode as fatal; only query it where it is defined
+			if(knownMode && getAntenna(antName) && hasData(antName, scan))
+			{
+				scanHasData.set(s, it->antId);
+			}
+		}
+	}
+	scanMatrixValid = true;
+	__sync_fetch_and_add(&nIndexBuild, 1);
+}
+
+void VexData::buildNameIndexes() const
+{
+	updateSourceIndex();
+	updateScanIndex();
+	updateModeIndex();
+	updateAntennaIndex();
+	for(std::vector<VexAntenna>::const_iterator it = antennas.begin(); it != antennas.end(); ++it)
+	{
+		it->buildBasebandIndex();
+	}
+	updateScanMatrices();
+}
+
 int VexData::sanityCheck()
 {
 	int nWarn = 0;
@@ -55,6 +193,7 @@ int VexData::sanityCheck()
 VexSource *VexData::newSource()
 {
 	sources.push_back(VexSource());
+	sourceIndexValid = false;
 
 	return &sources.back();
 }
@@ -62,6 +201,7 @@ VexSource *VexData::newSource()
 VexSource *VexData::newSource(const std::string &name, double ra, double dec)
 {
 	sources.push_back(VexSource(name, ra, dec));
+	sourceIndexValid = false;
 
 	return &sources.back();
 }
@@ -78,28 +218,21 @@ const VexSource *VexData::getSource(unsigned int num) const
 
 int VexData::getSourceIdByDefName(const std::string &defName) const
 {
-	for(std::vector<VexSource>::const_iterator it = sources.begin(); it != sources.end(); ++it)
-	{
-		if(it->defName == defName)
-		{
-			return it - sources.begin();
-		}
-	}
+	updateSourceIndex();
 
-	return -1;
+	return lookupNameIndex(sourceDefNameIndex, sources, &VexSource::defName, defName);
 }
 
 const VexSource *VexData::getSourceByDefName(const std::string &defName) const
 {
-	for(std::vector<VexSource>::const_iterator it = sources.begin(); it != sources.end(); ++it)
+	int s = getSourceIdByDefName(defName);
+
+	if(s < 0)
 	{
-		if(it->defName == defName)
-		{
-			return &(*it);
-		}
+		return 0;
 	}
 
-	return 0;
+	return &sources[s];
 }
 
 const VexSource *VexData::getSourceBySourceName(const std::string &name) const
@@ -168,6 +301,9 @@ void VexData::setSourceCoordinates(const std::string &name, double ra, double de
 VexScan *VexData::newScan()
 {
 	scans.push_back(VexScan());
+	scans.back().stationNames = &stationNames;
+	scanIndexValid = false;
+	scanMatrixValid = false;
 
 	return &scans.back();
 }
@@ -183,17 +319,25 @@ const VexScan *VexData::getScan(unsigned int num) const
 	return &scans[num];
 }
 
+int VexData::getScanIdByDefName(const std::string &defName) const
+{
+	updateScanIndex();
+
+	return lookupNameIndex(scanDefNameIndex, scans, &VexScan::defName, defName);
+}
+
 const VexScan *VexData::getScanByDefName(const std::string &defName) const
 {
-	for(std::vector<VexScan>::const_iterator it = scans.begin(); it != scans.end(); ++it)
+	int s;
+
+	updateScanIndex();
+	s = lookupNameIndex(scanDefNameIndex, scans, &VexScan::defName, defName);
+	if(s < 0)
 	{
-		if(it->defName == defName)
-		{
-			return &(*it);
-		}
+		return 0;
 	}
 
-	return 0;
+	return &scans[s];
 }
 
 const VexScan *VexData::getScanByAntennaTime(const std::string &antName, double mjd) const
@@ -289,46 +433,47 @@ static Interval adjustTimeRange(std::map<std::string, double> &antStart, std::ma
 // the final time ranges (both of scans and antennas within) are truncated to the time window when the subarray size condition is met.
 void VexData::reduceScans(int minSubarraySize, const Interval &timerange)
 {
-	std::list<std::string> antsToRemove;
 	std::map<std::string, double> antStart, antStop;
 
+	scanMatrixValid = false;
+
 // FIXME: maybe print some statistics such as number of scans dropped due to minsubarraysize and timerange
 
 	for(std::vector<VexScan>::iterator it = scans.begin(); it != scans.end(); )
 	{
 		antStart.clear();
 		antStop.clear();
-		antsToRemove.clear();
 
-		for(std::map<std::string,Interval>::iterator sit = it->stations.begin(); sit != it->stations.end(); ++sit)
+		for(std::vector<VexScanStation>::iterator sit = it->stations.begin(); sit != it->stations.end(); )
 		{
-			if(sit->second.overlap(timerange) <= 0.0)
+			if(sit->overlap(timerange) <= 0.0)
 			{
-				antsToRemove.push_back(sit->first);
+				sit = it->stations.erase(sit);
 			}
 			else
 			{
-				sit->second.logicalAnd(timerange);
-				antStart[sit->first] = sit->second.mjdStart;
-				antStop[sit->first]  = sit->second.mjdStop;
+				const std::string &antName = stationNames.getName(sit->antId);
+
+				sit->logicalAnd(timerange);
+				antStart[antName] = sit->mjdStart;
+				antStop[antName]  = sit->mjdStop;
+				++sit;
 			}
 		}
-		for(std::list<std::string>::const_iterator ait = antsToRemove.begin(); ait != antsToRemove.end(); ++ait)
-		{
-			it->stations.erase(*ait);
-		}
 
 		Interval antennaTimeRange = adjustTimeRange(antStart, antStop, minSubarraySize);
 
-		if(!antennaTimeRange.isCausal() || it->overlap(antennaTimeRange) <= 0.05/86400.0)
+		if(!antennaTimeRange.isCausal() || it->overlap_nanoseconds(antennaTimeRange) <= VexTime::NanosecondsPerSecond/20)
 		{
 			it = scans.erase(it);
+			scanIndexValid = false;
+			scanMatrixValid = false;
 			continue;
 		}
 
-		for(std::map<std::string,Interval>::iterator sit = it->stations.begin(); sit != it->stations.end(); ++sit)
+		for(std::vector<VexScanStation>::iterator sit = it->stations.begin(); sit != it->stations.end(); ++sit)
 		{
-			sit->second.logicalAnd(antennaTimeRange);
+			sit->logicalAnd(antennaTimeRange);
 		}
 
 		it->logicalAnd(antennaTimeRange);
@@ -358,9 +503,17 @@ unsigned int VexData::nAntennasWithRecordedData(const VexScan &scan) const
 {
 	unsigned int nAnt = 0;
 
-	for(std::map<std::string,Interval>::const_iterator it = scan.stations.begin(); it != scan.stations.end(); ++it)
+	if(!scans.empty() && &scan >= &scans.front() && &scan <= &scans.back())
 	{
-		if(hasData(it->first, scan) && scan.getRecordEnable(it->first))
+		updateScanMatrices();
+
+		return scanRecordEnable.countAnd(&scan - &scans.front(), scanHasData);
+	}
+
+	// a scan not owned by this VexData
+	for(std::vector<VexScanStation>::const_iterator it = scan.stations.begin(); it != scan.stations.end(); ++it)
+	{
+		if(it->recordEnable && hasData(stationNames.getName(it->antId), scan))
 		{
 			++nAnt;
 		}
@@ -378,6 +531,8 @@ bool VexData::removeScan(const std::string name)
 		if(it->defName == name)
 		{
 			it = scans.erase(it);
+			scanIndexValid = false;
+			scanMatrixValid = false;
 			removed = true;
 		}
 		else
@@ -412,6 +567,8 @@ void VexData::addPhaseCenter(unsigned int num, const std::string &name)
 VexAntenna *VexData::newAntenna()
 {
 	antennas.push_back(VexAntenna());
+	antennaIndexValid = false;
+	scanMatrixValid = false;
 
 	return &antennas.back();
 }
@@ -428,21 +585,22 @@ const VexAntenna *VexData::getAntenna(unsigned int num) const
 
 const VexAntenna *VexData::getAntenna(const std::string &name) const
 {
-	for(std::vector<VexAntenna>::const_iterator it = antennas.begin(); it != antennas.end(); ++it)
+	int a = getAntennaIdByName(name);
+
+	if(a < 0)
 	{
-		if(it->name == name)
-		{
-			return &(*it);
-		}
+		return 0;
 	}
 
-	return 0;
+	return &antennas[a];
 }
 
 
 VexMode *VexData::newMode()
 {
 	modes.push_back(VexMode());
+	modeIndexValid = false;
+	scanMatrixValid = false;
 
 	return &modes.back();
 }
@@ -459,15 +617,14 @@ const VexMode *VexData::getMode(unsigned int num) const
 
 const VexMode *VexData::getModeByDefName(const std::string &defName) const
 {
-	for(std::vector<VexMode>::const_iterator it = modes.begin(); it != modes.end(); ++it)
+	int m = getModeIdByDefName(defName);
+
+	if(m < 0)
 	{
-		if(it->defName == defName)
-		{
-			return &(*it);
-		}
+		return 0;
 	}
 
-	return 0;
+	return &modes[m];
 }
 
 void VexData::generateRecordChans()
@@ -497,28 +654,16 @@ unsigned int VexData::nRecordChan(const VexMode &mode, const std::string &antNam
 
 int VexData::getAntennaIdByName(const std::string &antName) const
 {
-	for(std::vector<VexAntenna>::const_iterator it = antennas.begin(); it != antennas.end(); ++it)
-	{
-		if(it->name == antName)
-		{
-			return it - antennas.begin();
-		}
-	}
+	updateAntennaIndex();
 
-	return -1;
+	return lookupNameIndex(antennaNameIndex, antennas, &VexAntenna::name, antName);
 }
 
 int VexData::getAntennaIdByDefName(const std::string &antName) const
 {
-	for(std::vector<VexAntenna>::const_iterator it = antennas.begin(); it != antennas.end(); ++it)
-	{
-		if(it->defName == antName)
-		{
-			return it - antennas.begin();
-		}
-	}
+	updateAntennaIndex();
 
-	return -1;
+	return lookupNameIndex(antennaDefNameIndex, antennas, &VexAntenna::defName, antName);
 }
 
 // returns < 0 if number of channels varies with mode
@@ -559,6 +704,8 @@ bool VexData::removeAntenna(const std::string name)
 		if(it->name == name)
 		{
 			it = antennas.erase(it);
+			antennaIndexValid = false;
+			scanMatrixValid = false;
 			rv = true;
 		}
 		else
@@ -570,12 +717,13 @@ bool VexData::removeAntenna(const std::string name)
 	// remove antenna from scans
 	for(std::vector<VexScan>::iterator it = scans.begin(); it != scans.end(); )
 	{
-		it->stations.erase(name);
-		it->recordEnable.erase(name);
+		it->removeStation(name);
 
 		if(it->stations.empty())
 		{
 			it = scans.erase(it);
+			scanIndexValid = false;
+			scanMatrixValid = false;
 		}
 		else
 		{
@@ -591,6 +739,7 @@ bool VexData::removeAntenna(const std::string name)
 		if(it->setups.empty())
 		{
 			it = modes.erase(it);
+			modeIndexValid = false;
 		}
 		else
 		{
@@ -604,15 +753,9 @@ bool VexData::removeAntenna(const std::string name)
 
 int VexData::getModeIdByDefName(const std::string &defName) const
 {
-	for(std::vector<VexMode>::const_iterator it = modes.begin(); it != modes.end(); ++it)
-	{
-		if(it->defName == defName)
-		{
-			return it - modes.begin();
-		}
-	}
+	updateModeIndex();
 
-	return -1;
+	return lookupNameIndex(modeDefNameIndex, modes, &VexMode::defName, defName);
 }
 
 
@@ -704,6 +847,9 @@ std::vector<VexBasebandData> *VexData::getVSNs(const std::string &antName)
 	{
 		if(it->name == antName)
 		{
+			it->invalidateBasebandIndex();	// caller may change the list
+			scanMatrixValid = false;
+
 			return &(it->vsns);
 		}
 	}
@@ -718,6 +864,8 @@ void VexData::addVSN(const std::string &antName, int drive, const std::string &v
 		if(it->name == antName)
 		{
 			it->vsns.push_back(VexBasebandData(vsn, drive, -1, timeRange));
+			it->invalidateBasebandIndex();
+			scanMatrixValid = false;
 		}
 	}
 }
@@ -728,6 +876,8 @@ void VexData::addFile(const std::string &antName, int drive, const std::string &
 		if(it->name == antName)
 		{
 			it->files.push_back(VexBasebandData(filename, drive, -1, timeRange));
+			it->invalidateBasebandIndex();
+			scanMatrixValid = false;
 		}
 	}
 }
@@ -741,6 +891,7 @@ void VexData::removeBasebandData(const std::string &antName, int datastreamId)
 		if(it->name == antName)
 		{
 			it->removeBasebandData(datastreamId);
+			scanMatrixValid = false;
 		}
 	}
 }
@@ -759,7 +910,7 @@ void VexData::setExper(const std::string &name, const std::string &segment, cons
 	exper.setTimeRange(experTimeRange);
 }
 
-void VexData::addLeapSecondEvents(std::list<Event> &events) const
+void VexData::addLeapSecondEvents(EventTimeline &events) const
 {
 	int n = eops.size();
 
@@ -772,7 +923,7 @@ void VexData::addLeapSecondEvents(std::list<Event> &events) const
 	{
 		if(eops[i-1].tai_utc != eops[i].tai_utc)
 		{
-			addEvent(events, eops[i].mjd, Event::LEAP_SECOND, "Leap second");
+			events.add(eops[i].mjd, Event::LEAP_SECOND, "Leap second");
 			std::cout << "Leap second detected at day " << eops[i].mjd << std::endl;
 		}
 	}
@@ -887,39 +1038,41 @@ void VexData::setAntennaPolConvert(const std::string &antName, bool doConvert)
 	}
 }
 
-void VexData::addExperEvents(std::list<Event> &events) const
+void VexData::addExperEvents(EventTimeline &events) const
 {
-	addEvent(events, exper.mjdStart, Event::OBSERVE_START, exper.name); 
-	addEvent(events, exper.mjdStop, Event::OBSERVE_STOP, exper.name); 
+	events.add(exper.mjdStart, Event::OBSERVE_START, exper.name); 
+	events.add(exper.mjdStop, Event::OBSERVE_STOP, exper.name); 
 }
 
-void VexData::addClockEvents(std::list<Event> &events) const
+void VexData::addClockEvents(EventTimeline &events) const
 {
 	for(std::vector<VexAntenna>::const_iterator it = antennas.begin(); it != antennas.end(); ++it)
 	{
 		for(std::vector<VexClock>::const_iterator cit = it->clocks.begin(); cit != it->clocks.end(); ++cit)
 		{
-			addEvent(events, cit->mjdStart, Event::CLOCK_BREAK, it->defName);
+			events.add(cit->mjdStart, Event::CLOCK_BREAK, it->defName);
 		}
 	}
 }
 
-void VexData::addScanEvents(std::list<Event> &events) const
+void VexData::addScanEvents(EventTimeline &events) const
 {
 	for(std::vector<VexScan>::const_iterator it = scans.begin(); it != scans.end(); ++it)
 	{
-		addEvent(events, it->mjdStart, Event::SCAN_START, it->defName, it->defName);
-		addEvent(events, it->mjdStop,  Event::SCAN_STOP,  it->defName, it->defName);
-		for(std::map<std::string,Interval>::const_iterator sit = it->stations.begin(); sit != it->stations.end(); ++sit)
+		events.add(it->mjdStart, Event::SCAN_START, it->defName, it->defName);
+		events.add(it->mjdStop,  Event::SCAN_STOP,  it->defName, it->defName);
+		for(std::vector<VexScanStation>::const_iterator sit = it->stations.begin(); sit != it->stations.end(); ++sit)
 		{
-			addEvent(events, std::max(sit->second.mjdStart, it->mjdStart), Event::ANT_SCAN_START, sit->first, it->defName);
-			addEvent(events, std::min(sit->second.mjdStop,  it->mjdStop),  Event::ANT_SCAN_STOP,  sit->first, it->defName);
+			const std::string &antName = stationNames.getName(sit->antId);
+
+			events.add(std::max(sit->mjdStart, it->mjdStart), Event::ANT_SCAN_START, antName, it->defName);
+			events.add(std::min(sit->mjdStop,  it->mjdStop),  Event::ANT_SCAN_STOP,  antName, it->defName);
 		}
 	}
 
 }
 
-void VexData::addVSNEvents(std::list<Event> &events) const
+void VexData::addVSNEvents(EventTimeline &events) const
 {
 	for(unsigned int antId = 0; antId < antennas.size(); ++antId)
 	{
@@ -932,26 +1085,26 @@ void VexData::addVSNEvents(std::list<Event> &events) const
 				enum DataSource ds = getDataSource(antId, vit->streamId);
 				if(ds == DataSourceModule || ds == DataSourceMark6)
 				{
-					addEvent(events, vit->mjdStart, Event::RECORD_START, A->defName);
-					addEvent(events, vit->mjdStop,  Event::RECORD_STOP,  A->defName);
+					events.add(vit->mjdStart, Event::RECORD_START, A->defName);
+					events.add(vit->mjdStop,  Event::RECORD_STOP,  A->defName);
 				}
 			}
 		}
 	}
 }
 
-void VexData::addBreakEvents(std::list<Event> &events, const std::vector<double> &breaks) const
+void VexData::addBreakEvents(EventTimeline &events, const std::vector<double> &breaks) const
 {
 	for(std::vector<double>::const_iterator t = breaks.begin(); t != breaks.end(); ++t)
 	{
 		if(exper.contains(*t))
 		{
-			addEvent(events, *t, Event::MANUAL_BREAK, "");
+			events.add(*t, Event::MANUAL_BREAK, "");
 		}
 	}
 }
 
-void VexData::generateEvents(std::list<Event> &events) const
+void VexData::generateEvents(EventTimeline &events) const
 {
 	events.clear();
 
@@ -1006,6 +1159,7 @@ void VexData::setFiles(unsigned int antId, unsigned int streamId, const std::vec
 	{
 		antennas[antId].files.push_back(VexBasebandData(it->filename, -1, streamId, *it));
 	}
+	antennas[antId].invalidateBasebandIndex();
 	setDataSource(antId, streamId, DataSourceFile);
 }
 
@@ -1017,6 +1171,7 @@ void VexData::setMark6Files(unsigned int antId, unsigned int streamId, const std
 	{
 		antennas[antId].files.push_back(VexBasebandData(it->filename, -1, streamId, *it));
 	}
+	antennas[antId].invalidateBasebandIndex();
 	setDataSource(antId, streamId, DataSourceMark6);
 }
 
@@ -1025,6 +1180,7 @@ void VexData::setModule(unsigned int antId, unsigned int streamId, const std::st
 {
 	antennas[antId].removeBasebandData(streamId);
 	antennas[antId].vsns.push_back(VexBasebandData(vsn, -1, streamId));
+	antennas[antId].invalidateBasebandIndex();
 	setDataSource(antId, streamId, DataSourceModule);
 }
 
@@ -1105,6 +1261,8 @@ void VexData::cloneStreams(const std::string &modeName, const std::string &antNa
 		{
 			int nrc;
 
+			scanMatrixValid = false;
+
 			if(it->second.streams.size() == 1 && it->second.streams[0].nRecordChan % copies == 0)
 			{
 				nrc = it->second.streams[0].nRecordChan/copies;
@@ -1143,6 +1301,8 @@ void VexData::removeStreamsWithNoDataSource()
 {
 	std::vector<VexMode>::iterator mit;
 
+	scanMatrixValid = false;
+
 	for(mit = modes.begin(); mit != modes.end(); ++mit)
 	{
 		std::map<std::string,VexSetup>::iterator sit;
@@ -1185,6 +1345,7 @@ void VexData::setDataSource(unsigned int antId, unsigned int streamId, enum Data
 		exit(EXIT_FAILURE);
 	}
 
+	scanMatrixValid = false;
 	for(mit = modes.begin(); mit != modes.end(); ++mit)
 	{
 		std::map<std::string,VexSetup>::iterator it = mit->setups.find(antennas[antId].name);
@@ -1507,24 +1668,10 @@ bool VexData::hasData(const std::string &antName, const VexScan &scan) const
 			{
 			case DataSourceFile:
 			case DataSourceMark6:
-				for(std::vector<VexBasebandData>::const_iterator it = A->files.begin(); it != A->files.end(); ++it)
-				{
-					if(it->overlap(scan) > 0.0)
-					{
-						hd = true;
-						break;
-					}
-				}
+				hd = A->getFileIndex().overlaps(scan);
 				break;
 			case DataSourceModule:
-				for(std::vector<VexBasebandData>::const_iterator it = A->vsns.begin(); it != A->vsns.end(); ++it)
-				{
-					if(it->overlap(scan) > 0.0)
-					{
-						hd = true;
-						break;
-					}
-				}
+				hd = A->getVSNIndex().overlaps(scan);
 				break;
 			case DataSourceNetwork:
 			case DataSourceFake:
@@ -40,6 +40,7 @@
 #include "event.h"
 #include "vex_exper.h"
 #include "vex_basebanddata.h"
+#include "vex_bitmatrix.h"
 #include "vex_clock.h"
 #include "vex_stream.h"
 #include "vex_antenna.h"
@@ -54,6 +55,14 @@
 #include "vex_extension.h"
 
 
+// name -> position lookup table for one of the element vectors of VexData
+class VexNameIndex
+{
+public:
+	std::map<std::string,unsigned int> positions;
+	std::vector<unsigned int> unnamed;	// elements without a name when the index was built, in order
+};
+
 class VexData
 {
 private:
@@ -64,15 +73,45 @@ private:
 	std::vector<VexAntenna> antennas;
 	std::vector<VexEOP> eops;
 	std::vector<VexExtension> extensions;	// this is for extensions captured in the $GLOBAL block
+	VexStationNames stationNames;		// antenna names referenced by VexScanStation::antId
 
 	std::string directory;
 
 	double version;			// version of vex file
 
+	// name -> index lookup tables; rebuilt lazily whenever the underlying vector changes
+	mutable VexNameIndex sourceDefNameIndex;
+	mutable VexNameIndex scanDefNameIndex;
+	mutable VexNameIndex modeDefNameIndex;
+	mutable VexNameIndex antennaNameIndex;
+	mutable VexNameIndex antennaDefNameIndex;
+	mutable bool sourceIndexValid;
+	mutable bool scanIndexValid;
+	mutable bool modeIndexValid;
+	mutable bool antennaIndexValid;
+	// scan x antenna relations: rows are scan ids, columns are ids in stationNames.
+	// Rebuilt lazily whenever scans, antennas or data sources change.
+	mutable VexBitMatrix scanStations;	// antenna takes part in the scan
+	mutable VexBitMatrix scanRecordEnable;	// antenna records during the scan
+	mutable VexBitMatrix scanHasData;	// antenna has baseband data for the scan; see hasData()
+	mutable bool scanMatrixValid;
+	mutable unsigned long nNameLookup;	// number of name lookups served
+	mutable unsigned long nIndexBuild;	// number of times an index was (re)built; counted atomically
+
+	void updateSourceIndex() const;
+	void updateScanIndex() const;
+	void updateModeIndex() const;
+	void updateAntennaIndex() const;
+	void updateScanMatrices() const;
+
+	// scans point at stationNames, so a VexData cannot be copied
+	VexData(const VexData &);
+	VexData &operator=(const VexData &);
+
 public:
 	int sanityCheck();
 
-	VexData() : version(0.0) {}
+	VexData() : version(0.0), sourceIndexValid(false), scanIndexValid(false), modeIndexValid(false), antennaIndexValid(false), scanMatrixValid(false), nNameLookup(0), nIndexBuild(0) {}
 
 	VexSource *newSource();
 	VexSource *newSource(const std::string &name, double ra, double dec);
@@ -88,13 +127,13 @@ public:
 	void setClock(const std::string &antName, const VexClock &clock);
 	void adjustClock(const std::string &antName, double deltaClock, double deltaClockRate);
 	void setTcalFrequency(const std::string &antName, int tcalFrequency);
-	void addExperEvents(std::list<Event> &events) const;
-	void addClockEvents(std::list<Event> &events) const;
-	void addScanEvents(std::list<Event> &events) const;
-	void addVSNEvents(std::list<Event> &events) const;
-	void addBreakEvents(std::list<Event> &events, const std::vector<double> &breaks) const;
-	void addLeapSecondEvents(std::list<Event> &events) const;
-	void generateEvents(std::list<Event> &events) const;
+	void addExperEvents(EventTimeline &events) const;
+	void addClockEvents(EventTimeline &events) const;
+	void addScanEvents(EventTimeline &events) const;
+	void addVSNEvents(EventTimeline &events) const;
+	void addBreakEvents(EventTimeline &events, const std::vector<double> &breaks) const;
+	void addLeapSecondEvents(EventTimeline &events) const;
+	void generateEvents(EventTimeline &events) const;
 	void setDifxTsys(unsigned int antId, unsigned int streamId, double tSys);
 	void setNoDatastream(unsigned int antId, unsigned int streamId);
 	void setFiles(unsigned int antId, unsigned int streamId, const std::vector<VexBasebandData> &files);
@@ -141,13 +180,19 @@ public:
 	void setSourceCoordinates(const std::string &name, double ra, double dec);	// (ra, dec in radians)
 
 	size_t nScan() const { return scans.size(); }
+	unsigned int internStation(const std::string &antName) { scanMatrixValid = false; return stationNames.intern(antName); }
+	const VexStationNames &getStationNames() const { return stationNames; }
 	const VexScan *getScan(unsigned int num) const;
+	int getScanIdByDefName(const std::string &defName) const;
 	const VexScan *getScanByDefName(const std::string &defName) const;
 	const VexScan *getScanByAntennaTime(const std::string &antName, double mjd) const;
 	void reduceScans(int minSubarraySize, const Interval &timerange);
 	void setScanSize(unsigned int num, double size);
 	void getScanList(std::list<std::string> &scans) const;
 	unsigned int nAntennasWithRecordedData(const VexScan &scan) const;
+	const VexBitMatrix &getScanStationMatrix() const { updateScanMatrices(); return scanStations; }
+	const VexBitMatrix &getScanRecordEnableMatrix() const { updateScanMatrices(); return scanRecordEnable; }
+	const VexBitMatrix &getScanHasDataMatrix() const { updateScanMatrices(); return scanHasData; }
 	bool removeScan(const std::string name);	// Note: cannot pass name as reference!
 	void deletePhaseCenters(unsigned int num);
 	void addPhaseCenter(unsigned int num, const std::string &name);
@@ -196,6 +241,14 @@ public:
 	void setVersion(const std::string &ver);
 	void setVersion(double ver);
 	double getVersion() const;
+
+	// Lookups by name lazily (re)build the indexes above, as do baseband data
+	// queries on each antenna's time index and the scan x antenna matrices.
+	// Call this before sharing a const VexData between threads so that lookups only read.
+	void buildNameIndexes() const;
+
+	unsigned long getNameLookupCount() const { return nNameLookup; }
+	unsigned long getIndexBuildCount() const { return nIndexBuild; }
 };
 
 std::ostream& operator << (std::ostream &os, const VexData &x);
@@ -134,7 +134,7 @@ int VexMode::getPols(char *pols) const
 
 int VexMode::getBits() const
 {
-	static int firstTime = 1;
+	static int firstTime = 1;	// may be reached from several job writing threads
 	unsigned int nBit = setups.begin()->second.getBits();
 	std::map<std::string,VexSetup>::const_iterator it;
 
@@ -144,12 +144,10 @@ int VexMode::getBits() const
 
 		if(nb != nBit)
 		{
-			if(nBit != 0 && nb != 0 && firstTime)
+			if(nBit != 0 && nb != 0 && __sync_bool_compare_and_swap(&firstTime, 1, 0))
 			{
 				std::cerr << "Note: getBits: Mode=" << defName << " differing number of bits: " << nBit << "," << nb << std::endl;
 				std::cerr << "  Will proceed, but note that some metadata may be incorrect." << std::endl;
-
-				firstTime = 0;
 			}
 
 			if(nb > nBit)
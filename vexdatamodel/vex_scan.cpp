@@ -27,14 +27,47 @@
  *
  *==========================================================================*/
 
+#include <algorithm>
 #include "vex_scan.h"
 
-const Interval *VexScan::getAntennaInterval(const std::string &antName) const
+unsigned int VexStationNames::intern(const std::string &name)
+{
+	std::map<std::string,unsigned int>::const_iterator it = ids.find(name);
+
+	if(it != ids.end())
+	{
+		return it->second;
+	}
+	names.push_back(name);
+	ids[name] = names.size() - 1;
+
+	return names.size() - 1;
+}
+
+int VexStationNames::getId(const std::string &name) const
 {
-	std::map<std::string,Interval>::const_iterator it = stations.find(antName);
-	if(it != stations.end())
+	std::map<std::string,unsigned int>::const_iterator it = ids.find(name);
+
+	if(it == ids.end())
 	{
-		return &it->second;
+		return -1;
+	}
+
+	return it->second;
+}
+
+static bool stationBefore(const VexScanStation &s, unsigned int antId)
+{
+	return s.antId < antId;
+}
+
+const VexScanStation *VexScan::getStation(unsigned int antId) const
+{
+	std::vector<VexScanStation>::const_iterator it = std::lower_bound(stations.begin(), stations.end(), antId, stationBefore);
+
+	if(it != stations.end() && it->antId == antId)
+	{
+		return &(*it);
 	}
 	else
 	{
@@ -42,17 +75,67 @@ const Interval *VexScan::getAntennaInterval(const std::string &antName) const
 	}
 }
 
-bool VexScan::getRecordEnable(const std::string &antName) const
+const VexScanStation *VexScan::getStation(const std::string &antName) const
 {
-	std::map<std::string,bool>::const_iterator it = recordEnable.find(antName);
-	if(it != recordEnable.end())
+	int antId;
+
+	if(!stationNames)
 	{
-		return it->second;
+		return 0;
+	}
+	antId = stationNames->getId(antName);
+	if(antId < 0)
+	{
+		return 0;
+	}
+
+	return getStation(static_cast<unsigned int>(antId));
+}
+
+// Adds or replaces the entry for antId, keeping stations sorted
+void VexScan::setStation(unsigned int antId, const Interval &timeRange, bool recordEnable)
+{
+	std::vector<VexScanStation>::iterator it = std::lower_bound(stations.begin(), stations.end(), antId, stationBefore);
+
+	if(it != stations.end() && it->antId == antId)
+	{
+		*it = VexScanStation(antId, timeRange, recordEnable);
 	}
 	else
+	{
+		stations.insert(it, VexScanStation(antId, timeRange, recordEnable));
+	}
+}
+
+// Returns true if the antenna was in the scan
+bool VexScan::removeStation(const std::string &antName)
+{
+	const VexScanStation *station = getStation(antName);
+
+	if(!station)
 	{
 		return false;
 	}
+	stations.erase(stations.begin() + (station - &stations[0]));
+
+	return true;
+}
+
+const Interval *VexScan::getAntennaInterval(const std::string &antName) const
+{
+	return getStation(antName);
+}
+
+bool VexScan::hasAntenna(const std::string &antName) const
+{
+	return getStation(antName) != 0;
+}
+
+bool VexScan::getRecordEnable(const std::string &antName) const
+{
+	const VexScanStation *station = getStation(antName);
+
+	return station ? station->recordEnable : false;
 }
 
 void VexScan::addToSourceSet(std::set<std::string> &sourceSet, bool incPointingCenter) const
@@ -84,14 +167,14 @@ std::ostream& operator << (std::ostream &os, const VexScan &x)
 	}
 	os <<   "\n  size=" << x.size << " bytes \n";
 
-	for(std::map<std::string,Interval>::const_iterator iter = x.stations.begin(); iter != x.stations.end(); ++iter)
+	for(std::vector<VexScanStation>::const_iterator iter = x.stations.begin(); iter != x.stations.end(); ++iter)
 	{
-		os << "  " << iter->first << " range=" << iter->second << std::endl;
+		os << "  " << x.getStationName(*iter) << " range=" << static_cast<const Interval &>(*iter) << std::endl;
 	}
 
-	for(std::map<std::string,bool>::const_iterator iter = x.recordEnable.begin(); iter != x.recordEnable.end(); ++iter)
+	for(std::vector<VexScanStation>::const_iterator iter = x.stations.begin(); iter != x.stations.end(); ++iter)
 	{
-		os << "  " << iter->first << " enable=" << iter->second << std::endl;
+		os << "  " << x.getStationName(*iter) << " enable=" << iter->recordEnable << std::endl;
 	}
 
 	for(std::vector<VexIntent>::const_iterator iter = x.scanIntent.begin(); iter != x.scanIntent.end(); ++iter)
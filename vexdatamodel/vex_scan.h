@@ -38,6 +38,32 @@
 #include "interval.h"
 #include "vex_intent.h"
 
+// Interned names of the antennas taking part in scans.  Ids are never reused, and those
+// assigned when loading a vex file follow the alphabetical order of the names.
+class VexStationNames
+{
+public:
+	unsigned int intern(const std::string &name);
+	int getId(const std::string &name) const;	// returns < 0 if name is not known
+	const std::string &getName(unsigned int id) const { return names[id]; }
+	unsigned int size() const { return names.size(); }
+
+private:
+	std::vector<std::string> names;
+	std::map<std::string,unsigned int> ids;
+};
+
+// The participation of one antenna in a scan
+class VexScanStation : public Interval
+{
+public:
+	unsigned int antId;	// index into the owning VexData's station names
+	bool recordEnable;	// This is true if the drive number is non-zero
+
+	VexScanStation() : antId(0), recordEnable(false) {}
+	VexScanStation(unsigned int id, const Interval &timeRange, bool enable) : Interval(timeRange), antId(id), recordEnable(enable) {}
+};
+
 class VexScan : public Interval
 {
 public:
@@ -48,12 +74,17 @@ public:
 	std::string modeDefName;
 	std::string sourceDefName;			// pointing center
 	std::vector<std::string> phaseCenters;		// correlation centers; must include sourceDefName if that is to be correlated
-	std::map<std::string,Interval> stations;
-	std::map<std::string,bool> recordEnable;	// This is true if the drive number is non-zero
+	std::vector<VexScanStation> stations;		// sorted by antId
+	const VexStationNames *stationNames;		// set by VexData::newScan()
 	double size;					// [bytes] approx. correlated size
-	double mjdVex;					// The start time listed in the vex file
+	VexTime mjdVex;					// The start time listed in the vex file
 
-	VexScan(): size(0), mjdVex(0.0) {};
+	VexScan(): stationNames(0), size(0), mjdVex(0.0) {};
+	const std::string &getStationName(const VexScanStation &station) const { return stationNames->getName(station.antId); }
+	const VexScanStation *getStation(unsigned int antId) const;
+	const VexScanStation *getStation(const std::string &antName) const;
+	void setStation(unsigned int antId, const Interval &timeRange, bool recordEnable);
+	bool removeStation(const std::string &antName);
 	const Interval *getAntennaInterval(const std::string &antName) const;
 	bool hasAntenna(const std::string &antName) const;
 	bool getRecordEnable(const std::string &antName) const;
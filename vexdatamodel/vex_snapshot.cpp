@@ -0,0 +1,909 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2021 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vex_snapshot.h"
+
+// File layout: the header below, then the VexData payload.  All values are
+// stored in native byte order; byteOrder lets a snapshot written on a machine
+// of different endianness be recognized and ignored.  Strings and containers
+// are a uint32_t count followed by the elements.
+
+const uint32_t VexSnapshotVersion = 3;
+
+static const char snapshotMagic[8] = { 'V', 'E', 'X', 'S', 'N', 'A', 'P', '\n' };
+static const uint32_t snapshotByteOrder = 0x01020304;
+
+class SnapshotWriter
+{
+public:
+	void putRaw(const void *data, size_t n) { buffer.append(static_cast<const char *>(data), n); }
+
+	std::string buffer;
+};
+
+class SnapshotReader
+{
+public:
+	SnapshotReader(const char *data, size_t n) : pos(data), end(data + n), ok(true) {}
+	void getRaw(void *data, size_t n)
+	{
+		if(!ok || static_cast<size_t>(end - pos) < n)
+		{
+			ok = false;
+			memset(data, 0, n);
+		}
+		else
+		{
+			memcpy(data, pos, n);
+			pos += n;
+		}
+	}
+	// Container counts can be no larger than the bytes remaining; this keeps a corrupt count from causing a huge allocation
+	uint32_t getCount()
+	{
+		uint32_t n;
+
+		getRaw(&n, sizeof(n));
+		if(n > static_cast<size_t>(end - pos))
+		{
+			ok = false;
+			n = 0;
+		}
+
+		return n;
+	}
+	bool atEnd() const { return pos == end; }
+
+	const char *pos;
+	const char *end;
+	bool ok;
+};
+
+
+// Scalars
+
+static void put(SnapshotWriter &w, int x) { w.putRaw(&x, sizeof(x)); }
+static void put(SnapshotWriter &w, unsigned int x) { w.putRaw(&x, sizeof(x)); }
+static void put(SnapshotWriter &w, double x) { w.putRaw(&x, sizeof(x)); }
+static void put(SnapshotWriter &w, float x) { w.putRaw(&x, sizeof(x)); }
+static void put(SnapshotWriter &w, char x) { w.putRaw(&x, sizeof(x)); }
+static void put(SnapshotWriter &w, bool x) { put(w, static_cast<char>(x ? 1 : 0)); }
+static void put(SnapshotWriter &w, const VexTime &x)
+{
+	int64_t ns = x.nanosecondsOfDay();
+
+	put(w, x.intMJD());
+	w.putRaw(&ns, sizeof(ns));
+}
+
+static void get(SnapshotReader &r, int &x) { r.getRaw(&x, sizeof(x)); }
+static void get(SnapshotReader &r, unsigned int &x) { r.getRaw(&x, sizeof(x)); }
+static void get(SnapshotReader &r, double &x) { r.getRaw(&x, sizeof(x)); }
+static void get(SnapshotReader &r, float &x) { r.getRaw(&x, sizeof(x)); }
+static void get(SnapshotReader &r, char &x) { r.getRaw(&x, sizeof(x)); }
+static void get(SnapshotReader &r, bool &x)
+{
+	char c;
+
+	get(r, c);
+	x = (c != 0);
+}
+
+static void get(SnapshotReader &r, VexTime &x)
+{
+	int mjd;
+	int64_t ns;
+
+	get(r, mjd);
+	r.getRaw(&ns, sizeof(ns));
+	x = VexTime(mjd, ns);
+}
+
+template <typename T> static void getEnum(SnapshotReader &r, T &x)
+{
+	int v;
+
+	get(r, v);
+	x = static_cast<T>(v);
+}
+
+static void put(SnapshotWriter &w, const std::string &x)
+{
+	put(w, static_cast<unsigned int>(x.size()));
+	w.putRaw(x.data(), x.size());
+}
+
+static void get(SnapshotReader &r, std::string &x)
+{
+	uint32_t n = r.getCount();
+
+	if(r.ok)
+	{
+		x.assign(r.pos, n);
+		r.pos += n;
+	}
+}
+
+
+// Containers
+
+template <typename T> static void put(SnapshotWriter &w, const std::vector<T> &x)
+{
+	put(w, static_cast<unsigned int>(x.size()));
+	for(typename std::vector<T>::const_iterator it = x.begin(); it != x.end(); ++it)
+	{
+		put(w, *it);
+	}
+}
+
+template <typename T> static void get(SnapshotReader &r, std::vector<T> &x)
+{
+	uint32_t n = r.getCount();
+
+	x.clear();
+	x.resize(n);
+	for(typename std::vector<T>::iterator it = x.begin(); it != x.end(); ++it)
+	{
+		get(r, *it);
+	}
+}
+
+static void put(SnapshotWriter &w, const std::set<int> &x)
+{
+	put(w, static_cast<unsigned int>(x.size()));
+	for(std::set<int>::const_iterator it = x.begin(); it != x.end(); ++it)
+	{
+		put(w, *it);
+	}
+}
+
+static void get(SnapshotReader &r, std::set<int> &x)
+{
+	uint32_t n = r.getCount();
+
+	x.clear();
+	for(uint32_t i = 0; i < n && r.ok; ++i)
+	{
+		int v;
+
+		get(r, v);
+		x.insert(x.end(), v);
+	}
+}
+
+template <typename T> static void put(SnapshotWriter &w, const std::map<std::string,T> &x)
+{
+	put(w, static_cast<unsigned int>(x.size()));
+	for(typename std::map<std::string,T>::const_iterator it = x.begin(); it != x.end(); ++it)
+	{
+		put(w, it->first);
+		put(w, it->second);
+	}
+}
+
+template <typename T> static void get(SnapshotReader &r, std::map<std::string,T> &x)
+{
+	uint32_t n = r.getCount();
+
+	x.clear();
+	for(uint32_t i = 0; i < n && r.ok; ++i)
+	{
+		std::string key;
+
+		get(r, key);
+		get(r, x[key]);
+	}
+}
+
+
+// Data model classes
+
+static void put(SnapshotWriter &w, const Interval &x)
+{
+	put(w, x.mjdStart);
+	put(w, x.mjdStop);
+}
+
+static void get(SnapshotReader &r, Interval &x)
+{
+	get(r, x.mjdStart);
+	get(r, x.mjdStop);
+}
+
+static void put(SnapshotWriter &w, const VexExtension &x)
+{
+	put(w, x.owner);
+	put(w, x.name);
+	put(w, x.value);
+	put(w, x.units);
+}
+
+static void get(SnapshotReader &r, VexExtension &x)
+{
+	get(r, x.owner);
+	get(r, x.name);
+	get(r, x.value);
+	get(r, x.units);
+}
+
+static void put(SnapshotWriter &w, const VexSource &x)
+{
+	put(w, static_cast<int>(x.type));
+	put(w, x.defName);
+	put(w, x.sourceType1);
+	put(w, x.sourceType2);
+	put(w, x.sourceType3);
+	for(int i = 0; i < 3; ++i)
+	{
+		put(w, x.tle[i]);
+	}
+	put(w, x.bspFile);
+	put(w, x.bspObject);
+	put(w, x.ephemDeltaT);
+	put(w, x.ephemStellarAber);
+	put(w, x.ephemClockError);
+	put(w, x.X);
+	put(w, x.Y);
+	put(w, x.Z);
+	put(w, x.sourceNames);
+	put(w, x.ra);
+	put(w, x.dec);
+	put(w, x.calCode);
+}
+
+static void get(SnapshotReader &r, VexSource &x)
+{
+	getEnum(r, x.type);
+	get(r, x.defName);
+	get(r, x.sourceType1);
+	get(r, x.sourceType2);
+	get(r, x.sourceType3);
+	for(int i = 0; i < 3; ++i)
+	{
+		get(r, x.tle[i]);
+	}
+	get(r, x.bspFile);
+	get(r, x.bspObject);
+	get(r, x.ephemDeltaT);
+	get(r, x.ephemStellarAber);
+	get(r, x.ephemClockError);
+	get(r, x.X);
+	get(r, x.Y);
+	get(r, x.Z);
+	get(r, x.sourceNames);
+	get(r, x.ra);
+	get(r, x.dec);
+	get(r, x.calCode);
+}
+
+static void put(SnapshotWriter &w, const VexIntent &x)
+{
+	put(w, x.identifier);
+	put(w, x.value);
+	put(w, x.source);
+}
+
+// VexIntent has no default constructor
+static void get(SnapshotReader &r, std::vector<VexIntent> &x)
+{
+	uint32_t n = r.getCount();
+
+	x.clear();
+	for(uint32_t i = 0; i < n && r.ok; ++i)
+	{
+		x.push_back(VexIntent(0, "", ""));
+		get(r, x.back().identifier);
+		get(r, x.back().value);
+		get(r, x.back().source);
+	}
+}
+
+static void put(SnapshotWriter &w, const VexScanStation &x)
+{
+	put(w, static_cast<const Interval &>(x));
+	put(w, x.antId);
+	put(w, x.recordEnable);
+}
+
+static void get(SnapshotReader &r, VexScanStation &x)
+{
+	get(r, static_cast<Interval &>(x));
+	get(r, x.antId);
+	get(r, x.recordEnable);
+}
+
+static void put(SnapshotWriter &w, const VexScan &x)
+{
+	put(w, static_cast<const Interval &>(x));
+	put(w, x.defName);
+	put(w, x.intent);
+	put(w, x.scanIntent);
+	put(w, x.modeDefName);
+	put(w, x.sourceDefName);
+	put(w, x.phaseCenters);
+	put(w, x.stations);
+	put(w, x.size);
+	put(w, x.mjdVex);
+}
+
+static void get(SnapshotReader &r, VexScan &x)
+{
+	get(r, static_cast<Interval &>(x));
+	get(r, x.defName);
+	get(r, x.intent);
+	get(r, x.scanIntent);
+	get(r, x.modeDefName);
+	get(r, x.sourceDefName);
+	get(r, x.phaseCenters);
+	get(r, x.stations);
+	get(r, x.size);
+	get(r, x.mjdVex);
+}
+
+static void put(SnapshotWriter &w, const VexSubband &x)
+{
+	put(w, x.freq);
+	put(w, x.bandwidth);
+	put(w, x.sideBand);
+	put(w, x.pol);
+}
+
+static void get(SnapshotReader &r, VexSubband &x)
+{
+	get(r, x.freq);
+	get(r, x.bandwidth);
+	get(r, x.sideBand);
+	get(r, x.pol);
+}
+
+static void put(SnapshotWriter &w, const VexIF &x)
+{
+	put(w, x.ifLink);
+	put(w, x.ifName);
+	put(w, x.ifSSLO);
+	put(w, x.ifSideBand);
+	put(w, x.pol);
+	put(w, x.phaseCalIntervalMHz);
+	put(w, x.phaseCalBaseMHz);
+	put(w, x.ifSampleRate);
+	put(w, x.rxName);
+	put(w, x.upstreamSSLO);
+	put(w, x.upstreamSideBand);
+	put(w, static_cast<int>(x.spAmp));
+	put(w, x.spFreq);
+	put(w, x.comment);
+}
+
+static void get(SnapshotReader &r, VexIF &x)
+{
+	get(r, x.ifLink);
+	get(r, x.ifName);
+	get(r, x.ifSSLO);
+	get(r, x.ifSideBand);
+	get(r, x.pol);
+	get(r, x.phaseCalIntervalMHz);
+	get(r, x.phaseCalBaseMHz);
+	get(r, x.ifSampleRate);
+	get(r, x.rxName);
+	get(r, x.upstreamSSLO);
+	get(r, x.upstreamSideBand);
+	getEnum(r, x.spAmp);
+	get(r, x.spFreq);
+	get(r, x.comment);
+}
+
+static void put(SnapshotWriter &w, const VexChannel &x)
+{
+	put(w, x.recordChan);
+	put(w, x.subbandId);
+	put(w, x.bbcFreq);
+	put(w, x.bbcBandwidth);
+	put(w, x.bbcSideBand);
+	put(w, x.bandLink);
+	put(w, x.chanName);
+	put(w, x.ifLink);
+	put(w, x.chanLink);
+	put(w, x.bbcName);
+	put(w, x.phaseCalName);
+	put(w, x.tones);
+	put(w, x.threadId);
+}
+
+static void get(SnapshotReader &r, VexChannel &x)
+{
+	get(r, x.recordChan);
+	get(r, x.subbandId);
+	get(r, x.bbcFreq);
+	get(r, x.bbcBandwidth);
+	get(r, x.bbcSideBand);
+	get(r, x.bandLink);
+	get(r, x.chanName);
+	get(r, x.ifLink);
+	get(r, x.chanLink);
+	get(r, x.bbcName);
+	get(r, x.phaseCalName);
+	get(r, x.tones);
+	get(r, x.threadId);
+}
+
+static void put(SnapshotWriter &w, const VexThread &x)
+{
+	put(w, x.threadId);
+	put(w, x.startRecordChan);
+	put(w, x.nChan);
+	put(w, x.sampRate);
+	put(w, x.threadLink);
+	put(w, x.nBit);
+	put(w, x.dataBytes);
+}
+
+// VexThread has no default constructor
+static void get(SnapshotReader &r, std::vector<VexThread> &x)
+{
+	uint32_t n = r.getCount();
+
+	x.clear();
+	for(uint32_t i = 0; i < n && r.ok; ++i)
+	{
+		x.push_back(VexThread(0));
+		get(r, x.back().threadId);
+		get(r, x.back().startRecordChan);
+		get(r, x.back().nChan);
+		get(r, x.back().sampRate);
+		get(r, x.back().threadLink);
+		get(r, x.back().nBit);
+		get(r, x.back().dataBytes);
+	}
+}
+
+static void put(SnapshotWriter &w, const VexStream &x)
+{
+	put(w, x.sampRate);
+	put(w, x.nBit);
+	put(w, x.nRecordChan);
+	put(w, x.fanout);
+	put(w, x.VDIFFrameSize);
+	put(w, x.singleThread);
+	put(w, x.threads);
+	put(w, x.threadsAbsent);
+	put(w, x.threadsIgnore);
+	put(w, static_cast<int>(x.format));
+	put(w, static_cast<int>(x.dataSampling));
+	put(w, static_cast<int>(x.dataSource));
+	put(w, x.alignmentPeriod);
+	put(w, x.difxTsys);
+	put(w, x.streamLink);
+	put(w, x.streamName);
+}
+
+static void get(SnapshotReader &r, VexStream &x)
+{
+	get(r, x.sampRate);
+	get(r, x.nBit);
+	get(r, x.nRecordChan);
+	get(r, x.fanout);
+	get(r, x.VDIFFrameSize);
+	get(r, x.singleThread);
+	get(r, x.threads);
+	get(r, x.threadsAbsent);
+	get(r, x.threadsIgnore);
+	getEnum(r, x.format);
+	getEnum(r, x.dataSampling);
+	getEnum(r, x.dataSource);
+	get(r, x.alignmentPeriod);
+	get(r, x.difxTsys);
+	get(r, x.streamLink);
+	get(r, x.streamName);
+}
+
+static void put(SnapshotWriter &w, const VexSetup &x)
+{
+	put(w, static_cast<int>(x.type));
+	put(w, x.ifs);
+	put(w, x.channels);
+	put(w, x.streams);
+	put(w, x.extensions);
+}
+
+static void get(SnapshotReader &r, VexSetup &x)
+{
+	getEnum(r, x.type);
+	get(r, x.ifs);
+	get(r, x.channels);
+	get(r, x.streams);
+	get(r, x.extensions);
+}
+
+static void put(SnapshotWriter &w, const VexMode &x)
+{
+	put(w, x.defName);
+	put(w, x.subbands);
+	put(w, x.zoombands);
+	put(w, x.setups);
+}
+
+static void get(SnapshotReader &r, VexMode &x)
+{
+	get(r, x.defName);
+	get(r, x.subbands);
+	get(r, x.zoombands);
+	get(r, x.setups);
+}
+
+static void put(SnapshotWriter &w, const VexClock &x)
+{
+	put(w, x.mjdStart);
+	put(w, x.offset);
+	put(w, x.rate);
+	put(w, x.accel);
+	put(w, x.jerk);
+	put(w, x.offset_epoch);
+}
+
+static void get(SnapshotReader &r, VexClock &x)
+{
+	get(r, x.mjdStart);
+	get(r, x.offset);
+	get(r, x.rate);
+	get(r, x.accel);
+	get(r, x.jerk);
+	get(r, x.offset_epoch);
+}
+
+static void put(SnapshotWriter &w, const VexBasebandData &x)
+{
+	put(w, static_cast<const Interval &>(x));
+	put(w, x.filename);
+	put(w, x.recorderId);
+	put(w, x.streamId);
+}
+
+static void get(SnapshotReader &r, VexBasebandData &x)
+{
+	get(r, static_cast<Interval &>(x));
+	get(r, x.filename);
+	get(r, x.recorderId);
+	get(r, x.streamId);
+}
+
+static void put(SnapshotWriter &w, const VexNetworkData &x)
+{
+	put(w, x.networkPort);
+	put(w, x.windowSize);
+}
+
+static void get(SnapshotReader &r, VexNetworkData &x)
+{
+	get(r, x.networkPort);
+	get(r, x.windowSize);
+}
+
+static void get(SnapshotReader &r, VexAntenna::NasmythType &x)
+{
+	getEnum(r, x);
+}
+
+static void put(SnapshotWriter &w, const VexAntenna &x)
+{
+	put(w, x.name);
+	put(w, x.defName);
+	put(w, x.difxName);
+	put(w, x.twoCharSiteCode);
+	put(w, x.oneCharSiteCode);
+	put(w, x.x);
+	put(w, x.y);
+	put(w, x.z);
+	put(w, x.dx);
+	put(w, x.dy);
+	put(w, x.dz);
+	put(w, x.posEpoch);
+	put(w, x.axisType);
+	put(w, x.axisOffset);
+	put(w, x.clocks);
+	put(w, x.tcalFrequency);
+	put(w, x.polConvert);
+	put(w, x.vsns);
+	put(w, x.files);
+	put(w, x.ports);
+	put(w, x.extensions);
+	put(w, static_cast<unsigned int>(x.nasmyth.size()));
+	for(std::map<std::string,VexAntenna::NasmythType>::const_iterator it = x.nasmyth.begin(); it != x.nasmyth.end(); ++it)
+	{
+		put(w, it->first);
+		put(w, static_cast<int>(it->second));
+	}
+}
+
+static void get(SnapshotReader &r, VexAntenna &x)
+{
+	get(r, x.name);
+	get(r, x.defName);
+	get(r, x.difxName);
+	get(r, x.twoCharSiteCode);
+	get(r, x.oneCharSiteCode);
+	get(r, x.x);
+	get(r, x.y);
+	get(r, x.z);
+	get(r, x.dx);
+	get(r, x.dy);
+	get(r, x.dz);
+	get(r, x.posEpoch);
+	get(r, x.axisType);
+	get(r, x.axisOffset);
+	get(r, x.clocks);
+	get(r, x.tcalFrequency);
+	get(r, x.polConvert);
+	get(r, x.vsns);
+	get(r, x.files);
+	get(r, x.ports);
+	get(r, x.extensions);
+	get(r, x.nasmyth);
+}
+
+static void put(SnapshotWriter &w, const VexEOP &x)
+{
+	put(w, x.mjd);
+	put(w, x.tai_utc);
+	put(w, x.ut1_utc);
+	put(w, x.xPole);
+	put(w, x.yPole);
+}
+
+static void get(SnapshotReader &r, VexEOP &x)
+{
+	get(r, x.mjd);
+	get(r, x.tai_utc);
+	get(r, x.ut1_utc);
+	get(r, x.xPole);
+	get(r, x.yPole);
+}
+
+
+// The snapshot proper
+
+std::string vexSnapshotFileName(const std::string &vexFile)
+{
+	return vexFile + ".snapshot";
+}
+
+bool vexContentHash(const std::string &fileName, uint64_t *hash)
+{
+	const size_t BlockSize = 1 << 20;
+	char *buffer;
+	FILE *in;
+	size_t n;
+	uint64_t h = 14695981039346656037ULL;
+
+	in = fopen(fileName.c_str(), "r");
+	if(!in)
+	{
+		return false;
+	}
+
+	buffer = new char[BlockSize];
+	while((n = fread(buffer, 1, BlockSize, in)) > 0)
+	{
+		for(size_t i = 0; i < n; ++i)
+		{
+			h ^= static_cast<unsigned char>(buffer[i]);
+			h *= 1099511628211ULL;
+		}
+	}
+	delete [] buffer;
+
+	if(ferror(in))
+	{
+		fclose(in);
+
+		return false;
+	}
+	fclose(in);
+
+	*hash = h;
+
+	return true;
+}
+
+bool writeVexSnapshot(const VexData *V, const std::string &snapshotFile, uint64_t contentHash)
+{
+	SnapshotWriter w;
+	const VexExper *exper = V->getExper();
+	std::stringstream tmpFile;
+	FILE *out;
+	size_t n;
+
+	w.putRaw(snapshotMagic, sizeof(snapshotMagic));
+	w.putRaw(&VexSnapshotVersion, sizeof(VexSnapshotVersion));
+	w.putRaw(&snapshotByteOrder, sizeof(snapshotByteOrder));
+	w.putRaw(&contentHash, sizeof(contentHash));
+
+	put(w, static_cast<const Interval &>(*exper));
+	put(w, exper->name);
+	put(w, exper->segment);
+	put(w, V->getVersion());
+
+	put(w, static_cast<unsigned int>(V->nSource()));
+	for(unsigned int i = 0; i < V->nSource(); ++i)
+	{
+		put(w, *V->getSource(i));
+	}
+	put(w, V->getStationNames().size());
+	for(unsigned int i = 0; i < V->getStationNames().size(); ++i)
+	{
+		put(w, V->getStationNames().getName(i));
+	}
+	put(w, static_cast<unsigned int>(V->nScan()));
+	for(unsigned int i = 0; i < V->nScan(); ++i)
+	{
+		put(w, *V->getScan(i));
+	}
+	put(w, static_cast<unsigned int>(V->nMode()));
+	for(unsigned int i = 0; i < V->nMode(); ++i)
+	{
+		put(w, *V->getMode(i));
+	}
+	put(w, static_cast<unsigned int>(V->nAntenna()));
+	for(unsigned int i = 0; i < V->nAntenna(); ++i)
+	{
+		put(w, *V->getAntenna(i));
+	}
+	put(w, V->getEOPs());
+	put(w, static_cast<unsigned int>(V->nExtension()));
+	for(unsigned int i = 0; i < V->nExtension(); ++i)
+	{
+		put(w, *V->getExtension(i));
+	}
+
+	// Write under a private name and rename so that a concurrent reader never sees a partial file
+	tmpFile << snapshotFile << ".tmp." << getpid();
+	out = fopen(tmpFile.str().c_str(), "w");
+	if(!out)
+	{
+		return false;
+	}
+	n = fwrite(w.buffer.data(), 1, w.buffer.size(), out);
+	if(fclose(out) != 0 || n != w.buffer.size() || rename(tmpFile.str().c_str(), snapshotFile.c_str()) != 0)
+	{
+		unlink(tmpFile.str().c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+static VexData *decodeVexSnapshot(SnapshotReader &r, uint64_t contentHash)
+{
+	char magic[sizeof(snapshotMagic)];
+	uint32_t version, byteOrder;
+	uint64_t hash;
+	Interval experTimeRange;
+	std::string experName, experSegment;
+	double vexVersion;
+	VexData *V;
+
+	r.getRaw(magic, sizeof(magic));
+	r.getRaw(&version, sizeof(version));
+	r.getRaw(&byteOrder, sizeof(byteOrder));
+	r.getRaw(&hash, sizeof(hash));
+	if(!r.ok || memcmp(magic, snapshotMagic, sizeof(magic)) != 0 || version != VexSnapshotVersion || byteOrder != snapshotByteOrder || hash != contentHash)
+	{
+		return 0;
+	}
+
+	V = new VexData();
+
+	get(r, experTimeRange);
+	get(r, experName);
+	get(r, experSegment);
+	V->setExper(experName, experSegment, experTimeRange);
+	get(r, vexVersion);
+	V->setVersion(vexVersion);
+
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		get(r, *V->newSource());
+	}
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		std::string stationName;
+
+		get(r, stationName);
+		V->internStation(stationName);
+	}
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		get(r, *V->newScan());
+	}
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		get(r, *V->newMode());
+	}
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		get(r, *V->newAntenna());
+	}
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		get(r, *V->newEOP());
+	}
+	for(uint32_t i = r.getCount(); i > 0 && r.ok; --i)
+	{
+		get(r, *V->newExtension());
+	}
+
+	if(!r.ok || !r.atEnd())
+	{
+		delete V;
+
+		return 0;
+	}
+
+	return V;
+}
+
+VexData *readVexSnapshot(const std::string &snapshotFile, uint64_t contentHash)
+{
+	struct stat st;
+	void *data;
+	int fd;
+	VexData *V;
+
+	fd = open(snapshotFile.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return 0;
+	}
+	if(fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+
+		return 0;
+	}
+	data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+	{
+		return 0;
+	}
+
+	SnapshotReader r(static_cast<const char *>(data), st.st_size);
+	V = decodeVexSnapshot(r, contentHash);
+
+	munmap(data, st.st_size);
+
+	return V;
+}
@@ -0,0 +1,57 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2021 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#ifndef __VEX_SNAPSHOT_H__
+#define __VEX_SNAPSHOT_H__
+
+#include <string>
+#include <stdint.h>
+#include "vex_data.h"
+
+// A snapshot is a binary image of the VexData produced by loadVexFile(),
+// stored next to the .vex file.  It is keyed on a hash of the vex file
+// contents so that a snapshot is only reused while the file is unchanged.
+
+// Increment whenever the layout below or the contents of VexData as
+// produced by loadVexFile() change; older snapshots are then ignored.
+extern const uint32_t VexSnapshotVersion;
+
+// Returns the name of the snapshot file belonging to vexFile
+std::string vexSnapshotFileName(const std::string &vexFile);
+
+// 64-bit FNV-1a hash of the file contents.  Returns false if the file cannot be read.
+bool vexContentHash(const std::string &fileName, uint64_t *hash);
+
+// Returns true on success.  The file is written under a temporary name and renamed into place.
+bool writeVexSnapshot(const VexData *V, const std::string &snapshotFile, uint64_t contentHash);
+
+// Returns a new VexData, or 0 if the snapshot is missing, corrupt, of another version or for other content
+VexData *readVexSnapshot(const std::string &snapshotFile, uint64_t contentHash);
+
+#endif
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#include <cmath>
+#include "vex_time.h"
+
+void VexTime::normalize()
+{
+	if(ns >= NanosecondsPerDay || ns < 0)
+	{
+		int64_t d = ns/NanosecondsPerDay;
+
+		ns -= d*NanosecondsPerDay;
+		if(ns < 0)
+		{
+			ns += NanosecondsPerDay;
+			--d;
+		}
+		day += d;
+	}
+}
+
+void VexTime::setMJD(double mjd)
+{
+	double d = floor(mjd);
+
+	day = static_cast<int>(d);
+	// mjd - d is exact, and the product stays well within the 53 bit mantissa
+	ns = static_cast<int64_t>(floor((mjd - d)*NanosecondsPerDay + 0.5));
+	normalize();
+}
+
+VexTime &VexTime::addSeconds(double seconds)
+{
+	return addNanoseconds(static_cast<int64_t>(floor(seconds*NanosecondsPerSecond + 0.5)));
+}
+
+std::ostream& operator << (std::ostream &os, const VexTime &x)
+{
+	os << x.mjd();
+
+	return os;
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2015-2022 by Walter Brisken & Adam Deller               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*===========================================================================
+ * SVN properties (DO NOT CHANGE)
+ *
+ * $Id$
+ * $HeadURL: https://svn.atnf.csiro.au/difx/applications/vex2difx/branches/multidatastream_refactor/src/vex2difx.cpp $
+ * $LastChangedRevision$
+ * $Author$
+ * $LastChangedDate$
+ *
+ *==========================================================================*/
+
+#ifndef __VEX_TIME_H__
+#define __VEX_TIME_H__
+
+#include <iostream>
+#include <stdint.h>
+
+// A point in time held as an integer MJD and integer nanoseconds into that day, so
+// that comparisons, sorting and differences are exact.  It converts implicitly to and
+// from a double MJD; for any MJD above 64 the round trip reproduces the double exactly,
+// so values handed on to difxio are unchanged.
+class VexTime
+{
+public:
+	static const int64_t NanosecondsPerSecond = 1000000000LL;
+	static const int64_t NanosecondsPerDay = 86400LL*NanosecondsPerSecond;
+
+	VexTime() : day(0), ns(0) {}
+	VexTime(double mjd) { setMJD(mjd); }
+	VexTime(int mjd, int64_t nanoseconds) : day(mjd), ns(nanoseconds) { normalize(); }
+	operator double() const { return mjd(); }
+
+	double mjd() const { return day + static_cast<double>(ns)/NanosecondsPerDay; }
+	void setMJD(double mjd);
+	int intMJD() const { return day; }
+	int64_t nanosecondsOfDay() const { return ns; }
+	int64_t nanosecondsSince(const VexTime &t) const { return (day - static_cast<int64_t>(t.day))*NanosecondsPerDay + (ns - t.ns); }
+	VexTime &addNanoseconds(int64_t deltaNS) { ns += deltaNS; normalize(); return *this; }
+	VexTime &addSeconds(double seconds);
+
+	// arithmetic on days, for code still working in double MJD
+	VexTime &operator+=(double days) { setMJD(mjd() + days); return *this; }
+	VexTime &operator-=(double days) { setMJD(mjd() - days); return *this; }
+
+	bool operator==(const VexTime &t) const { return day == t.day && ns == t.ns; }
+	bool operator!=(const VexTime &t) const { return day != t.day || ns != t.ns; }
+	bool operator<(const VexTime &t) const { return day < t.day || (day == t.day && ns < t.ns); }
+	bool operator>(const VexTime &t) const { return t < *this; }
+	bool operator<=(const VexTime &t) const { return !(t < *this); }
+	bool operator>=(const VexTime &t) const { return !(*this < t); }
+
+private:
+	int day;	// MJD
+	int64_t ns;	// 0 <= ns < NanosecondsPerDay
+
+	void normalize();
+};
+
+// Mixed comparisons convert the double to a VexTime, which preserves its ordering
+inline bool operator==(const VexTime &a, double b) { return a == VexTime(b); }
+inline bool operator!=(const VexTime &a, double b) { return a != VexTime(b); }
+inline bool operator<(const VexTime &a, double b) { return a < VexTime(b); }
+inline bool operator>(const VexTime &a, double b) { return a > VexTime(b); }
+inline bool operator<=(const VexTime &a, double b) { return a <= VexTime(b); }
+inline bool operator>=(const VexTime &a, double b) { return a >= VexTime(b); }
+inline bool operator==(double a, const VexTime &b) { return VexTime(a) == b; }
+inline bool operator!=(double a, const VexTime &b) { return VexTime(a) != b; }
+inline bool operator<(double a, const VexTime &b) { return VexTime(a) < b; }
+inline bool operator>(double a, const VexTime &b) { return VexTime(a) > b; }
+inline bool operator<=(double a, const VexTime &b) { return VexTime(a) <= b; }
+inline bool operator>=(double a, const VexTime &b) { return VexTime(a) >= b; }
+
+std::ostream& operator << (std::ostream &os, const VexTime &x);
+
+#endif
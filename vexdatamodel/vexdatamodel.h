@@ -50,6 +50,7 @@
 #include "vexload.h"
 #include "event.h"
 #include "interval.h"
+#include "vex_time.h"
 #include "vex_utility.h"
 
 #endif
@@ -35,17 +35,37 @@
 #include <cctype>
 #include <cstdio>
 #include <algorithm>
+#include <sstream>
 #include <unistd.h>
+#include <pthread.h>
 #include "vex_utility.h"
 #include "vex_data.h"
+#include "vex_snapshot.h"
 #include "../vex/vex.h"
 #include "../vex/vex_parse.h"
+#include "../vex/vex_cursor.h"
 
 // maximum number of defined IFs
 #define MAX_IF 64
 
 using namespace std;
 
+// Thrown on a fatal error while extracting a setup in a ModeSetupTask, whose log already
+// holds the reason.  Setup extraction runs in worker threads, which must not exit(), so the
+// task records the failure and getModes() exits once the logs before it have been printed.
+class ModeSetupFailure
+{
+public:
+	ModeSetupFailure(int s) : status(s) {}
+
+	int status;		// exit status
+};
+
+static void failModeSetup(int status)
+{
+	throw ModeSetupFailure(status);
+}
+
 class BitAssignments
 {
 public:
@@ -73,7 +93,7 @@ std::ostream& operator << (std::ostream &os, const BitAssignments &x)
 	return os;
 }
 
-int reorderBitAssignments(std::map<std::string,BitAssignments> &bitAssignements, int startSlotNumber)
+int reorderBitAssignments(std::map<std::string,BitAssignments> &bitAssignements, int startSlotNumber, std::ostream &log)
 {
 	const int MaxSlotNumber = 66;
 	int order[MaxSlotNumber+1];
@@ -91,15 +111,15 @@ int reorderBitAssignments(std::map<std::string,BitAssignments> &bitAssignements,
 		{
 			if(*b < 0 || *b > MaxSlotNumber)
 			{
-				cerr << "Error: sign assignment " << *b << " for channel " << it->first << " is out of range (0.." << MaxSlotNumber << ").  Must quit." << endl;
+				log << "Error: sign assignment " << *b << " for channel " << it->first << " is out of range (0.." << MaxSlotNumber << ").  Must quit." << endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 			if(order[*b] != -2)
 			{
-				cerr << "Error: sign assignment " << *b << " for channel " << it->first << " is repeated.  Must quit." << endl;
+				log << "Error: sign assignment " << *b << " for channel " << it->first << " is repeated.  Must quit." << endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 			order[*b] = -1;
 		}
@@ -108,15 +128,15 @@ int reorderBitAssignments(std::map<std::string,BitAssignments> &bitAssignements,
 		{
 			if(*b < 0 || *b > MaxSlotNumber)
 			{
-				cerr << "Error: mag assignment " << *b << " for channel " << it->first << " is out of range (0.." << MaxSlotNumber << ").  Must quit." << endl;
+				log << "Error: mag assignment " << *b << " for channel " << it->first << " is out of range (0.." << MaxSlotNumber << ").  Must quit." << endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 			if(order[*b] != -2)
 			{
-				cerr << "Error: mag assignment " << *b << " for channel " << it->first << " is repeated.  Must quit." << endl;
+				log << "Error: mag assignment " << *b << " for channel " << it->first << " is repeated.  Must quit." << endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 			order[*b] = -1;
 		}
@@ -173,7 +193,7 @@ static void fixOhs(std::string &str)
 	}
 }
 
-static int getRecordChannelFromTracks(const std::string &antName, const std::string &chanLink, const std::map<std::string,BitAssignments> &ch2tracks, const VexStream &stream, unsigned int n)
+static int getRecordChannelFromTracks(const std::string &antName, const std::string &chanLink, const std::map<std::string,BitAssignments> &ch2tracks, const VexStream &stream, unsigned int n, std::ostream &log)
 {
 	std::map<std::string,BitAssignments>::const_iterator it = ch2tracks.find(chanLink);
 	if(it == ch2tracks.end())
@@ -217,7 +237,7 @@ static int getRecordChannelFromTracks(const std::string &antName, const std::str
 
 		if(T.sign.empty())
 		{
-			cerr << "Note: antenna " << antName << " has Mark5B format but no tracks defined in the vex file." << endl;
+			log << "Note: antenna " << antName << " has Mark5B format but no tracks defined in the vex file." << endl;
 
 			return -1;
 		}
@@ -250,16 +270,16 @@ static int getRecordChannelFromTracks(const std::string &antName, const std::str
 	}
 	else
 	{
-		std::cerr << "Error: Antenna=" << antName << " format \"" << VexStream::DataFormatNames[stream.format] << "\" is not yet supported" << std::endl;
-		std::cerr << "Contact developer." << std::endl;
+		log << "Error: Antenna=" << antName << " format \"" << VexStream::DataFormatNames[stream.format] << "\" is not yet supported" << std::endl;
+		log << "Contact developer." << std::endl;
 
-		exit(EXIT_FAILURE);
+		failModeSetup(EXIT_FAILURE);
 	}
 
 	return -1;
 }
 
-static int getRecordChannelFromBitstreams(const std::string &antName, const std::string &chanLink, const std::map<std::string,BitAssignments> &ch2bitstreams, const VexStream &stream, unsigned int n)
+static int getRecordChannelFromBitstreams(const std::string &antName, const std::string &chanLink, const std::map<std::string,BitAssignments> &ch2bitstreams, const VexStream &stream, unsigned int n, std::ostream &log)
 {
 	int delta, track;
 	std::map<std::string,BitAssignments>::const_iterator it = ch2bitstreams.find(chanLink);
@@ -271,7 +291,7 @@ static int getRecordChannelFromBitstreams(const std::string &antName, const std:
 
 	if(T.sign.empty())
 	{
-		cerr << "Note: antenna " << antName << " has Mark5B format but no tracks defined in the vex file." << endl;
+		log << "Note: antenna " << antName << " has Mark5B format but no tracks defined in the vex file." << endl;
 
 		return -1;
 	}
@@ -287,9 +307,10 @@ int DOYtoMJD(int year, int doy)
 	return doy-678576+365*(year-1)+(year-1)/4-(year-1)/100+(year-1)/400;
 }
 
-double vexDate(char *value)
+// Parses a vex date exactly; fractional seconds are kept to the nanosecond
+VexTime vexTime(char *value)
 {
-	double mjd;
+	VexTime t;
 	int n = 0;
 	
 	for(int i = 0; value[i]; ++i)
@@ -302,14 +323,16 @@ double vexDate(char *value)
 
 	if(n == 0)
 	{
+		double mjd;
+
 		// assume this is mjd
-		mjd = atof(value);
 		if(sscanf(value, "%lf", &mjd) != 1)
 		{
 			std::cerr << "Error: vex date is not in usable format: " << value << std::endl;
 
 			exit(EXIT_FAILURE);
 		}
+		t = VexTime(mjd);
 	}
 	else
 	{
@@ -366,18 +389,26 @@ double vexDate(char *value)
 			exit(EXIT_FAILURE);
 		}
 
-		mjd = DOYtoMJD( static_cast<int>(floor(years+0.1)), static_cast<int>(floor(days+0.1)) ) + hours/24.0 + minutes/1440.0 + seconds/86400.0;
+		t = VexTime(DOYtoMJD( static_cast<int>(floor(years+0.1)), static_cast<int>(floor(days+0.1)) ), 0);
+		t.addSeconds(hours*3600.0 + minutes*60.0);
+		t.addSeconds(seconds);
 	}
 
-	return mjd;
+	return t;
+}
+
+double vexDate(char *value)
+{
+	return vexTime(value).mjd();
 }
 
 /* Gets extensions from the $GLOBAL block */
 static int getExtensions(VexData *V, Vex *v)
 {
+	struct vex_cursor cursor;
 	int nWarn = 0;
 
-	for(void *p = get_global_lowl(T_EXTENSION, B_EXTENSIONS, v); p; p = get_global_lowl_next())
+	for(void *p = get_global_lowl_r(&cursor, T_EXTENSION, B_EXTENSIONS, v); p; p = get_global_lowl_next_r(&cursor))
 	{
 		char *value, *units;
 		int name, link;
@@ -412,13 +443,15 @@ static int getExtensions(VexData *V, Vex *v)
 
 static int getAntennas(VexData *V, Vex *v)
 {
+	struct vex_cursor stationCursor;
+	struct vex_cursor cursor;
 	struct dvalue *r;
 	llist *block;
 	int nWarn = 0;
 
-	block = find_block(B_CLOCK, v);
+	block = find_block_r(B_CLOCK, v);
 
-	for(char *stn = get_station_def(v); stn; stn=get_station_def_next())
+	for(char *stn = get_station_def_r(&stationCursor, v); stn; stn=get_station_def_next_r(&stationCursor))
 	{
 		struct site_position *p;
 		struct axis_type *q;
@@ -435,7 +468,7 @@ static int getAntennas(VexData *V, Vex *v)
 		Upper(A->name);
 		A->difxName = A->name;
 
-		s = (struct site_id *)get_station_lowl(stn, T_SITE_ID, B_SITE, v);
+		s = (struct site_id *)get_station_lowl_r(&cursor, stn, T_SITE_ID, B_SITE, v);
 		if(s != 0)
 		{
 			if(s->code2)
@@ -448,7 +481,7 @@ static int getAntennas(VexData *V, Vex *v)
 			}
 		}
 
-		p = (struct site_position *)get_station_lowl(stn, T_SITE_POSITION, B_SITE, v);
+		p = (struct site_position *)get_station_lowl_r(&cursor, stn, T_SITE_POSITION, B_SITE, v);
 		if(p == 0)
 		{
 			std::cerr << "Warning: cannot find site position for antenna " << antName << " in the vex file." << std::endl;
@@ -461,7 +494,7 @@ static int getAntennas(VexData *V, Vex *v)
 			fvex_double(&(p->z->value), &(p->z->units), &A->z);
 		}
 
-		p = (struct site_position *)get_station_lowl(stn, T_SITE_VELOCITY, B_SITE, v);
+		p = (struct site_position *)get_station_lowl_r(&cursor, stn, T_SITE_VELOCITY, B_SITE, v);
 		if(p)
 		{
 			fvex_double(&(p->x->value), &(p->x->units), &A->dx);
@@ -473,7 +506,7 @@ static int getAntennas(VexData *V, Vex *v)
 			A->dx = A->dy = A->dz = 0.0;
 		}
 
-		q = (struct axis_type *)get_station_lowl(stn, T_AXIS_TYPE, B_ANTENNA, v);
+		q = (struct axis_type *)get_station_lowl_r(&cursor, stn, T_AXIS_TYPE, B_ANTENNA, v);
 		if(q == 0)
 		{
 			std::cerr << "Warning: cannot find axis type for antenna " << antName << " in the vex file." << std::endl;
@@ -488,7 +521,7 @@ static int getAntennas(VexData *V, Vex *v)
 			}
 		}
 
-		for(n = (struct nasmyth *)get_station_lowl(stn, T_NASMYTH, B_ANTENNA, v); n != 0; n = (struct nasmyth *)get_station_lowl_next())
+		for(n = (struct nasmyth *)get_station_lowl_r(&cursor, stn, T_NASMYTH, B_ANTENNA, v); n != 0; n = (struct nasmyth *)get_station_lowl_next_r(&cursor))
 		{
 			if(n)
 			{
@@ -507,7 +540,7 @@ static int getAntennas(VexData *V, Vex *v)
 			}
 		}
 
-		r = (struct dvalue *)get_station_lowl(stn, T_SITE_POSITION_EPOCH, B_SITE, v);
+		r = (struct dvalue *)get_station_lowl_r(&cursor, stn, T_SITE_POSITION_EPOCH, B_SITE, v);
 		if(r)
 		{
 			char *value, *units;
@@ -522,7 +555,7 @@ static int getAntennas(VexData *V, Vex *v)
 			A->posEpoch = 0.0;
 		}
 
-		r = (struct dvalue *)get_station_lowl(stn, T_AXIS_OFFSET, B_ANTENNA, v);
+		r = (struct dvalue *)get_station_lowl_r(&cursor, stn, T_AXIS_OFFSET, B_ANTENNA, v);
 		if(r == 0)
 		{
 			std::cerr << "Warning: cannot find axis offset for antenna " << antName << " in the vex file." << std::endl;
@@ -532,7 +565,7 @@ static int getAntennas(VexData *V, Vex *v)
 			fvex_double(&(r->value), &(r->units), &A->axisOffset);
 		}
 
-		for(void *c = get_station_lowl(stn, T_CLOCK_EARLY, B_CLOCK, v); c; c = get_station_lowl_next())
+		for(void *c = get_station_lowl_r(&cursor, stn, T_CLOCK_EARLY, B_CLOCK, v); c; c = get_station_lowl_next_r(&cursor))
 		{
 			char *value, *units;
 			int name, link;
@@ -611,11 +644,7 @@ static int getAntennas(VexData *V, Vex *v)
 		{
 			Llist *defs;
 			
-			defs = ((struct block *)block->ptr)->items;
-			if(defs)
-			{
-				defs = find_def(defs, stn);
-			}
+			defs = find_def_r(B_CLOCK, stn, v);
 			if(defs)
 			{
 				for(Llist *lowls = find_lowl(((Def *)((Lowl *)defs->ptr)->item)->refs, T_CLOCK_EARLY); lowls; lowls = lowls->next)
@@ -675,7 +704,7 @@ static int getAntennas(VexData *V, Vex *v)
 				}
 			}
 		}
-		for(void *p = get_station_lowl(stn, T_EXTENSION, B_EXTENSIONS, v); p; p = get_station_lowl_next())
+		for(void *p = get_station_lowl_r(&cursor, stn, T_EXTENSION, B_EXTENSIONS, v); p; p = get_station_lowl_next_r(&cursor))
 		{
 			char *value, *units;
 			int name, link;
@@ -711,9 +740,11 @@ static int getAntennas(VexData *V, Vex *v)
 
 static int getSources(VexData *V, Vex *v)
 {
+	struct vex_cursor sourceCursor;
+	struct vex_cursor cursor;
 	int nWarn = 0;
 	
-	for(char *src = get_source_def(v); src; src=get_source_def_next())
+	for(char *src = get_source_def_r(&sourceCursor, v); src; src=get_source_def_next_r(&sourceCursor))
 	{
 		VexSource *S;
 		char *p;
@@ -726,7 +757,7 @@ static int getSources(VexData *V, Vex *v)
 			++nWarn;
 		}
 
-		for(p = (char *)get_source_lowl(src, T_SOURCE_NAME, v); p; p = (char *)get_source_lowl_next())
+		for(p = (char *)get_source_lowl_r(&cursor, src, T_SOURCE_NAME, v); p; p = (char *)get_source_lowl_next_r(&cursor))
 		{
 			S->sourceNames.push_back(std::string(p));
 			if(strlen(p) > VexSource::MAX_SRCNAME_LENGTH)
@@ -736,7 +767,7 @@ static int getSources(VexData *V, Vex *v)
 			}
 		}
 
-		p = (char *)get_source_lowl(src, T_SOURCE_TYPE, v);
+		p = (char *)get_source_lowl_r(&cursor, src, T_SOURCE_TYPE, v);
 		if(p)
 		{
 			int link, name;
@@ -760,12 +791,12 @@ static int getSources(VexData *V, Vex *v)
 					void *p2;
 
 					arg1 = arg2 = 0;
-					p2 = get_source_lowl(src, T_BSP_FILE_NAME, v);
+					p2 = get_source_lowl_r(&cursor, src, T_BSP_FILE_NAME, v);
 					if(p2)
 					{
 						vex_field(T_BSP_FILE_NAME, p2, 1, &link, &name, &arg1, &units);
 					}
-					p2 = get_source_lowl(src, T_BSP_OBJECT_ID, v);
+					p2 = get_source_lowl_r(&cursor, src, T_BSP_OBJECT_ID, v);
 					if(p2)
 					{
 						vex_field(T_BSP_OBJECT_ID, p2, 1, &link, &name, &arg2, &units);
@@ -788,17 +819,17 @@ static int getSources(VexData *V, Vex *v)
 					char *arg0 = 0;
 
 					arg1 = arg2 = 0;
-					p2 = get_source_lowl(src, T_TLE0, v);
+					p2 = get_source_lowl_r(&cursor, src, T_TLE0, v);
 					if(p2)
 					{
 						vex_field(T_TLE0, p2, 1, &link, &name, &arg0, &units);
 					}
-					p2 = get_source_lowl(src, T_TLE1, v);
+					p2 = get_source_lowl_r(&cursor, src, T_TLE1, v);
 					if(p2)
 					{
 						vex_field(T_TLE1, p2, 1, &link, &name, &arg1, &units);
 					}
-					p2 = get_source_lowl(src, T_TLE2, v);
+					p2 = get_source_lowl_r(&cursor, src, T_TLE2, v);
 					if(p2)
 					{
 						vex_field(T_TLE2, p2, 1, &link, &name, &arg2, &units);
@@ -834,7 +865,7 @@ static int getSources(VexData *V, Vex *v)
 
 		if(S->type == VexSource::Star)
 		{
-			p = (char *)get_source_lowl(src, T_RA, v);
+			p = (char *)get_source_lowl_r(&cursor, src, T_RA, v);
 			if(!p)
 			{
 				std::cerr << "Error: Cannot find right ascension for source " << src << std::endl;
@@ -843,7 +874,7 @@ static int getSources(VexData *V, Vex *v)
 			}
 			fvex_ra(&p, &S->ra);
 
-			p = (char *)get_source_lowl(src, T_DEC, v);
+			p = (char *)get_source_lowl_r(&cursor, src, T_DEC, v);
 			if(!p)
 			{
 				std::cerr << "Error: Cannot find declination for source " << src << std::endl;
@@ -861,7 +892,7 @@ static int getSources(VexData *V, Vex *v)
 			++nWarn;
 		}
 
-		p = (char *)get_source_lowl(src, T_REF_COORD_FRAME, v);
+		p = (char *)get_source_lowl_r(&cursor, src, T_REF_COORD_FRAME, v);
 		if(!p)
 		{
 			std::cerr << "Warning: Cannot find ref coord frame for source " << src << " .  Assuming J2000." << std::endl;
@@ -879,18 +910,48 @@ static int getSources(VexData *V, Vex *v)
 	return nWarn;
 }
 
+// Interns the names of all antennas in all scans in alphabetical order, so that iterating
+// over a scan's stations by id visits them in name order
+static void internScanStations(VexData *V, Vex *v)
+{
+	struct vex_cursor scanCursor;
+	struct vex_cursor cursor;
+	std::set<std::string> stationNames;
+	char *scanId;
+
+	for(Llist *L = (Llist *)get_scan_r(&scanCursor, &scanId, v); L != 0; L = (Llist *)get_scan_next_r(&scanCursor, &scanId))
+	{
+		for(void *p = get_station_scan_r(&cursor, L); p; p = get_station_scan_next_r(&cursor))
+		{
+			int link, name;
+			char *stn, *units;
+
+			vex_field(T_STATION, p, 1, &link, &name, &stn, &units);
+			std::string stationName(stn);
+			Upper(stationName);
+			stationNames.insert(stationName);
+		}
+	}
+	for(std::set<std::string>::const_iterator it = stationNames.begin(); it != stationNames.end(); ++it)
+	{
+		V->internStation(*it);
+	}
+}
+
 static int getScans(VexData *V, Vex *v)
 {
+	struct vex_cursor scanCursor;
+	struct vex_cursor cursor;
 	char *scanId;
 	int nWarn = 0;
 
-	for(Llist *L = (Llist *)get_scan(&scanId, v); L != 0; L = (Llist *)get_scan_next(&scanId))
+	internScanStations(V, v);
+
+	for(Llist *L = (Llist *)get_scan_r(&scanCursor, &scanId, v); L != 0; L = (Llist *)get_scan_next_r(&scanCursor, &scanId))
 	{
 		VexScan *S;
-		std::map<std::string,bool> recordEnable;
-		std::map<std::string,Interval> stations;
-		double startScan, stopScan;
-		double mjd;
+		VexTime startScan, stopScan;
+		VexTime mjd;
 		int link, name;
 		char *value, *units;
 		void *p;
@@ -898,8 +959,6 @@ static int getScans(VexData *V, Vex *v)
 		std::string tmpIntent;
 		std::string sourceDefName;
 
-		stations.clear();
-		recordEnable.clear();
 		sourceDefName.clear();
 
 		Llist *lowls = L;
@@ -931,13 +990,18 @@ static int getScans(VexData *V, Vex *v)
 		p = get_scan_start(L);
 
 		vex_field(T_START, p, 1, &link, &name, &value, &units);
-		mjd = vexDate(value);
-		startScan = 1e99;
+		mjd = vexTime(value);
+		startScan = VexTime(1000000000, 0);	// later than any scan
 		stopScan = 0.0;
-		for(p = get_station_scan(L); p; p = get_station_scan_next())
+
+		// Make scan
+		S = V->newScan();
+
+		for(p = get_station_scan_r(&cursor, L); p; p = get_station_scan_next_r(&cursor))
 		{
 			std::string stationName;
-			double startAnt, stopAnt;
+			double startOffset, stopOffset;
+			VexTime startAnt, stopAnt;
 			char *stn;
 			
 			vex_field(T_STATION, p, 1, &link, &name, &stn, &units);
@@ -945,41 +1009,37 @@ static int getScans(VexData *V, Vex *v)
 			Upper(stationName);
 
 			vex_field(T_STATION, p, 2, &link, &name, &value, &units);
-			fvex_double(&value, &units, &startAnt);
-			startAnt = mjd + startAnt/86400.0;	// mjd of antenna start
+			fvex_double(&value, &units, &startOffset);
+			startAnt = mjd;
+			startAnt.addSeconds(startOffset);	// mjd of antenna start
 			if(startAnt < startScan)
 			{
 				startScan = startAnt;
 			}
 
 			vex_field(T_STATION, p, 3, &link, &name, &value, &units);
-			fvex_double(&value, &units, &stopAnt);
-			stopAnt = mjd + stopAnt/86400.0;	// mjd of antenna stop
+			fvex_double(&value, &units, &stopOffset);
+			stopAnt = mjd;
+			stopAnt.addSeconds(stopOffset);		// mjd of antenna stop
 			if(stopAnt > stopScan)
 			{
 				stopScan = stopAnt;
 			}
 
 			vex_field(T_STATION, p, 7, &link, &name, &value, &units);
-			recordEnable[stationName] = (atoi(value) > 0);
-
-			stations[stationName] = Interval(startAnt, stopAnt);
+			S->setStation(V->internStation(stationName), Interval(startAnt, stopAnt), (atoi(value) > 0));
 		}
 
 		std::string scanDefName(scanId);
 		std::string modeDefName((char *)get_scan_mode(L));
 
-		// Make scan
-		S = V->newScan();
 		S->setTimeRange(Interval(startScan, stopScan));
 		S->defName = scanDefName;
-		S->stations = stations;
-		S->recordEnable = recordEnable;
 		S->modeDefName = modeDefName;
 		S->intent = intent;
 		S->mjdVex = mjd;
 
-		for(p = get_scan_source2(L); p; p = get_scan_source2_next())
+		for(p = get_scan_source2_r(&cursor, L); p; p = get_scan_source2_next_r(&cursor))
 		{
 			bool point;
 			bool corr;
@@ -1033,7 +1093,7 @@ static int getScans(VexData *V, Vex *v)
 		}
 
 		// capture intents
-		for(p = get_scan_intent(L); p; p = get_scan_intent_next())
+		for(p = get_scan_intent_r(&cursor, L); p; p = get_scan_intent_next_r(&cursor))
 		{
 			char *src;
 			char *id;
@@ -1055,35 +1115,36 @@ static int getScans(VexData *V, Vex *v)
 	return nWarn;
 }
 
-static VexSetup::SetupType getSetupType(Vex *v, std::string &format, const char *antDefName, const char *modeDefName)
+static VexSetup::SetupType getSetupType(Vex *v, std::string &format, const char *antDefName, const char *modeDefName, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	void *trackFormat;
 
 	format = "";
 
 	// Look for things needed for all kinds of modes
-	if(get_all_lowl(antDefName, modeDefName, T_IF_DEF, B_IF, v) == 0 ||
-	   get_all_lowl(antDefName, modeDefName, T_BBC_ASSIGN, B_BBC, v) == 0 ||
-	   get_all_lowl(antDefName, modeDefName, T_CHAN_DEF, B_FREQ, v) == 0)
+	if(get_all_lowl_r(&cursor, antDefName, modeDefName, T_IF_DEF, B_IF, v) == 0 ||
+	   get_all_lowl_r(&cursor, antDefName, modeDefName, T_BBC_ASSIGN, B_BBC, v) == 0 ||
+	   get_all_lowl_r(&cursor, antDefName, modeDefName, T_CHAN_DEF, B_FREQ, v) == 0)
 	{
 		return VexSetup::SetupIncomplete;
 	}
 
-	if(get_all_lowl(antDefName, modeDefName, T_STREAM_DEF, B_BITSTREAMS, v))
+	if(get_all_lowl_r(&cursor, antDefName, modeDefName, T_STREAM_DEF, B_BITSTREAMS, v))
 	{
 		// looks like bitstream; make sure supporting defs are in place
 
 		return VexSetup::SetupBitstreams;
 	}
-	else if(get_all_lowl(antDefName, modeDefName, T_MERGED_DATASTREAM, B_DATASTREAMS, v))
+	else if(get_all_lowl_r(&cursor, antDefName, modeDefName, T_MERGED_DATASTREAM, B_DATASTREAMS, v))
 	{
 		return VexSetup::SetupMergedDatastreams;
 	}
-	else if(get_all_lowl(antDefName, modeDefName, T_DATASTREAM, B_DATASTREAMS, v))
+	else if(get_all_lowl_r(&cursor, antDefName, modeDefName, T_DATASTREAM, B_DATASTREAMS, v))
 	{
 		return VexSetup::SetupDatastreams;
 	}
-	else if((trackFormat = get_all_lowl(antDefName, modeDefName, T_TRACK_FRAME_FORMAT, B_TRACKS, v)) != 0)
+	else if((trackFormat = get_all_lowl_r(&cursor, antDefName, modeDefName, T_TRACK_FRAME_FORMAT, B_TRACKS, v)) != 0)
 	{
 		int link, name;
 		char *value, *units;
@@ -1093,14 +1154,14 @@ static VexSetup::SetupType getSetupType(Vex *v, std::string &format, const char
 		{
 			format = value;
 		}
-		if(get_all_lowl(antDefName, modeDefName, T_S2_RECORDING_MODE, B_TRACKS, v))
+		if(get_all_lowl_r(&cursor, antDefName, modeDefName, T_S2_RECORDING_MODE, B_TRACKS, v))
 		{
-			std::cerr << "Note: Both track frame format and s2 recording mode were specified.  S2 information will be ignored." << std::endl;
+			log << "Note: Both track frame format and s2 recording mode were specified.  S2 information will be ignored." << std::endl;
 		}
 
 		return VexSetup::SetupTracks;
 	}
-	else if(get_all_lowl(antDefName, modeDefName, T_S2_RECORDING_MODE, B_TRACKS, v))
+	else if(get_all_lowl_r(&cursor, antDefName, modeDefName, T_S2_RECORDING_MODE, B_TRACKS, v))
 	{
 		return VexSetup::SetupS2;
 	}
@@ -1108,8 +1169,9 @@ static VexSetup::SetupType getSetupType(Vex *v, std::string &format, const char
 	return VexSetup::SetupIncomplete;
 }
 
-static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDefName, const char *modeDefName)
+static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDefName, const char *modeDefName, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	int nWarn = 0;
 	void *p2array[MAX_IF];
 	int p2count = 0;
@@ -1119,7 +1181,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		p2array[i] = 0;
 	}
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_IF_DEF, B_IF, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_IF_DEF, B_IF, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		double phaseCal, phaseCalBase;
 		int link, name;
@@ -1183,7 +1245,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		}
 		else
 		{
-			std::cerr << "Warning: Unsupported pulse cal interval of " << (phaseCal/1000000.0) << " MHz requested for antenna " << antDefName << "." << std::endl;
+			log << "Warning: Unsupported pulse cal interval of " << (phaseCal/1000000.0) << " MHz requested for antenna " << antDefName << "." << std::endl;
 			++nWarn;
 			vif.phaseCalIntervalMHz = static_cast<float>(phaseCal/1000000.0);
 		}
@@ -1207,9 +1269,9 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 
 		if(p2count >= MAX_IF)
 		{
-			std::cerr << "Developer error: Value of MAX_IF is too small in vexload.cpp, instance 2" << std::endl;
+			log << "Developer error: Value of MAX_IF is too small in vexload.cpp, instance 2" << std::endl;
 
-			exit(0);
+			failModeSetup(0);
 		}
 		p2 = p2array[p2count++];
 
@@ -1225,7 +1287,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		}
 	}
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_RECEIVER_NAME, B_IF, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_RECEIVER_NAME, B_IF, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		int link, name;
 		char *value, *units;
@@ -1235,8 +1297,8 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 
 		if(vif == 0)
 		{
-			std::cerr << "Warning: IF receiver name line provided with link " << value << " that is not defined in setup:" << std::endl;
-			std::cerr << "  " << setup << std::endl;
+			log << "Warning: IF receiver name line provided with link " << value << " that is not defined in setup:" << std::endl;
+			log << "  " << setup << std::endl;
 
 			++nWarn;
 		}
@@ -1250,7 +1312,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		}
 	}
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_SUB_LO_FREQUENCIES, B_IF, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_SUB_LO_FREQUENCIES, B_IF, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		int link, name;
 		char *value, *units;
@@ -1259,8 +1321,8 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		VexIF *vif = setup.getVexIFByLink(value);
 		if(vif == 0)
 		{
-			std::cerr << "Warning: IF sub LO frequencies line provided with link " << value << " that is not defined in setup:" << std::endl;
-			std::cerr << "  " << setup << std::endl;
+			log << "Warning: IF sub LO frequencies line provided with link " << value << " that is not defined in setup:" << std::endl;
+			log << "  " << setup << std::endl;
 
 			++nWarn;
 		}
@@ -1278,7 +1340,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		}
 	}
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_SUB_LO_SIDEBANDS, B_IF, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_SUB_LO_SIDEBANDS, B_IF, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		int link, name;
 		char *value, *units;
@@ -1287,8 +1349,8 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		VexIF *vif = setup.getVexIFByLink(value);
 		if(vif == 0)
 		{
-			std::cerr << "Warning: IF sub LO frequencies line provided with link " << value << " that is not defined in setup:" << std::endl;
-			std::cerr << "  " << setup << std::endl;
+			log << "Warning: IF sub LO frequencies line provided with link " << value << " that is not defined in setup:" << std::endl;
+			log << "  " << setup << std::endl;
 
 			++nWarn;
 		}
@@ -1316,7 +1378,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 				}
 				else if(sb != 'R')
 				{
-					std::cerr << "Warning: IF sub LO sideband with value " << value << " was provided.  This is not supported.  Assuming upper sideband." << std::endl;
+					log << "Warning: IF sub LO sideband with value " << value << " was provided.  This is not supported.  Assuming upper sideband." << std::endl;
 
 					++nWarn;
 				}
@@ -1325,7 +1387,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		}
 	}
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_SWITCHED_POWER, B_IF, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_SWITCHED_POWER, B_IF, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		int link, name;
 		char *value, *units;
@@ -1334,8 +1396,8 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 		VexIF *vif = setup.getVexIFByLink(value);
 		if(vif == 0)
 		{
-			std::cerr << "Warning: IF sub LO frequencies line provided with link " << value << " that is not defined in setup:" << std::endl;
-			std::cerr << "  " << setup << std::endl;
+			log << "Warning: IF sub LO frequencies line provided with link " << value << " that is not defined in setup:" << std::endl;
+			log << "  " << setup << std::endl;
 
 			++nWarn;
 		}
@@ -1347,7 +1409,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 				vif->spAmp = stringToSwitchedPowerAmplitude(value);
 				if(vif->spAmp == VexIF::SP_error)
 				{
-					std::cerr << "Warning: IF switched power amplitude setting, '" << value << "', is not one of those supported: 'Off', 'Low' and 'High'.  Ignoring." << std::endl;
+					log << "Warning: IF switched power amplitude setting, '" << value << "', is not one of those supported: 'Off', 'Low' and 'High'.  Ignoring." << std::endl;
 					vif->spAmp = VexIF::SP_unset;
 					
 					++nWarn;
@@ -1360,7 +1422,7 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 			}
 			else
 			{
-				std::cerr << "Warning: IF switched power statement does not specify amplitude.  Ignoring." << std::endl;
+				log << "Warning: IF switched power statement does not specify amplitude.  Ignoring." << std::endl;
 			}
 		}
 	}
@@ -1369,13 +1431,14 @@ static int collectIFInfo(VexSetup &setup, VexData *V, Vex *v, const char *antDef
 }
 
 // FIXME: common code for pulse cal info
-static int collectPcalInfo(std::map<std::string,std::vector<unsigned int> > &pcalMap, VexData *V, Vex *v, const char *antDefName, const char *modeDefName)
+static int collectPcalInfo(std::map<std::string,std::vector<unsigned int> > &pcalMap, VexData *V, Vex *v, const char *antDefName, const char *modeDefName, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	int nWarn = 0;
 
 	pcalMap.clear();
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_PHASE_CAL_DETECT, B_PHASE_CAL_DETECT, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_PHASE_CAL_DETECT, B_PHASE_CAL_DETECT, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		int link, name;
 		char *value, *units;
@@ -1413,8 +1476,9 @@ static int collectPcalInfo(std::map<std::string,std::vector<unsigned int> > &pca
 }
 
 // collect channel information from a $FREQ section
-int collectFreqChannels(std::vector<VexChannel> &freqChannels, VexSetup &setup, VexMode &mode, Vex *v, const char *antDefName, const char *modeDefName)
+int collectFreqChannels(std::vector<VexChannel> &freqChannels, VexSetup &setup, VexMode &mode, Vex *v, const char *antDefName, const char *modeDefName, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	int nWarn = 0;
 	std::map<std::string,char> bbc2pol;
 	std::map<std::string,std::string> bbc2ifLink;
@@ -1422,17 +1486,17 @@ int collectFreqChannels(std::vector<VexChannel> &freqChannels, VexSetup &setup,
 	char *value, *units;
 
 	// Get BBC to pol map; only needed to complete the frequency channel info
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_BBC_ASSIGN, B_BBC, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_BBC_ASSIGN, B_BBC, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		vex_field(T_BBC_ASSIGN, p, 3, &link, &name, &value, &units);
 		VexIF *vif = setup.getVexIFByLink(value);
 
 		if(vif == 0)
 		{
-			std::cerr << "Error: mode=" << modeDefName << " antenna=" << antDefName << " cannot find ifLink " << value << " in setup structure:" << std::endl;
-			std::cerr << "Setup = " << setup << std::endl;
+			log << "Error: mode=" << modeDefName << " antenna=" << antDefName << " cannot find ifLink " << value << " in setup structure:" << std::endl;
+			log << "Setup = " << setup << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		vex_field(T_BBC_ASSIGN, p, 1, &link, &name, &value, &units);
 		bbc2pol[value] = vif->pol;
@@ -1441,7 +1505,7 @@ int collectFreqChannels(std::vector<VexChannel> &freqChannels, VexSetup &setup,
 
 	freqChannels.clear();
 
-	for(void *p = get_all_lowl(antDefName, modeDefName, T_CHAN_DEF, B_FREQ, v); p; p = get_all_lowl_next())
+	for(void *p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_CHAN_DEF, B_FREQ, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		int subbandId;
 		char *bbcName;
@@ -1513,11 +1577,12 @@ int collectFreqChannels(std::vector<VexChannel> &freqChannels, VexSetup &setup,
 	return nWarn;
 }
 
-static int collectExtensions(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName)
+static int collectExtensions(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	int nWarn = 0;
 
-	for(void *p = get_mode_lowl(antDefName, modeDefName, T_EXTENSION, B_EXTENSIONS, v); p; p = get_mode_lowl_next())
+	for(void *p = get_mode_lowl_r(&cursor, antDefName, modeDefName, T_EXTENSION, B_EXTENSIONS, v); p; p = get_mode_lowl_next_r(&cursor))
 	{
 		char *value, *units;
 		int name, link;
@@ -1568,8 +1633,9 @@ bool cmpRecChan(const VexChannel &a, const VexChannel &b)
 	return (a.recordChan < b.recordChan);
 }
 
-static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format)
+static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	VexStream &stream = setup.streams[0];	// the first stream is created by default
 	int nWarn = 0;
 	int link, name;
@@ -1578,14 +1644,14 @@ static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const cha
 	std::map<std::string,BitAssignments> ch2tracks;		// indexed by channel link
 	int nBit = 1;
 
-	p = get_all_lowl(antDefName, modeDefName, T_SAMPLE_RATE, B_FREQ, v);
+	p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_SAMPLE_RATE, B_FREQ, v);
 	if(p)
 	{
 		vex_field(T_SAMPLE_RATE, p, 1, &link, &name, &value, &units);
 		fvex_double(&value, &units, &stream.sampRate);
 	}
 
-	q = get_all_lowl(antDefName, modeDefName, T_S2_RECORDING_MODE, B_TRACKS, v);
+	q = get_all_lowl_r(&cursor, antDefName, modeDefName, T_S2_RECORDING_MODE, B_TRACKS, v);
 
 	vex_field(T_S2_RECORDING_MODE, q, 1, &link, &name, &value, &units);
 	std::string s2mode(value);
@@ -1596,12 +1662,12 @@ static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const cha
 		//   S2_data_source = VLBA or S2_data_source = LBAVSOP  --> format = VexStream::FormatLBAVSOP
 		//   S2_data_source = LBASTD                            --> format = VexStream::FormatLBASTD
 
-		q = get_all_lowl(antDefName, modeDefName, T_S2_DATA_SOURCE, B_TRACKS, v);
+		q = get_all_lowl_r(&cursor, antDefName, modeDefName, T_S2_DATA_SOURCE, B_TRACKS, v);
 		if(!q)
 		{
-			std::cerr << "Error: S2 mode is 'none' but no S2 Data Source is provided" << std::endl;
+			log << "Error: S2 mode is 'none' but no S2 Data Source is provided" << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		vex_field(T_S2_DATA_SOURCE, q, 1, &link, &name, &value, &units);
 		std::string s2datasource(value);
@@ -1616,19 +1682,19 @@ static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const cha
 		}
 		else
 		{
-			std::cerr << "Error: unknown data mode: s2_recording_mode = none and s2_data_source = " << s2datasource << " for antenna " << antDefName << ".  S2_data_source should be one of VLBA, LBAVSOP or LBASTD in this case." << std::endl;
+			log << "Error: unknown data mode: s2_recording_mode = none and s2_data_source = " << s2datasource << " for antenna " << antDefName << ".  S2_data_source should be one of VLBA, LBAVSOP or LBASTD in this case." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 	}
 	else
 	{
-		std::cerr << "Error: S2 track formats are no longer supported." << std::endl;
+		log << "Error: S2 track formats are no longer supported." << std::endl;
 
-		exit(EXIT_FAILURE);
+		failModeSetup(EXIT_FAILURE);
 	}
 
-	for(p = get_all_lowl(antDefName, modeDefName, T_FANOUT_DEF, B_TRACKS, v); p; p = get_all_lowl_next())
+	for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_FANOUT_DEF, B_TRACKS, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		std::string chanLink;
 		bool sign;
@@ -1672,15 +1738,15 @@ static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const cha
 		setup.channels.push_back(*it);
 		VexChannel &channel = setup.channels.back();
 
-		recChanId = getRecordChannelFromTracks(antDefName, it->chanLink, ch2tracks, stream, nRecordChan);
+		recChanId = getRecordChannelFromTracks(antDefName, it->chanLink, ch2tracks, stream, nRecordChan, log);
 		if(recChanId >= 0)
 		{
 			if(channel.bbcBandwidth - stream.sampRate/2 > 1e-6)
 			{
-				std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream.sampRate << " bandwidth = " << channel.bbcBandwidth << std::endl;
-				std::cerr << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
+				log << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream.sampRate << " bandwidth = " << channel.bbcBandwidth << std::endl;
+				log << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 
 			if(channel.bbcBandwidth - stream.sampRate/2 < -1e-6)
@@ -1709,8 +1775,9 @@ static int getS2Setup(VexSetup &setup, Vex *v, const char *antDefName, const cha
 	return nWarn;
 }
 
-static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format)
+static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	VexStream &stream = setup.streams[0];	// the first stream is created by default
 	int nWarn = 0;
 	int link, name;
@@ -1720,7 +1787,7 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 	int nBit = 1;
 	int nTrack = 0;
 
-	p = get_all_lowl(antDefName, modeDefName, T_SAMPLE_RATE, B_FREQ, v);
+	p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_SAMPLE_RATE, B_FREQ, v);
 	if(p)
 	{
 		vex_field(T_SAMPLE_RATE, p, 1, &link, &name, &value, &units);
@@ -1733,7 +1800,7 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 	{
 		// FIXME: This if() block may not be needed.  Perhaps watermark this and delete section if nobody reports its use by year 2025
 
-		for(p = get_all_lowl(antDefName, modeDefName, T_FANOUT_DEF, B_TRACKS, v); p; p = get_all_lowl_next())
+		for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_FANOUT_DEF, B_TRACKS, v); p; p = get_all_lowl_next_r(&cursor))
 		{
 			std::string chanLink;
 			bool sign;
@@ -1767,7 +1834,7 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 	}
 	else
 	{
-		for(p = get_all_lowl(antDefName, modeDefName, T_FANOUT_DEF, B_TRACKS, v); p; p = get_all_lowl_next())
+		for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_FANOUT_DEF, B_TRACKS, v); p; p = get_all_lowl_next_r(&cursor))
 		{
 			std::string chanLink;
 			bool sign;
@@ -1836,7 +1903,7 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 	if(stream.format == VexStream::FormatMark5B || stream.format == VexStream::FormatKVN5B)
 	{
 		// Because Mark5B formatters can apply a bitmask, the track numbers may not be contiguous.  Here we go through and reorder track numbers in sequence, starting with 2
-		reorderBitAssignments(ch2tracks, 2);
+		reorderBitAssignments(ch2tracks, 2, log);
 	}
 
 	// Generate channels
@@ -1849,15 +1916,15 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 		setup.channels.push_back(*it);
 		VexChannel &channel = setup.channels.back();
 
-		recChanId = getRecordChannelFromTracks(antDefName, it->chanLink, ch2tracks, stream, nRecordChan);
+		recChanId = getRecordChannelFromTracks(antDefName, it->chanLink, ch2tracks, stream, nRecordChan, log);
 		if(recChanId >= 0)
 		{
 			if(channel.bbcBandwidth - stream.sampRate/2 > 1e-6)
 			{
-				std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream.sampRate << " bandwidth = " << channel.bbcBandwidth << std::endl;
-				std::cerr << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
+				log << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream.sampRate << " bandwidth = " << channel.bbcBandwidth << std::endl;
+				log << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 
 			if(channel.bbcBandwidth - stream.sampRate/2 < -1e-6)
@@ -1883,9 +1950,9 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 			// Test that nThread divides into nRecordChan
 			if(nRecordChan % stream.nThread() != 0)
 			{
-				std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " number of threads (" << stream.nThread() << ") does not divide into number of record channels (" << nRecordChan << ")." << std::endl;
+				log << "Error: " << modeDefName << " antenna " << antDefName << " number of threads (" << stream.nThread() << ") does not divide into number of record channels (" << nRecordChan << ")." << std::endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 		}
 		stream.nRecordChan = nRecordChan;
@@ -1910,8 +1977,9 @@ static int getTracksSetup(VexSetup &setup, Vex *v, const char *antDefName, const
 	return nWarn;
 }
 
-static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format)
+static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	const int MaxBitstreams = 64;
 	VexStream &stream = setup.streams[0];	// the first stream is created by default
 	int nWarn = 0;
@@ -1922,7 +1990,7 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 	int nBit = 1;
 	int nBitstream = 0;
 
-	p = get_all_lowl(antDefName, modeDefName, T_STREAM_SAMPLE_RATE, B_BITSTREAMS, v);
+	p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_STREAM_SAMPLE_RATE, B_BITSTREAMS, v);
 	if(p)
 	{
 		vex_field(T_STREAM_SAMPLE_RATE, p, 1, &link, &name, &value, &units);
@@ -1934,11 +2002,11 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 	// Only Mark5B format is supported when using BITSTREAMS
 	if(stream.format != VexStream::FormatMark5B)
 	{
-		std::cerr << "Error: bitstream setup found, but format was " << format << " , but only Mark5B formats are supported." << std::endl;
-		exit(0);
+		log << "Error: bitstream setup found, but format was " << format << " , but only Mark5B formats are supported." << std::endl;
+		failModeSetup(0);
 	}
 
-	for(p = get_all_lowl(antDefName, modeDefName, T_STREAM_DEF, B_BITSTREAMS, v); p; p = get_all_lowl_next())
+	for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_STREAM_DEF, B_BITSTREAMS, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		std::string chanName;
 		bool sign;
@@ -1953,9 +2021,9 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 
 		if(bitstreamNum < 0 || bitstreamNum >= MaxBitstreams)
 		{
-			std::cerr << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << chanName << " has bitstream number out of range." << std::endl;
-			std::cerr << "  bitstream number was " << bitstreamNum << " but it must be in [0.." << (MaxBitstreams-1) << "] inclusive." << std::endl;
-			exit(0);
+			log << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << chanName << " has bitstream number out of range." << std::endl;
+			log << "  bitstream number was " << bitstreamNum << " but it must be in [0.." << (MaxBitstreams-1) << "] inclusive." << std::endl;
+			failModeSetup(0);
 		}
 
 		++nBitstream;
@@ -1971,8 +2039,8 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 	}
 	if(ch2bitstreams.empty())
 	{
-		std::cerr << "Error: Antenna " << antDefName << " Mode " << modeDefName << " has no bitstreams defined." << std::endl;
-		exit(0);
+		log << "Error: Antenna " << antDefName << " Mode " << modeDefName << " has no bitstreams defined." << std::endl;
+		failModeSetup(0);
 	}
 
 	stream.nBit = nBit;
@@ -1985,16 +2053,16 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 			const BitAssignments &ba = it->second;
 			if(ba.sign.size() != 1 || ba.mag.size() != 1)
 			{
-				std::cerr << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << it->first << " does not have exactly one sign and one mag bit assigned." << std::endl;
-				std::cerr << "  nSign = " << ba.sign.size() <<" nMag = " << ba.mag.size() << std::endl;
-				exit(0);
+				log << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << it->first << " does not have exactly one sign and one mag bit assigned." << std::endl;
+				log << "  nSign = " << ba.sign.size() <<" nMag = " << ba.mag.size() << std::endl;
+				failModeSetup(0);
 			}
 			else if(ba.mag[0] != ba.sign[0] + 1 || ba.sign[0] % 2 == 1)
 			{
-				std::cerr << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << it->first << " violates vex2difx's constraint on bit stream assignments." << std::endl;
-				std::cerr << "  2-bit data must have the sign bit on an even channel with the magnitude bit in the next bitstream." << std::endl;
-				std::cerr << "  Sign assignment = " << ba.sign[0] <<" Mag assignemnt = " << ba.mag[0] << std::endl;
-				exit(0);
+				log << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << it->first << " violates vex2difx's constraint on bit stream assignments." << std::endl;
+				log << "  2-bit data must have the sign bit on an even channel with the magnitude bit in the next bitstream." << std::endl;
+				log << "  Sign assignment = " << ba.sign[0] <<" Mag assignemnt = " << ba.mag[0] << std::endl;
+				failModeSetup(0);
 			}
 		}
 	}
@@ -2005,15 +2073,15 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 			const BitAssignments &ba = it->second;
 			if(ba.sign.size() != 1 || ba.mag.size() != 0)
 			{
-				std::cerr << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << it->first << " does not have exactly one sign and zero mag bit assigned." << std::endl;
-				std::cerr << "  nSign = " << ba.sign.size() <<" nMag = " << ba.mag.size() << std::endl;
-				exit(0);
+				log << "Error: Antenna " << antDefName << " Mode " << modeDefName << " Chan " << it->first << " does not have exactly one sign and zero mag bit assigned." << std::endl;
+				log << "  nSign = " << ba.sign.size() <<" nMag = " << ba.mag.size() << std::endl;
+				failModeSetup(0);
 			}
 		}
 	}
 
 	// Because Mark5B formatters can apply a bitmask, the track numbers may not be contiguous.  Here we go through and reorder track numbers in sequence, starting with 0
-	reorderBitAssignments(ch2bitstreams, 0);
+	reorderBitAssignments(ch2bitstreams, 0, log);
 
 	// Generate channels
 	unsigned int nRecordChan = 0;
@@ -2025,15 +2093,15 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 		setup.channels.push_back(*it);
 		VexChannel &channel = setup.channels.back();
 
-		recChanId = getRecordChannelFromBitstreams(antDefName, it->chanLink, ch2bitstreams, stream, nRecordChan);
+		recChanId = getRecordChannelFromBitstreams(antDefName, it->chanLink, ch2bitstreams, stream, nRecordChan, log);
 		if(recChanId >= 0)
 		{
 			if(channel.bbcBandwidth - stream.sampRate/2 > 1e-6)
 			{
-				std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream.sampRate << " bandwidth = " << channel.bbcBandwidth << std::endl;
-				std::cerr << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
+				log << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream.sampRate << " bandwidth = " << channel.bbcBandwidth << std::endl;
+				log << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 
 			if(channel.bbcBandwidth - stream.sampRate/2 < -1e-6)
@@ -2055,8 +2123,9 @@ static int getBitstreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, c
 	return nWarn;
 }
 
-static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format)
+static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName, const char *modeDefName, std::map<std::string,std::vector<unsigned int> > &pcalMap, std::vector<VexChannel> &freqChannels, const std::string &format, std::ostream &log)
 {
+	struct vex_cursor cursor;
 	int nWarn = 0;
 	int link, name;
 	char *value, *units;
@@ -2064,7 +2133,7 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 	int nStream = 0;	
 
 	// Loop over datastreams
-	for(p = get_all_lowl(antDefName, modeDefName, T_DATASTREAM, B_DATASTREAMS, v); p; p = get_all_lowl_next())
+	for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_DATASTREAM, B_DATASTREAMS, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		if(nStream > 0)
 		{
@@ -2076,18 +2145,18 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 		vex_field(T_DATASTREAM, p, 1, &link, &name, &value, &units);
 		if(!value)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : a datastream parameter lacks a link name." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : a datastream parameter lacks a link name." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		stream.streamLink = value;
 
 		vex_field(T_DATASTREAM, p, 2, &link, &name, &value, &units);
 		if(!value)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : datastream " << stream.streamLink << " lacks a data format specification." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : datastream " << stream.streamLink << " lacks a data format specification." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		if(strcasecmp(value, "VDIF") == 0)
 		{
@@ -2103,9 +2172,9 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 		}
 		else
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : datastream " << stream.streamLink << " has a data format specification that is not handled: " << value << " ." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : datastream " << stream.streamLink << " has a data format specification that is not handled: " << value << " ." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		stream.threads.clear();	// Just make sure these are left undefined; they will be completely defined in the code that follows
@@ -2120,7 +2189,7 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 	}
 
 	// Loop over threads
-	for(p = get_all_lowl(antDefName, modeDefName, T_THREAD, B_DATASTREAMS, v); p; p = get_all_lowl_next())
+	for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_THREAD, B_DATASTREAMS, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		VexStream *stream;
 		int threadId;
@@ -2128,25 +2197,25 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 		vex_field(T_THREAD, p, 1, &link, &name, &value, &units);
 		if(!value)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : a thread parameter lacks a datastream link." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : a thread parameter lacks a datastream link." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		stream = setup.getVexStreamByLink(value);
 		if(!stream)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : a thread parameter datastream link does not point to a datastream." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : a thread parameter datastream link does not point to a datastream." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		vex_field(T_THREAD, p, 3, &link, &name, &value, &units);
 		threadId = atoi(value);
 		if(find(stream->threads.begin(), stream->threads.end(), threadId) != stream->threads.end())
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : a duplicate thread number was encountered." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : a duplicate thread number was encountered." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		stream->threads.push_back(VexThread(threadId));
 		VexThread &T = stream->threads.back();
@@ -2170,9 +2239,9 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 		}
 		else if(stream->sampRate != T.sampRate)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : sample rate mismatch: " << stream->sampRate << " Hz != " << T.sampRate << " Hz." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : sample rate mismatch: " << stream->sampRate << " Hz != " << T.sampRate << " Hz." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		vex_field(T_THREAD, p, 6, &link, &name, &value, &units);
@@ -2183,9 +2252,9 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 		}
 		else if(stream->nBit != T.nBit)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : nBit mismatch: " << stream->nBit << " != " << T.nBit << " ." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : nBit mismatch: " << stream->nBit << " != " << T.nBit << " ." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		vex_field(T_THREAD, p, 7, &link, &name, &value, &units);
@@ -2205,9 +2274,9 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 			}
 			else
 			{
-				std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : data representation [" << value << "] is unrecognized.  Kegal values are 'real', 'complex' and 'complexDSV'." << std::endl;
+				log << "Error: " << modeDefName << " antenna " << antDefName << " : data representation [" << value << "] is unrecognized.  Kegal values are 'real', 'complex' and 'complexDSV'." << std::endl;
 
-				exit(EXIT_FAILURE);
+				failModeSetup(EXIT_FAILURE);
 			}
 		}
 
@@ -2238,7 +2307,7 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 	}
 
 	// Loop over channels
-	for(p = get_all_lowl(antDefName, modeDefName, T_CHANNEL, B_DATASTREAMS, v); p; p = get_all_lowl_next())
+	for(p = get_all_lowl_r(&cursor, antDefName, modeDefName, T_CHANNEL, B_DATASTREAMS, v); p; p = get_all_lowl_next_r(&cursor))
 	{
 		VexStream *stream;
 		VexThread *thread;
@@ -2249,67 +2318,67 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 		vex_field(T_CHANNEL, p, 1, &link, &name, &value, &units);
 		if(!value)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter without datastream link." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter without datastream link." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		stream = setup.getVexStreamByLink(value);
 		if(!stream)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter with datastream link that does not correspond: " << value << " ." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter with datastream link that does not correspond: " << value << " ." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		vex_field(T_CHANNEL, p, 2, &link, &name, &value, &units);
 		if(!value)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter without a thread link." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter without a thread link." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		thread = stream->getVexThreadByLink(value);
 		if(!thread)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter with a thread link that does not correspond: " << value << " ." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter with a thread link that does not correspond: " << value << " ." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		vex_field(T_CHANNEL, p, 3, &link, &name, &chanLink, &units);
 		if(!chanLink || chanLink[0] == 0)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter without channel link." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel parameter without channel link." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		vex_field(T_CHANNEL, p, 4, &link, &name, &value, &units);
 		if(!value)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel without thread number." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel without thread number." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 		threadChan = atoi(value);
 		if(threadChan < 0 || threadChan >= thread->nChan)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : has channel number," << threadChan << ", out of range [0.." << (thread->nChan-1) << "]." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : has channel number," << threadChan << ", out of range [0.." << (thread->nChan-1) << "]." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		channel = getVexChannelByLink(freqChannels, chanLink);
 		if(!channel)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " : referenced channel " << chanLink << " does not exist in $FREQ block." << std::endl;
-			std::cerr << "Freq block had the following entries:" << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " : referenced channel " << chanLink << " does not exist in $FREQ block." << std::endl;
+			log << "Freq block had the following entries:" << std::endl;
 			for(std::vector<VexChannel>::const_iterator it = freqChannels.begin(); it != freqChannels.end(); ++it)
 			{
-				std::cerr << "  " << *it << std::endl;
+				log << "  " << *it << std::endl;
 			}
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		setup.channels.push_back(*channel);
@@ -2317,10 +2386,10 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 
 		if(channel->bbcBandwidth - stream->sampRate/2 > 1e-6)
 		{
-			std::cerr << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream->sampRate << " bandwidth = " << channel->bbcBandwidth << " ." << std::endl;
-			std::cerr << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
+			log << "Error: " << modeDefName << " antenna " << antDefName << " has sample rate = " << stream->sampRate << " bandwidth = " << channel->bbcBandwidth << " ." << std::endl;
+			log << "Sample rate must be no less than twice the bandwidth in all cases." << std::endl;
 
-			exit(EXIT_FAILURE);
+			failModeSetup(EXIT_FAILURE);
 		}
 
 		if(channel->bbcBandwidth - stream->sampRate/2 < -1e-6)
@@ -2339,11 +2408,164 @@ static int getDatastreamsSetup(VexSetup &setup, Vex *v, const char *antDefName,
 	return nWarn;
 }
 
+// Results of setup extraction for one (mode, antenna) pair
+class ModeSetupTask
+{
+public:
+	ModeSetupTask() : nWarn(0), failed(false), exitStatus(0) {}
+
+	unsigned int modeNum;		// index into list of modes being loaded
+	std::string modeDefName;
+	std::string antDefName;
+	std::string antName;
+	VexSetup::SetupType type;
+	VexSetup setup;
+	VexMode mode;			// holds only the subbands found for this antenna
+	std::string log;		// messages, to be printed in order after all tasks complete
+	int nWarn;
+	bool failed;			// a fatal error was found; getModes() exits after printing log
+	int exitStatus;
+};
+
+class ModeSetupWork
+{
+public:
+	std::vector<ModeSetupTask> *tasks;
+	VexData *V;
+	Vex *v;
+	unsigned int nextTask;
+	pthread_mutex_t lock;
+};
+
+static void runModeSetupTask(ModeSetupTask &task, VexData *V, Vex *v)
+{
+	std::ostringstream log;
+	std::string format;
+	std::map<std::string,std::vector<unsigned int> > pcalMap;
+	std::vector<VexChannel> freqChannels;		// list of channels from relevant $FREQ section
+	const char *antDefName = task.antDefName.c_str();
+	const char *modeDefName = task.modeDefName.c_str();
+	VexSetup &setup = task.setup;
+	int nWarn = 0;
+
+	task.type = getSetupType(v, format, antDefName, modeDefName, log);
+
+	if(task.type == VexSetup::SetupIncomplete)
+	{
+		log << "Note: Incomplete description for " << antDefName << " in mode " << modeDefName << ". The vex file might need editing.  This antenna/mode will be ignored." << std::endl;
+	}
+	else
+	{
+		setup.type = task.type;
+
+		try
+		{
+			nWarn += collectIFInfo(setup, V, v, antDefName, modeDefName, log);
+			nWarn += collectFreqChannels(freqChannels, setup, task.mode, v, antDefName, modeDefName, log);
+			nWarn += collectPcalInfo(pcalMap, V, v, antDefName, modeDefName, log);
+			nWarn += collectExtensions(setup, v, antDefName, modeDefName, log);
+
+			switch(task.type)
+			{
+			case VexSetup::SetupTracks:
+				nWarn += getTracksSetup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format, log);
+				break;
+			case VexSetup::SetupBitstreams:
+				nWarn += getBitstreamsSetup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format, log);
+				break;
+			case VexSetup::SetupDatastreams:
+				nWarn += getDatastreamsSetup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format, log);
+				break;
+			case VexSetup::SetupS2:
+				nWarn += getS2Setup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format, log);
+				break;
+			default:
+				log << "Setup type " << VexSetup::setupTypeName[task.type] << " is not (yet) supported." << std::endl;
+				++nWarn;
+			}
+		}
+		catch(const ModeSetupFailure &failure)
+		{
+			task.failed = true;
+			task.exitStatus = failure.status;
+		}
+	}
+
+	task.nWarn = nWarn;
+	task.log = log.str();
+}
+
+static void *modeSetupWorker(void *arg)
+{
+	ModeSetupWork *work = static_cast<ModeSetupWork *>(arg);
+
+	for(;;)
+	{
+		unsigned int t;
+
+		pthread_mutex_lock(&work->lock);
+		t = work->nextTask++;
+		pthread_mutex_unlock(&work->lock);
+
+		if(t >= work->tasks->size())
+		{
+			break;
+		}
+		runModeSetupTask((*work->tasks)[t], work->V, work->v);
+	}
+
+	return 0;
+}
+
+static void runModeSetupTasks(std::vector<ModeSetupTask> &tasks, VexData *V, Vex *v)
+{
+	ModeSetupWork work;
+	std::vector<pthread_t> threads;
+	long nCPU;
+	unsigned int nThread;
+
+	work.tasks = &tasks;
+	work.V = V;
+	work.v = v;
+	work.nextTask = 0;
+	pthread_mutex_init(&work.lock, 0);
+
+	nCPU = sysconf(_SC_NPROCESSORS_ONLN);
+	nThread = (nCPU > 1) ? nCPU : 1;
+	if(nThread > tasks.size())
+	{
+		nThread = tasks.size();
+	}
+
+	// The calling thread is one of the workers
+	for(unsigned int i = 1; i < nThread; ++i)
+	{
+		pthread_t thread;
+
+		if(pthread_create(&thread, 0, modeSetupWorker, &work) != 0)
+		{
+			break;
+		}
+		threads.push_back(thread);
+	}
+	modeSetupWorker(&work);
+	for(std::vector<pthread_t>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		pthread_join(*it, 0);
+	}
+
+	pthread_mutex_destroy(&work.lock);
+}
+
 static int getModes(VexData *V, Vex *v)
 {
+	struct vex_cursor modeCursor;
+	std::vector<std::string> modeDefNames;
+	std::vector<ModeSetupTask> tasks;
+	std::vector<ModeSetupTask>::iterator t;
 	int nWarn = 0;
 
-	for(const char *modeDefName = get_mode_def(v); modeDefName; modeDefName = get_mode_def_next())
+	for(const char *modeDefName = get_mode_def_r(&modeCursor, v); modeDefName; modeDefName = get_mode_def_next_r(&modeCursor))
 	{
 		// don't bother building up modes that are not used
 		if(!V->usesMode(modeDefName))
@@ -2351,56 +2573,63 @@ static int getModes(VexData *V, Vex *v)
 			continue;
 		}
 
+		for(unsigned int a = 0; a < V->nAntenna(); ++a)
+		{
+			tasks.push_back(ModeSetupTask());
+			ModeSetupTask &task = tasks.back();
+			task.modeNum = modeDefNames.size();
+			task.modeDefName = modeDefName;
+			task.antDefName = V->getAntenna(a)->defName;
+			task.antName = V->getAntenna(a)->name;
+		}
+		modeDefNames.push_back(modeDefName);
+	}
+
+	// Each (mode, antenna) pair only reads the parse tree, so these can proceed in parallel
+	runModeSetupTasks(tasks, V, v);
+
+	// Merge in mode, then antenna order so that subband numbering and messages match a serial load
+	t = tasks.begin();
+	for(unsigned int m = 0; m < modeDefNames.size(); ++m)
+	{
 		VexMode &mode = *(V->newMode());
-		mode.defName = modeDefName;
+		mode.defName = modeDefNames[m];
 
-		for(unsigned int a = 0; a < V->nAntenna(); ++a)
+		for(; t != tasks.end() && t->modeNum == m; ++t)
 		{
-			std::string format;
-			const char *antDefName = V->getAntenna(a)->defName.c_str();
-			VexSetup::SetupType type;
-			std::map<std::string,std::vector<unsigned int> > pcalMap;
-			std::vector<VexChannel> freqChannels;		// list of channels from relevant $FREQ section
+			std::vector<int> subbandIds;
 
-			type = getSetupType(v, format, antDefName, modeDefName);
+			std::cerr << t->log;
+			nWarn += t->nWarn;
 
-			if(type == VexSetup::SetupIncomplete)
+			if(t->failed)
 			{
-				std::cerr << "Note: Incomplete description for " << antDefName << " in mode " << modeDefName << ". The vex file might need editing.  This antenna/mode will be ignored." << std::endl;
-				continue;
-			}
-
-			// if we made it this far the antenna is involved in this mode
-			VexSetup &setup = mode.setups[V->getAntenna(a)->name];	// This creates the new entry  FIXME: really this should be defName, not name...
+				std::cerr.flush();
 
-			setup.type = type;
+				exit(t->exitStatus);
+			}
 
-			nWarn += collectIFInfo(setup, V, v, antDefName, modeDefName);
-			nWarn += collectFreqChannels(freqChannels, setup, mode, v, antDefName, modeDefName);
-			nWarn += collectPcalInfo(pcalMap, V, v, antDefName, modeDefName);
-			nWarn += collectExtensions(setup, v, antDefName, modeDefName);
+			if(t->type == VexSetup::SetupIncomplete)
+			{
+				continue;
+			}
 
-			switch(type)
+			for(std::vector<VexSubband>::const_iterator sb = t->mode.subbands.begin(); sb != t->mode.subbands.end(); ++sb)
 			{
-			case VexSetup::SetupTracks:
-				nWarn += getTracksSetup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format);
-				break;
-			case VexSetup::SetupBitstreams:
-				nWarn += getBitstreamsSetup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format);
-				break;
-			case VexSetup::SetupDatastreams:
-				nWarn += getDatastreamsSetup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format);
-				break;
-			case VexSetup::SetupS2:
-				nWarn += getS2Setup(setup, v, antDefName, modeDefName, pcalMap, freqChannels, format);
-				break;
-			default:
-				std::cerr << "Setup type " << VexSetup::setupTypeName[type] << " is not (yet) supported." << std::endl;
-				++nWarn;
+				subbandIds.push_back(mode.addSubband(sb->freq, sb->bandwidth, sb->sideBand, sb->pol));
+			}
+			for(std::vector<VexChannel>::iterator ch = t->setup.channels.begin(); ch != t->setup.channels.end(); ++ch)
+			{
+				if(ch->subbandId >= 0)
+				{
+					ch->subbandId = subbandIds[ch->subbandId];
+				}
 			}
 
-		} // End of antenna loop
-	} // End of mode loop
+			// if we made it this far the antenna is involved in this mode
+			mode.setups[t->antName] = t->setup;	// FIXME: really this should be defName, not name...
+		}
+	}
 
 	return nWarn;
 }
@@ -2415,7 +2644,7 @@ static int getVSN(VexData *V, Vex *v, const char *station)
 
 	Upper(antName);
 
-	block = find_block(B_TAPELOG_OBS, v);
+	block = find_block_r(B_TAPELOG_OBS, v);
 
 	if(!block)
 	{
@@ -2428,7 +2657,7 @@ static int getVSN(VexData *V, Vex *v, const char *station)
 		return -2;
 	}
 
-	defs = find_def(defs, station);
+	defs = find_def_r(B_TAPELOG_OBS, station, v);
 	if(!defs)
 	{
 		return -3;
@@ -2485,9 +2714,10 @@ static int getVSN(VexData *V, Vex *v, const char *station)
 
 static int getVSNs(VexData *V, Vex *v)
 {
+	struct vex_cursor stationCursor;
 	int nWarn = 0;
 
-	for(char *stn = get_station_def(v); stn; stn=get_station_def_next())
+	for(char *stn = get_station_def_r(&stationCursor, v); stn; stn=get_station_def_next_r(&stationCursor))
 	{
 		getVSN(V, v, stn);
 	}
@@ -2501,7 +2731,7 @@ static int getEOPs(VexData *V, Vex *v)
 	int N = 0;
 	int nWarn = 0;
 
-	block = find_block(B_EOP, v);
+	block = find_block_r(B_EOP, v);
 
 	if(block)
 	{
@@ -2601,7 +2831,7 @@ static int getExper(VexData *V, Vex *v)
 		++nWarn;
 	}
 
-	block = find_block(B_EXPER, v);
+	block = find_block_r(B_EXPER, v);
 
 	if(!block)
 	{
@@ -2678,19 +2908,45 @@ static int getExper(VexData *V, Vex *v)
 }
 
 
-VexData *loadVexFile(const std::string &vexFile, unsigned int *numWarnings)
+VexData *loadVexFile(const std::string &vexFile, unsigned int *numWarnings, int verbose, bool writeSnapshot)
 {
 	VexData *V;
 	Vex *v;
+	struct vex_parse_stats stats;
 	int r;
 	int nWarn = 0;
+	uint64_t contentHash;
+	bool haveHash;
+	std::string snapshotFile = vexSnapshotFileName(vexFile);
+
+	// A snapshot made from identical vex file contents makes parsing unnecessary
+	haveHash = vexContentHash(vexFile, &contentHash);
+	if(haveHash)
+	{
+		V = readVexSnapshot(snapshotFile, contentHash);
+		if(V)
+		{
+			V->setDirectory(vexFile.substr(0, vexFile.find_last_of('/')));
+			if(verbose > 0)
+			{
+				std::cout << "Loaded vex data from snapshot " << snapshotFile << std::endl;
+			}
+
+			return V;
+		}
+	}
 
-	r = vex_open(vexFile.c_str(), &v);
+	r = vex_open_r(vexFile.c_str(), &v, &stats);
 	if(r != 0)
 	{
 		return 0;
 	}
 
+	if(verbose > 0)
+	{
+		std::cout << "Parsed " << stats.file_size << " bytes of vex" << (stats.mapped ? " in place" : "") << " in " << stats.parse_time << " s; tree " << stats.arena_size/1024 << " kB; peak RSS " << stats.peak_rss/1024 << " MB" << std::endl;
+	}
+
 	V = new VexData();
 
 	V->setDirectory(vexFile.substr(0, vexFile.find_last_of('/')));
@@ -2705,5 +2961,23 @@ VexData *loadVexFile(const std::string &vexFile, unsigned int *numWarnings)
 	nWarn += getEOPs(V, v);
 	*numWarnings = *numWarnings + nWarn;
 
+	vex_close(v);
+
+	// Files that produce warnings are not snapshotted so that the warnings are reported on every run
+	if(writeSnapshot && haveHash && nWarn == 0)
+	{
+		if(writeVexSnapshot(V, snapshotFile, contentHash))
+		{
+			if(verbose > 0)
+			{
+				std::cout << "Wrote vex data snapshot " << snapshotFile << std::endl;
+			}
+		}
+		else if(verbose > 0)
+		{
+			std::cout << "Note: could not write vex data snapshot " << snapshotFile << std::endl;
+		}
+	}
+
 	return V;
 }
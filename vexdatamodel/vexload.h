@@ -33,6 +33,8 @@
 #include <string>
 #include <vex_data.h>
 
-VexData *loadVexFile(const std::string &vexFile, unsigned int *numWarnings);
+// A valid snapshot of vexFile (see vex_snapshot.h) is always used in place of parsing,
+// but a new one is only written when writeSnapshot is set
+VexData *loadVexFile(const std::string &vexFile, unsigned int *numWarnings, int verbose = 0, bool writeSnapshot = false);
 
 #endif